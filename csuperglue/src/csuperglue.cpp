@@ -103,6 +103,13 @@ extern "C" void sg_submit_task(sg_task_t task_) {
     superglue->submit(task);
 }
 
+extern "C" void sg_submit_tasks(sg_task_t *tasks, size_t num) {
+    std::vector<TaskBase<Options> *> batch(num);
+    for (size_t i = 0; i < num; ++i)
+        batch[i] = (CTask *) tasks[i];
+    superglue->submit_batch(batch.begin(), batch.end());
+}
+
 extern "C" void sg_submit(sg_task_function function, void *args, size_t argsize, const char *name, ...) {
     va_list deps;
     CTask *task(new CTask(function, args, argsize, name));
@@ -34,6 +34,10 @@ void sg_register_access(sg_task_t task, enum sg_access_type type, sg_handle_t ha
 /* Submit a task to SuperGlue. SuperGlue takes ownership of the task. */
 void sg_submit_task(sg_task_t task);
 
+/* Submit an array of tasks to SuperGlue, in order. SuperGlue takes ownership of the tasks.
+   Cheaper than calling sg_submit_task() for each task. */
+void sg_submit_tasks(sg_task_t *tasks, size_t num);
+
 /* Create and submit a task to SuperGlue.
      function -- function with signature "void my_function(void *args)"
      args     -- user-defined arguments to be passed to the function
@@ -0,0 +1,85 @@
+#include "sg/superglue.hpp"
+#include "sg/option/barrier_tree.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+// ==========================================================================
+// Barrier latency against number of threads:
+//
+//   central: all workers count down one shared counter (default)
+//   tree:    workers count down a combining tree of counters (BarrierCounterTree)
+//
+// empty: sg.barrier() with no tasks
+// step:  one small task per thread, then sg.barrier(), as in a time-stepping
+//        loop
+//
+// usage: barrierlatency [max_threads] [num_rounds]
+// ==========================================================================
+
+struct OpCentral : public DefaultOptions<OpCentral> {
+    typedef AllowedCpusThreadAffinity<OpCentral> ThreadAffinity;
+};
+struct OpTree : public DefaultOptions<OpTree> {
+    typedef BarrierCounterTree<OpTree> BarrierCounter;
+    typedef AllowedCpusThreadAffinity<OpTree> ThreadAffinity;
+};
+
+size_t num_rounds = 2000;
+
+template<typename Options>
+struct StepTask : public Task<Options, 1> {
+    double *value;
+    StepTask(Handle<Options> &h, double *value_) : value(value_) {
+        this->register_access(ReadWriteAdd::write, h);
+    }
+    void run() { *value = *value * 0.5 + 1.0; }
+};
+
+template<typename Options>
+static void benchmark(const char *name, int num_threads) {
+    SuperGlue<Options> sg(num_threads);
+    Handle<Options> *h = new Handle<Options>[num_threads];
+    double *values = new double[num_threads];
+    for (int i = 0; i < num_threads; ++i)
+        values[i] = 0.0;
+
+    sg.barrier(); // warm up
+
+    const Time::TimeUnit start = Time::getTime();
+    for (size_t round = 0; round < num_rounds; ++round)
+        sg.barrier();
+    const Time::TimeUnit empty = Time::getTime();
+    for (size_t round = 0; round < num_rounds; ++round) {
+        for (int i = 0; i < num_threads; ++i)
+            sg.submit(new StepTask<Options>(h[i], &values[i]));
+        sg.barrier();
+    }
+    const Time::TimeUnit stop = Time::getTime();
+
+    printf("%-8s threads=%3d  empty %9.1f ticks/barrier  step %9.1f ticks/barrier\n",
+           name, sg.get_num_cpus(),
+           static_cast<double>(empty - start) / static_cast<double>(num_rounds),
+           static_cast<double>(stop - empty) / static_cast<double>(num_rounds));
+
+    fflush(stdout);
+
+    delete [] h;
+    delete [] values;
+}
+
+int main(int argc, char *argv[]) {
+    int max_threads = 8;
+    if (argc >= 2)
+        max_threads = atoi(argv[1]);
+    if (argc >= 3)
+        num_rounds = (size_t) atoi(argv[2]);
+
+    for (int num_threads = 2; num_threads <= max_threads; num_threads *= 2) {
+        benchmark<OpCentral>("central", num_threads);
+        benchmark<OpTree>("tree", num_threads);
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+
+// ==========================================================================
+// Compares the engines that decide when a task is ready:
+//
+//   scan:     a task waits for one version at a time (default)
+//   counting: a task waits for all versions at once (DependencyCounting)
+//   ring:     as counting, with lock-free version queues (LockFreeVersionQueue)
+//
+// fan-in:  Each round writes WIDTH handles in separate tasks, followed by one
+//          task that reads all of them.
+// fan-out: Each round writes one handle, followed by WIDTH tasks that read it.
+//
+// Tasks are submitted before execution starts, so every reading task has to
+// wait for its inputs.
+// ==========================================================================
+
+struct OpScan : public DefaultOptions<OpScan> {
+    typedef Enable PauseExecution;
+};
+struct OpCounting : public DefaultOptions<OpCounting> {
+    typedef Enable PauseExecution;
+    typedef Enable DependencyCounting;
+};
+struct OpRing : public DefaultOptions<OpRing> {
+    typedef Enable PauseExecution;
+    typedef Enable DependencyCounting;
+    typedef Enable LockFreeVersionQueue;
+};
+
+const size_t WIDTH = 64;
+const size_t NUM_ROUNDS = 2000;
+
+template<typename Options>
+struct WriteTask : public Task<Options, 1> {
+    WriteTask(Handle<Options> &h) {
+        this->register_access(ReadWriteAdd::write, h);
+    }
+    void run() {}
+};
+
+template<typename Options>
+struct ReadAllTask : public Task<Options> {
+    ReadAllTask(Handle<Options> *h) {
+        for (size_t i = 0; i < WIDTH; ++i)
+            this->register_access(ReadWriteAdd::read, h[i]);
+    }
+    void run() {}
+};
+
+template<typename Options>
+struct ReadTask : public Task<Options, 1> {
+    ReadTask(Handle<Options> &h) {
+        this->register_access(ReadWriteAdd::read, h);
+    }
+    void run() {}
+};
+
+template<typename Options>
+static void benchmark(const char *name, bool fan_in) {
+    SuperGlue<Options> sg;
+    Handle<Options> h[WIDTH];
+
+    const Time::TimeUnit start = Time::getTime();
+    for (size_t round = 0; round < NUM_ROUNDS; ++round) {
+        if (fan_in) {
+            for (size_t i = 0; i < WIDTH; ++i)
+                sg.submit(new WriteTask<Options>(h[i]));
+            sg.submit(new ReadAllTask<Options>(h));
+        }
+        else {
+            sg.submit(new WriteTask<Options>(h[0]));
+            for (size_t i = 0; i < WIDTH; ++i)
+                sg.submit(new ReadTask<Options>(h[0]));
+        }
+    }
+    const Time::TimeUnit submitted = Time::getTime();
+    sg.start_executing();
+    sg.barrier();
+    const Time::TimeUnit stop = Time::getTime();
+
+    const double num_tasks = static_cast<double>(NUM_ROUNDS * (WIDTH + 1));
+    printf("%-8s %-9s submit %6.1f ticks/task  execute %6.1f ticks/task\n", fan_in ? "fan-in" : "fan-out", name,
+           static_cast<double>(submitted - start) / num_tasks,
+           static_cast<double>(stop - submitted) / num_tasks);
+}
+
+int main() {
+    benchmark<OpScan>("scan", true);
+    benchmark<OpCounting>("counting", true);
+    benchmark<OpRing>("ring", true);
+    benchmark<OpScan>("scan", false);
+    benchmark<OpCounting>("counting", false);
+    benchmark<OpRing>("ring", false);
+    return 0;
+}
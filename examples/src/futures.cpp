@@ -0,0 +1,103 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+
+// ==========================================================================
+// Pipelines of small transformations, written two ways:
+//
+//   handles: each step writes a user-defined handle with data, and the
+//            result is read after wait() on the last handle
+//   futures: each step is a continuation, and the result is read with get()
+//
+// The futures need no handle objects kept alive by the user, and no tasks
+// to delete them.
+// ==========================================================================
+
+template<typename Options>
+struct DataHandle : public HandleBase<Options> {
+    double data;
+    DataHandle() : data(0.0) {}
+};
+
+struct Options : public DefaultOptions<Options> {
+    typedef DataHandle<Options> HandleType;
+};
+
+const size_t NUM_PIPELINES = 100;
+const size_t NUM_STEPS = 100;
+
+struct Start {
+    typedef double result_type;
+    double operator()() const { return 1.0; }
+};
+
+struct Step {
+    typedef double result_type;
+    double operator()(const double &x) const { return x * 0.5 + 1.0; }
+};
+
+struct StepTask : public Task<Options, 2> {
+    Handle<Options> &in, &out;
+    StepTask(Handle<Options> &in_, Handle<Options> &out_) : in(in_), out(out_) {
+        register_access(ReadWriteAdd::read, in);
+        register_access(ReadWriteAdd::write, out);
+    }
+    void run() { out.data = Step()(in.data); }
+};
+
+struct StartTask : public Task<Options, 1> {
+    Handle<Options> &out;
+    StartTask(Handle<Options> &out_) : out(out_) {
+        register_access(ReadWriteAdd::write, out);
+    }
+    void run() { out.data = Start()(); }
+};
+
+int main() {
+    SuperGlue<Options> sg;
+
+    // handles
+    const Time::TimeUnit start_handles = Time::getTime();
+    double sum_handles = 0.0;
+    {
+        Handle<Options> *h = new Handle<Options>[NUM_PIPELINES * (NUM_STEPS+1)];
+        for (size_t p = 0; p < NUM_PIPELINES; ++p) {
+            Handle<Options> *pipeline = &h[p * (NUM_STEPS+1)];
+            sg.submit(new StartTask(pipeline[0]));
+            for (size_t i = 0; i < NUM_STEPS; ++i)
+                sg.submit(new StepTask(pipeline[i], pipeline[i+1]));
+        }
+        for (size_t p = 0; p < NUM_PIPELINES; ++p) {
+            Handle<Options> &last = h[p * (NUM_STEPS+1) + NUM_STEPS];
+            sg.wait(last);
+            sum_handles += last.data;
+        }
+        sg.barrier(); // the tasks may still read the handles
+        delete [] h;
+    }
+    const Time::TimeUnit stop_handles = Time::getTime();
+
+    // futures
+    const Time::TimeUnit start_futures = Time::getTime();
+    double sum_futures = 0.0;
+    {
+        Future<Options, double> *results = new Future<Options, double>[NUM_PIPELINES];
+        for (size_t p = 0; p < NUM_PIPELINES; ++p) {
+            Future<Options, double> f(submit_future(sg, Start()));
+            for (size_t i = 0; i < NUM_STEPS; ++i)
+                f = f.then(Step());
+            results[p] = f;
+        }
+        for (size_t p = 0; p < NUM_PIPELINES; ++p)
+            sum_futures += results[p].get();
+        delete [] results;
+    }
+    const Time::TimeUnit stop_futures = Time::getTime();
+
+    printf("handles: %12llu ticks  result %f\n",
+           static_cast<unsigned long long>(stop_handles - start_handles), sum_handles);
+    printf("futures: %12llu ticks  result %f\n",
+           static_cast<unsigned long long>(stop_futures - start_futures), sum_futures);
+    return 0;
+}
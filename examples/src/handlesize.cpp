@@ -0,0 +1,55 @@
+#include "sg/superglue.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// ==========================================================================
+// Reports the memory used per handle, with the default handle layout and
+// with Options::CompactHandle enabled.
+//
+// Heap usage is measured by counting the bytes passed to operator new and
+// operator new[].
+// ==========================================================================
+
+static size_t heap_bytes = 0;
+
+static void *counted_malloc(size_t size) {
+    heap_bytes += size;
+    void *p = std::malloc(size);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new(size_t size) { return counted_malloc(size); }
+void *operator new[](size_t size) { return counted_malloc(size); }
+void operator delete(void *p) throw() { std::free(p); }
+void operator delete(void *p, size_t) throw() { std::free(p); }
+void operator delete[](void *p) throw() { std::free(p); }
+void operator delete[](void *p, size_t) throw() { std::free(p); }
+
+struct OpDefault : public DefaultOptions<OpDefault> {};
+struct OpCompact : public DefaultOptions<OpCompact> {
+    typedef Enable CompactHandle;
+};
+
+const size_t NUM_HANDLES = 100000;
+
+template<typename Options>
+static void report(const char *name) {
+    const size_t heap_before = heap_bytes;
+    Handle<Options> *h = new Handle<Options>[NUM_HANDLES];
+    const size_t heap_handles = heap_bytes - heap_before;
+    delete [] h;
+
+    printf("%-10s sizeof(Handle)=%4d  total per handle=%4d bytes\n", name,
+           static_cast<int>(sizeof(Handle<Options>)),
+           static_cast<int>(heap_handles / NUM_HANDLES));
+}
+
+int main() {
+    report<OpDefault>("default");
+    report<OpCompact>("compact");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+// ==========================================================================
+// Throughput of commutative add-tasks that lock overlapping sets of handles:
+//
+//   registration: locks are taken in the order accesses were registered
+//   ordered:      locks are taken in order of handle address (OrderedLocking)
+//   handoff:      as registration, released locks go to one waiter (LockHandoff)
+//   ordered+h:    both
+//
+// Each task adds to NUM_LOCKS of NUM_HANDLES handles, picked at random and
+// registered in random order, so the overlap between tasks is high. Tasks
+// are submitted before execution starts.
+//
+// usage: lockorder [num_threads]
+// ==========================================================================
+
+template<typename Op>
+struct OpBase : public DefaultOptions<Op> {
+    typedef typename DefaultOptions<Op>::Enable Enable;
+    typedef Enable PauseExecution;
+    typedef AllowedCpusThreadAffinity<Op> ThreadAffinity;
+};
+struct OpRegistration : public OpBase<OpRegistration> {};
+struct OpOrdered : public OpBase<OpOrdered> {
+    typedef Enable OrderedLocking;
+};
+struct OpHandoff : public OpBase<OpHandoff> {
+    typedef Enable LockHandoff;
+};
+struct OpOrderedHandoff : public OpBase<OpOrderedHandoff> {
+    typedef Enable OrderedLocking;
+    typedef Enable LockHandoff;
+};
+
+const size_t NUM_HANDLES = 8;
+const size_t NUM_LOCKS = 3;
+const size_t NUM_TASKS = 20000;
+const Time::TimeUnit WORK = 2000; // ticks per task
+
+template<typename Options>
+struct AddTask : public Task<Options, NUM_LOCKS> {
+    size_t *value[NUM_LOCKS];
+
+    AddTask(Handle<Options> *h, size_t *values, const size_t *idx) {
+        for (size_t i = 0; i < NUM_LOCKS; ++i) {
+            this->register_access(ReadWriteAdd::add, h[idx[i]]);
+            value[i] = &values[idx[i]];
+        }
+    }
+    void run() {
+        const Time::TimeUnit stop = Time::getTime() + WORK;
+        while (Time::getTime() < stop)
+            Atomic::rep_nop();
+        for (size_t i = 0; i < NUM_LOCKS; ++i)
+            *value[i] += 1;
+    }
+};
+
+// NUM_LOCKS different handles in random order
+static void pick_handles(size_t *idx) {
+    for (size_t i = 0; i < NUM_LOCKS; ++i) {
+        for (;;) {
+            idx[i] = static_cast<size_t>(rand()) % NUM_HANDLES;
+            size_t j = 0;
+            while (j < i && idx[j] != idx[i])
+                ++j;
+            if (j == i)
+                break;
+        }
+    }
+}
+
+template<typename Options>
+static void benchmark(const char *name, int num_threads) {
+    SuperGlue<Options> sg(num_threads);
+    Handle<Options> h[NUM_HANDLES];
+    size_t values[NUM_HANDLES] = {0};
+
+    srand(0);
+    for (size_t i = 0; i < NUM_TASKS; ++i) {
+        size_t idx[NUM_LOCKS];
+        pick_handles(idx);
+        sg.submit(new AddTask<Options>(h, values, idx));
+    }
+
+    const Time::TimeUnit start = Time::getTime();
+    sg.start_executing();
+    sg.barrier();
+    const Time::TimeUnit stop = Time::getTime();
+
+    size_t sum = 0;
+    for (size_t i = 0; i < NUM_HANDLES; ++i)
+        sum += values[i];
+
+    printf("%-13s #cores=%d  %8.1f ticks/task%s\n", name, sg.get_num_cpus(),
+           static_cast<double>(stop - start) / static_cast<double>(NUM_TASKS),
+           sum == NUM_TASKS * NUM_LOCKS ? "" : "  ### wrong result");
+}
+
+int main(int argc, char *argv[]) {
+    int num_threads = 4;
+    if (argc >= 2)
+        num_threads = atoi(argv[1]);
+
+    benchmark<OpRegistration>("registration", num_threads);
+    benchmark<OpOrdered>("ordered", num_threads);
+    benchmark<OpHandoff>("handoff", num_threads);
+    benchmark<OpOrderedHandoff>("ordered+h", num_threads);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+#include "sg/platform/threads.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// ==========================================================================
+// Several threads submit tasks that access the same few handles.
+//
+// First compares scheduling accesses on a shared handle with the spinlock
+// based SchedulerVersionLocked and the lock-free SchedulerVersionLockFree
+// (used by default for ReadWriteAdd), then measures the submission of
+// complete tasks from all threads.
+//
+// Usage: multisubmit [number of submitting threads]
+// ==========================================================================
+
+struct Options : public DefaultOptions<Options> {};
+
+const size_t NUM_ACCESSES = 1000000;
+const size_t NUM_TASKS = 100000;
+const size_t NUM_HANDLES = 4;
+
+template<typename Scheduler>
+struct ScheduleThread : public Thread {
+    Scheduler &s;
+    ScheduleThread(Scheduler &s_) : s(s_) {}
+    void run() {
+        for (size_t i = 0; i < NUM_ACCESSES; ++i)
+            s.schedule(i % 8 == 0 ? ReadWriteAdd::write : ReadWriteAdd::read);
+    }
+};
+
+struct MyTask : public Task<Options, 2> {
+    MyTask(Handle<Options> &a, Handle<Options> &b) {
+        register_access(ReadWriteAdd::read, a);
+        register_access(ReadWriteAdd::add, b);
+    }
+    void run() {}
+};
+
+struct SubmitThread : public Thread {
+    SuperGlue<Options> &sg;
+    Handle<Options> *h;
+    SubmitThread(SuperGlue<Options> &sg_, Handle<Options> *h_) : sg(sg_), h(h_) {}
+    void run() {
+        for (size_t i = 0; i < NUM_TASKS; ++i)
+            sg.submit(new MyTask(h[i % NUM_HANDLES], h[(i+1) % NUM_HANDLES]));
+    }
+};
+
+template<typename T>
+static Time::TimeUnit run_threads(std::vector<T *> &threads) {
+    const Time::TimeUnit start = Time::getTime();
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i]->start();
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i]->join();
+    const Time::TimeUnit stop = Time::getTime();
+    for (size_t i = 0; i < threads.size(); ++i)
+        delete threads[i];
+    return stop - start;
+}
+
+template<typename Scheduler>
+static void benchmark_schedule(const char *name, size_t num_threads) {
+    Scheduler s;
+    std::vector<ScheduleThread<Scheduler> *> threads;
+    for (size_t i = 0; i < num_threads; ++i)
+        threads.push_back(new ScheduleThread<Scheduler>(s));
+    const Time::TimeUnit time = run_threads(threads);
+    printf("%-26s %6.1f ticks/access\n", name,
+           static_cast<double>(time) / static_cast<double>(NUM_ACCESSES * num_threads));
+}
+
+int main(int argc, char *argv[]) {
+    const size_t num_threads = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 4;
+    printf("%d submitting threads\n", static_cast<int>(num_threads));
+
+    benchmark_schedule< detail::SchedulerVersionLocked<Options> >("SchedulerVersionLocked", num_threads);
+    benchmark_schedule< detail::SchedulerVersionLockFree<Options> >("SchedulerVersionLockFree", num_threads);
+
+    SuperGlue<Options> sg;
+    Handle<Options> h[NUM_HANDLES];
+    std::vector<SubmitThread *> threads;
+    for (size_t i = 0; i < num_threads; ++i)
+        threads.push_back(new SubmitThread(sg, h));
+    const Time::TimeUnit time = run_threads(threads);
+    sg.barrier();
+    printf("%-26s %6.1f ticks/task\n", "submit",
+           static_cast<double>(time) / static_cast<double>(NUM_TASKS * num_threads));
+    return 0;
+}
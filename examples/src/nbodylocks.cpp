@@ -0,0 +1,265 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+// ==========================================================================
+// Lock contention benchmark, based on nbody.cpp
+//
+// The force evaluation tasks add to the forces of two blocks of particles.
+// Without contributions, each such add-access locks the handle of its block,
+// and with small blocks many tasks wait for the same locks.
+//
+//   wake-all: a released lock wakes every task waiting for it, and all but
+//             one of them fail to lock and are queued again (default)
+//   handoff:  a released lock is taken on behalf of the first waiting task,
+//             which is the only one woken (LockHandoff)
+// ==========================================================================
+
+struct OpWakeAll : public DefaultOptions<OpWakeAll> {
+    typedef AllowedCpusThreadAffinity<OpWakeAll> ThreadAffinity;
+};
+struct OpHandoff : public DefaultOptions<OpHandoff> {
+    typedef AllowedCpusThreadAffinity<OpHandoff> ThreadAffinity;
+    typedef Enable LockHandoff;
+};
+
+struct vector_type {
+    double x[3];
+};
+
+struct particle_type {
+    double x[3];
+    double dx[3];
+};
+
+const double dt = 0.01;
+const double EPSILON = 1.0;
+const double SIGMA = 1.0;
+const double LJ_CONST_A = -24.0*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*EPSILON;
+const double LJ_CONST_B = -48.0*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*SIGMA*EPSILON;
+
+//======================================================
+// "kernels"
+//======================================================
+
+inline static void eval_force_tk(particle_type *p0, particle_type *p1, vector_type *force) {
+    const double dx = p0->x[0] - p1->x[0];
+    const double dy = p0->x[1] - p1->x[1];
+    const double dz = p0->x[2] - p1->x[2];
+    const double r2 = dx*dx + dy*dy + dz*dz;
+    const double r4 = r2 * r2;
+    const double r8 = r4 * r4;
+    const double r14 = r8 * r4 * r2;
+    const double c = LJ_CONST_A / r8 - LJ_CONST_B / r14;
+    force->x[0] = c * dx;
+    force->x[1] = c * dy;
+    force->x[2] = c * dz;
+}
+
+inline static void init_particle_tk(particle_type *p, int i, int num_particles) {
+    int s = (int) pow(num_particles, 1.0/3.0);
+    int px = i/(s*s);
+    int py = (i-px*s*s)/s;
+    int pz = (i-px*s*s-py*s);
+
+    const double magnitude = 1.0;
+    const double distance = 1.0 * SIGMA;
+    const double theta = rand() * 6.28318531 / RAND_MAX;
+    p->dx[0] = sin(theta) * magnitude;
+    p->dx[1] = cos(theta) * magnitude;
+    p->dx[2] = 0.0;
+    p->x[0] = px * distance;
+    p->x[1] = py * distance;
+    p->x[2] = pz * distance;
+}
+
+inline static void step_tk(particle_type *p, vector_type *a) {
+    const double c1 = 0.5 * dt;
+    const double c2 = c1 * dt;
+
+    for (int k = 0; k < 3; ++k) {
+        p->dx[k] += c1 * a->x[k];
+        p->x[k] += dt * p->dx[k] + c2 * a->x[k];
+        p->dx[k] += c1 * a->x[k];
+        a->x[k] = 0.0;
+    }
+}
+
+static void eval_between(particle_type *p0, particle_type *p1,
+                         vector_type *f0, vector_type *f1, size_t bsz0, size_t bsz1) {
+    for (size_t i = 0; i < bsz0; ++i) {
+        for (size_t j = 0; j < bsz1; ++j) {
+            vector_type f;
+            eval_force_tk(&p0[i], &p1[j], &f);
+            for (int k = 0; k < 3; ++k) {
+                f0[i].x[k] += f.x[k];
+                f1[j].x[k] -= f.x[k];
+            }
+        }
+    }
+}
+
+static void eval_within(particle_type *p, vector_type *f, size_t bsz) {
+    for (size_t i = 0; i < bsz; ++i)
+        eval_between(&p[i], &p[i+1], &f[i], &f[i+1], 1, bsz-i-1);
+}
+
+//======================================================
+// "task classes"
+//======================================================
+
+template<typename Options>
+class EvalWithinTask : public Task<Options, 2> {
+    particle_type *p0;
+    vector_type *f0;
+    size_t bsz;
+public:
+    EvalWithinTask(particle_type *p0_, Handle<Options> &hp0,
+                   vector_type *f0_, Handle<Options> &hf0, size_t bsz_)
+    : p0(p0_), f0(f0_), bsz(bsz_) {
+        this->register_access(ReadWriteAdd::read, hp0);
+        this->register_access(ReadWriteAdd::add, hf0);
+    }
+    void run() { eval_within(p0, f0, bsz); }
+};
+
+template<typename Options>
+class EvalBetweenTask : public Task<Options, 4> {
+    particle_type *p0, *p1;
+    vector_type *f0, *f1;
+    size_t bsz;
+public:
+    EvalBetweenTask(particle_type *p0_, Handle<Options> &hp0,
+                    particle_type *p1_, Handle<Options> &hp1,
+                    vector_type *f0_, Handle<Options> &hf0,
+                    vector_type *f1_, Handle<Options> &hf1, size_t bsz_)
+    : p0(p0_), p1(p1_), f0(f0_), f1(f1_), bsz(bsz_) {
+        this->register_access(ReadWriteAdd::read, hp0);
+        this->register_access(ReadWriteAdd::read, hp1);
+        this->register_access(ReadWriteAdd::add, hf0);
+        this->register_access(ReadWriteAdd::add, hf1);
+    }
+    void run() { eval_between(p0, p1, f0, f1, bsz, bsz); }
+};
+
+template<typename Options>
+class TimeStepTask : public Task<Options, 2> {
+    particle_type *p0;
+    vector_type *f0;
+    size_t bsz;
+public:
+    TimeStepTask(particle_type *p0_, Handle<Options> &hp0,
+                 vector_type *f0_, Handle<Options> &hf0, size_t bsz_)
+    : p0(p0_), f0(f0_), bsz(bsz_) {
+        this->register_access(ReadWriteAdd::read, hf0);
+        this->register_access(ReadWriteAdd::write, hp0);
+    }
+    void run() {
+        for (size_t i = 0; i < bsz; ++i)
+            step_tk(&p0[i], &f0[i]);
+    }
+};
+
+//======================================================
+// run simulation and measure time
+//======================================================
+
+void init(particle_type *particles, vector_type *forces, const size_t num_particles) {
+    srand(0);
+    for (size_t i = 0; i < num_particles; ++i) {
+        init_particle_tk(&particles[i], (int) i, (int) num_particles);
+        forces[i].x[0] = forces[i].x[1] = forces[i].x[2] = 0.0;
+    }
+}
+
+template<typename Options>
+void benchmark(const char *name, particle_type *particles, vector_type *forces,
+               const size_t num_particles, const size_t block_size,
+               const size_t num_steps, const int num_threads) {
+
+    init(particles, forces, num_particles);
+
+    const size_t num_blocks = num_particles/block_size;
+    Handle<Options> *part = new Handle<Options>[num_blocks];
+    Handle<Options> *forc = new Handle<Options>[num_blocks];
+
+    SuperGlue<Options> sg(num_threads);
+    Time::TimeUnit time_start = Time::getTime();
+    for (size_t s = 0; s < num_steps; ++s) {
+        for (size_t i = 0; i < num_blocks; ++i)
+            sg.submit(new EvalWithinTask<Options>(&particles[i*block_size], part[i],
+                                                  &forces[i*block_size], forc[i], block_size));
+        for (size_t i = 0; i < num_blocks; ++i)
+            for (size_t j = i + 1; j < num_blocks; ++j)
+                sg.submit(new EvalBetweenTask<Options>(&particles[i*block_size], part[i],
+                                                       &particles[j*block_size], part[j],
+                                                       &forces[i*block_size], forc[i],
+                                                       &forces[j*block_size], forc[j],
+                                                       block_size));
+        for (size_t i = 0; i < num_blocks; ++i)
+            sg.submit(new TimeStepTask<Options>(&particles[i*block_size], part[i],
+                                                &forces[i*block_size], forc[i], block_size));
+    }
+    sg.barrier();
+    Time::TimeUnit time_stop = Time::getTime();
+
+    const size_t num_tasks = num_steps * (num_blocks * (num_blocks + 3) / 2);
+    cout << name
+         << ": #cores=" << sg.get_num_cpus()
+         << " #particles=" << num_particles
+         << " blocksize=" << block_size
+         << " time=" << time_stop-time_start << " cycles"
+         << " (" << (time_stop-time_start)/num_tasks << " per task)"
+         << endl;
+
+    delete [] part;
+    delete [] forc;
+}
+
+// largest distance between particles in two solutions
+double compare(particle_type *p0, particle_type *p1, const size_t num_particles) {
+    double max_d2 = 0.0;
+    for (size_t i = 0; i < num_particles; ++i) {
+        double d2 = 0.0;
+        for (int k = 0; k < 3; ++k)
+            d2 += (p0[i].x[k] - p1[i].x[k]) * (p0[i].x[k] - p1[i].x[k]);
+        if (d2 > max_d2)
+            max_d2 = d2;
+    }
+    return sqrt(max_d2);
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t num_particles = 4096, block_size = 32, num_steps = 4;
+    int num_threads = -1;
+    if (argc >= 4) {
+        num_particles = (size_t) atoi(argv[1]);
+        block_size = (size_t) atoi(argv[2]);
+        num_steps = (size_t) atoi(argv[3]);
+    }
+    if (argc >= 5)
+        num_threads = atoi(argv[4]);
+
+    particle_type *particles = new particle_type[num_particles];
+    particle_type *particles2 = new particle_type[num_particles];
+    vector_type *forces = new vector_type[num_particles];
+
+    benchmark<OpWakeAll>("wake-all", particles, forces, num_particles, block_size, num_steps, num_threads);
+    benchmark<OpHandoff>("handoff ", particles2, forces, num_particles, block_size, num_steps, num_threads);
+
+    // the order of additions differ, so only approximately equal
+    if (compare(particles, particles2, num_particles) > 1e-3)
+        cerr << "### results differ" << endl;
+
+    delete [] particles;
+    delete [] particles2;
+    delete [] forces;
+    return 0;
+}
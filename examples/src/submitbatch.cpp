@@ -0,0 +1,75 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+#include <vector>
+
+// ==========================================================================
+// Compares the cost of submitting tasks one at a time with submit_batch(),
+// for independent tasks and for tasks with dependencies. Tasks do not run
+// until start_executing(), so only the submission is measured.
+// ==========================================================================
+
+struct Options : public DefaultOptions<Options> {
+    typedef Enable PauseExecution;
+};
+
+const size_t NUM_TASKS = 100000;
+const size_t NUM_HANDLES = 64;
+
+struct EmptyTask : public Task<Options, 0> {
+    void run() {}
+};
+
+struct DepTask : public Task<Options, 2> {
+    DepTask(Handle<Options> &a, Handle<Options> &b) {
+        register_access(ReadWriteAdd::read, a);
+        register_access(ReadWriteAdd::write, b);
+    }
+    void run() {}
+};
+
+static void create_tasks(std::vector<TaskBase<Options> *> &tasks, Handle<Options> *h, bool deps) {
+    tasks.resize(NUM_TASKS);
+    for (size_t i = 0; i < NUM_TASKS; ++i) {
+        if (deps)
+            tasks[i] = new DepTask(h[(i*7) % NUM_HANDLES], h[i % NUM_HANDLES]);
+        else
+            tasks[i] = new EmptyTask();
+    }
+}
+
+static void benchmark(const char *name, bool deps) {
+    Handle<Options> h[NUM_HANDLES];
+    std::vector<TaskBase<Options> *> tasks;
+    Time::TimeUnit single, batch;
+
+    {
+        SuperGlue<Options> sg;
+        create_tasks(tasks, h, deps);
+        const Time::TimeUnit start = Time::getTime();
+        for (size_t i = 0; i < NUM_TASKS; ++i)
+            sg.submit(tasks[i]);
+        single = Time::getTime() - start;
+        sg.start_executing();
+        sg.barrier();
+    }
+    {
+        SuperGlue<Options> sg;
+        create_tasks(tasks, h, deps);
+        const Time::TimeUnit start = Time::getTime();
+        sg.submit_batch(tasks.begin(), tasks.end());
+        batch = Time::getTime() - start;
+        sg.start_executing();
+        sg.barrier();
+    }
+
+    printf("%-14s submit %7.1f ticks/task   submit_batch %7.1f ticks/task\n", name,
+           static_cast<double>(single) / NUM_TASKS, static_cast<double>(batch) / NUM_TASKS);
+}
+
+int main() {
+    benchmark("independent", false);
+    benchmark("dependencies", true);
+    return 0;
+}
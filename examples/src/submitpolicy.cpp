@@ -0,0 +1,79 @@
+#include "sg/superglue.hpp"
+#include "sg/option/submit_policy.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+
+// ==========================================================================
+// Compares the submit policies on a recursive workload, where tasks spawn
+// tasks, and on a flat workload, where the main thread submits all tasks.
+// Reports time in millions of Time::getTime() ticks.
+// ==========================================================================
+
+struct OpRoundRobin : public DefaultOptions<OpRoundRobin> {};
+struct OpThreadLocal : public DefaultOptions<OpThreadLocal> {
+    typedef SubmitRoundRobinThreadLocal<OpThreadLocal> SubmitPolicy;
+};
+struct OpLocal : public DefaultOptions<OpLocal> {
+    typedef SubmitLocal<OpLocal> SubmitPolicy;
+};
+struct OpLeastLoaded : public DefaultOptions<OpLeastLoaded> {
+    typedef SubmitLeastLoaded<OpLeastLoaded> SubmitPolicy;
+};
+
+const int TREE_DEPTH = 16;
+const int NUM_FLAT_TASKS = 1 << TREE_DEPTH;
+const Time::TimeUnit WORK = 2000;
+
+static void work() {
+    Time::TimeUnit end = Time::getTime() + WORK;
+    while (Time::getTime() < end);
+}
+
+template<typename Options>
+struct SpawnTask : public Task<Options, 0> {
+    SuperGlue<Options> &sg;
+    int depth;
+
+    SpawnTask(SuperGlue<Options> &sg_, int depth_) : sg(sg_), depth(depth_) {}
+
+    void run() {
+        if (depth == 0) {
+            work();
+            return;
+        }
+        sg.submit(new SpawnTask(sg, depth-1));
+        sg.submit(new SpawnTask(sg, depth-1));
+    }
+};
+
+template<typename Options>
+struct WorkTask : public Task<Options, 0> {
+    void run() { work(); }
+};
+
+template<typename Options>
+void benchmark(const char *name) {
+    SuperGlue<Options> sg;
+
+    Time::TimeUnit start = Time::getTime();
+    sg.submit(new SpawnTask<Options>(sg, TREE_DEPTH));
+    sg.barrier();
+    const Time::TimeUnit recursive = Time::getTime() - start;
+
+    start = Time::getTime();
+    for (int i = 0; i < NUM_FLAT_TASKS; ++i)
+        sg.submit(new WorkTask<Options>());
+    sg.barrier();
+    const Time::TimeUnit flat = Time::getTime() - start;
+
+    printf("%-28s recursive %8.1f   flat %8.1f\n", name, recursive / 1e6, flat / 1e6);
+}
+
+int main() {
+    benchmark<OpRoundRobin>("SubmitRoundRobin");
+    benchmark<OpThreadLocal>("SubmitRoundRobinThreadLocal");
+    benchmark<OpLocal>("SubmitLocal");
+    benchmark<OpLeastLoaded>("SubmitLeastLoaded");
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "sg/superglue.hpp"
+#include "sg/option/taskalloc_slab.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+
+// ==========================================================================
+// Compares creating, running and freeing many small tasks with the default
+// allocation (global operator new and delete) and with TaskAllocSlab.
+// ==========================================================================
+
+struct OpDefault : public DefaultOptions<OpDefault> {};
+struct OpSlab : public DefaultOptions<OpSlab> {
+    typedef TaskAllocSlab<OpSlab> TaskAllocator;
+};
+
+const size_t NUM_TASKS = 1000000;
+const size_t NUM_HANDLES = 64;
+
+template<typename Options>
+struct SmallTask : public Task<Options, 1> {
+    SmallTask(Handle<Options> &h) {
+        this->register_access(ReadWriteAdd::read, h);
+    }
+    void run() {}
+};
+
+template<typename Options>
+static void benchmark(const char *name) {
+    SuperGlue<Options> sg;
+    Handle<Options> h[NUM_HANDLES];
+
+    const Time::TimeUnit start = Time::getTime();
+    for (size_t i = 0; i < NUM_TASKS; ++i)
+        sg.submit(new SmallTask<Options>(h[i % NUM_HANDLES]));
+    sg.barrier();
+    const Time::TimeUnit stop = Time::getTime();
+
+    printf("%-8s %6.1f ticks/task\n", name,
+           static_cast<double>(stop - start) / static_cast<double>(NUM_TASKS));
+}
+
+int main() {
+    benchmark<OpDefault>("default");
+    benchmark<OpSlab>("slab");
+    return 0;
+}
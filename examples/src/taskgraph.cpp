@@ -0,0 +1,134 @@
+#include "sg/superglue.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+// ==========================================================================
+// Time-stepping with the same task graph in every step, as in nbody:
+//
+//   submit: all tasks of a step are created and submitted, then barrier()
+//   replay: one step is captured in a TaskGraph, which is replayed and
+//           waited for in every step
+//
+// Each step has one interaction task for each pair of blocks, adding to
+// both blocks, and one update task per block. The tasks are small, so the
+// time is mostly spent creating, scheduling and deleting them.
+//
+// usage: taskgraph [num_blocks] [num_steps]
+// ==========================================================================
+
+struct Options : public DefaultOptions<Options> {
+    typedef Enable TaskGraphs;
+    typedef AllowedCpusThreadAffinity<Options> ThreadAffinity;
+};
+
+size_t num_blocks = 32;
+size_t num_steps = 100;
+
+struct InteractTask : public Task<Options, 4> {
+    long *pos_i, *pos_j, *force_i, *force_j;
+    InteractTask(Handle<Options> *pos, Handle<Options> *force, long *pos_, long *force_, size_t i, size_t j)
+    : pos_i(&pos_[i]), pos_j(&pos_[j]), force_i(&force_[i]), force_j(&force_[j]) {
+        register_access(ReadWriteAdd::read, pos[i]);
+        register_access(ReadWriteAdd::read, pos[j]);
+        register_access(ReadWriteAdd::add, force[i]);
+        register_access(ReadWriteAdd::add, force[j]);
+    }
+    void run() {
+        const long f = (*pos_j - *pos_i) % 7;
+        *force_i += f;
+        *force_j -= f;
+    }
+};
+
+struct UpdateTask : public Task<Options, 2> {
+    long *pos, *force;
+    UpdateTask(Handle<Options> &h_pos, Handle<Options> &h_force, long *pos_, long *force_)
+    : pos(pos_), force(force_) {
+        register_access(ReadWriteAdd::write, h_pos);
+        register_access(ReadWriteAdd::write, h_force);
+    }
+    void run() {
+        *pos += *force + 1;
+        *force = 0;
+    }
+};
+
+static void submit_step(SuperGlue<Options> &sg, Handle<Options> *pos, Handle<Options> *force,
+                        long *pos_, long *force_) {
+    for (size_t i = 0; i < num_blocks; ++i)
+        for (size_t j = i+1; j < num_blocks; ++j)
+            sg.submit(new InteractTask(pos, force, pos_, force_, i, j));
+    for (size_t i = 0; i < num_blocks; ++i)
+        sg.submit(new UpdateTask(pos[i], force[i], &pos_[i], &force_[i]));
+}
+
+static long checksum(const long *pos) {
+    long sum = 0;
+    for (size_t i = 0; i < num_blocks; ++i)
+        sum = sum * 31 + pos[i];
+    return sum;
+}
+
+static void init(long *pos, long *force) {
+    for (size_t i = 0; i < num_blocks; ++i) {
+        pos[i] = static_cast<long>(i * i);
+        force[i] = 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2)
+        num_blocks = (size_t) atoi(argv[1]);
+    if (argc >= 3)
+        num_steps = (size_t) atoi(argv[2]);
+
+    SuperGlue<Options> sg;
+    Handle<Options> *pos = new Handle<Options>[num_blocks];
+    Handle<Options> *force = new Handle<Options>[num_blocks];
+    long *pos_ = new long[num_blocks];
+    long *force_ = new long[num_blocks];
+    const size_t num_tasks = num_blocks * (num_blocks - 1) / 2 + num_blocks;
+
+    // submit every step
+    init(pos_, force_);
+    const Time::TimeUnit start_submit = Time::getTime();
+    for (size_t step = 0; step < num_steps; ++step) {
+        submit_step(sg, pos, force, pos_, force_);
+        sg.barrier();
+    }
+    const Time::TimeUnit stop_submit = Time::getTime();
+    const long sum_submit = checksum(pos_);
+
+    // capture once, then replay every step
+    init(pos_, force_);
+    const Time::TimeUnit start_capture = Time::getTime();
+    TaskGraph<Options> graph;
+    sg.begin_capture(graph);
+    submit_step(sg, pos, force, pos_, force_);
+    sg.end_capture();
+    const Time::TimeUnit start_replay = Time::getTime();
+    for (size_t step = 0; step < num_steps; ++step) {
+        sg.replay(graph);
+        sg.wait(graph);
+    }
+    const Time::TimeUnit stop_replay = Time::getTime();
+    const long sum_replay = checksum(pos_);
+
+    printf("%d threads, %d tasks/step, %d edges\n", sg.get_num_cpus(),
+           static_cast<int>(num_tasks), static_cast<int>(graph.get_num_edges()));
+    printf("submit:  %12.1f ticks/step\n",
+           static_cast<double>(stop_submit - start_submit) / static_cast<double>(num_steps));
+    printf("replay:  %12.1f ticks/step  (capture %llu ticks)\n",
+           static_cast<double>(stop_replay - start_replay) / static_cast<double>(num_steps),
+           static_cast<unsigned long long>(start_replay - start_capture));
+    printf("results %s\n", sum_submit == sum_replay ? "match" : "DIFFER");
+
+    delete [] pos;
+    delete [] force;
+    delete [] pos_;
+    delete [] force_;
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "sg/superglue.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+
+// ==========================================================================
+// Two independent pipelines in one runtime. The short pipeline is waited for
+// after each step with wait(group), while the long pipeline keeps running.
+// With barrier(), each step would also wait for all of the long pipeline.
+// The waiting thread helps by running tasks from either pipeline, so with
+// few cores the short steps may still have to wait for some long tasks.
+// ==========================================================================
+
+struct Options : public DefaultOptions<Options> {
+    typedef Enable TaskGroups;
+};
+
+const size_t NUM_STEPS = 10;
+const size_t WIDTH = 8;
+
+struct WorkTask : public Task<Options, 1> {
+    Time::TimeUnit ticks;
+    WorkTask(Handle<Options> &h, Time::TimeUnit ticks_) : ticks(ticks_) {
+        register_access(ReadWriteAdd::write, h);
+    }
+    void run() {
+        const Time::TimeUnit stop = Time::getTime() + ticks;
+        while (Time::getTime() < stop)
+            Atomic::rep_nop();
+    }
+};
+
+int main() {
+    SuperGlue<Options> sg;
+    Handle<Options> short_handles[WIDTH];
+    Handle<Options> long_handles[WIDTH];
+    TaskGroup<Options> short_group;
+    TaskGroup<Options> long_group;
+
+    const Time::TimeUnit start = Time::getTime();
+
+    // long pipeline: all steps at once
+    for (size_t step = 0; step < NUM_STEPS; ++step)
+        for (size_t i = 0; i < WIDTH; ++i)
+            sg.submit(new WorkTask(long_handles[i], 1000000), long_group);
+
+    // short pipeline: one step at a time
+    for (size_t step = 0; step < NUM_STEPS; ++step) {
+        for (size_t i = 0; i < WIDTH; ++i)
+            sg.submit(new WorkTask(short_handles[i], 10000), short_group);
+        sg.wait(short_group);
+        printf("short step %2d done after %10llu ticks, long pipeline %s\n",
+               static_cast<int>(step),
+               static_cast<unsigned long long>(Time::getTime() - start),
+               long_group.is_finished() ? "finished" : "running");
+    }
+
+    sg.wait(long_group);
+    printf("long pipeline done after %10llu ticks\n",
+           static_cast<unsigned long long>(Time::getTime() - start));
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "sg/superglue.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+// ==========================================================================
+// Time-stepping where each step submits the same kinds of tasks:
+//
+//   new:  tasks are allocated in every step and freed when they finish
+//   pool: tasks are taken from TaskPools and returned to them when they
+//         finish, so no tasks are allocated after the first step
+//
+// Each step has one interaction task for each pair of blocks, adding to
+// both blocks, and one update task per block.
+//
+// usage: taskpool [num_blocks] [num_steps]
+// ==========================================================================
+
+struct Options : public DefaultOptions<Options> {
+    typedef Enable TaskRecycling;
+    typedef AllowedCpusThreadAffinity<Options> ThreadAffinity;
+};
+
+size_t num_blocks = 32;
+size_t num_steps = 100;
+
+struct InteractTask : public Task<Options, 4> {
+    long *pos_i, *pos_j, *force_i, *force_j;
+    void setup(Handle<Options> *pos, Handle<Options> *force, long *pos_, long *force_, size_t i, size_t j) {
+        pos_i = &pos_[i];
+        pos_j = &pos_[j];
+        force_i = &force_[i];
+        force_j = &force_[j];
+        register_access(ReadWriteAdd::read, pos[i]);
+        register_access(ReadWriteAdd::read, pos[j]);
+        register_access(ReadWriteAdd::add, force[i]);
+        register_access(ReadWriteAdd::add, force[j]);
+    }
+    void run() {
+        const long f = (*pos_j - *pos_i) % 7;
+        *force_i += f;
+        *force_j -= f;
+    }
+};
+
+struct UpdateTask : public Task<Options, 2> {
+    long *pos, *force;
+    void setup(Handle<Options> &h_pos, Handle<Options> &h_force, long *pos_, long *force_) {
+        pos = pos_;
+        force = force_;
+        register_access(ReadWriteAdd::write, h_pos);
+        register_access(ReadWriteAdd::write, h_force);
+    }
+    void run() {
+        *pos += *force + 1;
+        *force = 0;
+    }
+};
+
+static void submit_new(SuperGlue<Options> &sg, Handle<Options> *pos, Handle<Options> *force,
+                       long *pos_, long *force_) {
+    for (size_t i = 0; i < num_blocks; ++i)
+        for (size_t j = i+1; j < num_blocks; ++j) {
+            InteractTask *task = new InteractTask();
+            task->setup(pos, force, pos_, force_, i, j);
+            sg.submit(task);
+        }
+    for (size_t i = 0; i < num_blocks; ++i) {
+        UpdateTask *task = new UpdateTask();
+        task->setup(pos[i], force[i], &pos_[i], &force_[i]);
+        sg.submit(task);
+    }
+}
+
+static void submit_pool(SuperGlue<Options> &sg, Handle<Options> *pos, Handle<Options> *force,
+                        long *pos_, long *force_,
+                        TaskPool<Options, InteractTask> &interact,
+                        TaskPool<Options, UpdateTask> &update) {
+    for (size_t i = 0; i < num_blocks; ++i)
+        for (size_t j = i+1; j < num_blocks; ++j) {
+            InteractTask *task = interact.get();
+            task->setup(pos, force, pos_, force_, i, j);
+            sg.submit(task);
+        }
+    for (size_t i = 0; i < num_blocks; ++i) {
+        UpdateTask *task = update.get();
+        task->setup(pos[i], force[i], &pos_[i], &force_[i]);
+        sg.submit(task);
+    }
+}
+
+static long checksum(const long *pos) {
+    long sum = 0;
+    for (size_t i = 0; i < num_blocks; ++i)
+        sum = sum * 31 + pos[i];
+    return sum;
+}
+
+static void init(long *pos, long *force) {
+    for (size_t i = 0; i < num_blocks; ++i) {
+        pos[i] = static_cast<long>(i * i);
+        force[i] = 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2)
+        num_blocks = (size_t) atoi(argv[1]);
+    if (argc >= 3)
+        num_steps = (size_t) atoi(argv[2]);
+
+    SuperGlue<Options> sg;
+    Handle<Options> *pos = new Handle<Options>[num_blocks];
+    Handle<Options> *force = new Handle<Options>[num_blocks];
+    long *pos_ = new long[num_blocks];
+    long *force_ = new long[num_blocks];
+    const size_t num_tasks = num_blocks * (num_blocks - 1) / 2 + num_blocks;
+
+    // allocate and free tasks in every step
+    init(pos_, force_);
+    const Time::TimeUnit start_new = Time::getTime();
+    for (size_t step = 0; step < num_steps; ++step) {
+        submit_new(sg, pos, force, pos_, force_);
+        sg.barrier();
+    }
+    const Time::TimeUnit stop_new = Time::getTime();
+    const long sum_new = checksum(pos_);
+
+    // reuse tasks from pools
+    init(pos_, force_);
+    TaskPool<Options, InteractTask> interact;
+    TaskPool<Options, UpdateTask> update;
+    const Time::TimeUnit start_pool = Time::getTime();
+    for (size_t step = 0; step < num_steps; ++step) {
+        submit_pool(sg, pos, force, pos_, force_, interact, update);
+        sg.barrier();
+    }
+    const Time::TimeUnit stop_pool = Time::getTime();
+    const long sum_pool = checksum(pos_);
+
+    printf("%d threads, %d tasks/step, %d tasks allocated by pools\n", sg.get_num_cpus(),
+           static_cast<int>(num_tasks),
+           static_cast<int>(interact.get_num_tasks() + update.get_num_tasks()));
+    printf("new:   %12.1f ticks/step\n",
+           static_cast<double>(stop_new - start_new) / static_cast<double>(num_steps));
+    printf("pool:  %12.1f ticks/step\n",
+           static_cast<double>(stop_pool - start_pool) / static_cast<double>(num_steps));
+    printf("results %s\n", sum_new == sum_pool ? "match" : "DIFFER");
+
+    delete [] pos;
+    delete [] force;
+    delete [] pos_;
+    delete [] force_;
+    return 0;
+}
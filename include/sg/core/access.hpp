@@ -39,6 +39,74 @@ public:
     }
 };
 
+// ============================================================================
+// Option LocalityRouting
+// ============================================================================
+template<typename Options, typename T = typename Options::LocalityRouting> class Access_Locality;
+
+template<typename Options>
+class Access_Locality<Options, typename Options::Disable> {
+public:
+    static void set_writes(bool) {}
+};
+
+template<typename Options>
+class Access_Locality<Options, typename Options::Enable> {
+private:
+    bool writes_flag;
+public:
+    Access_Locality() : writes_flag(false) {}
+    void set_writes(bool value) { writes_flag = value; }
+    bool writes() const { return writes_flag; }
+};
+
+// ============================================================================
+// Option DependencyCounting
+// ============================================================================
+template<typename Options, typename T = typename Options::DependencyCounting> class Access_DependencyCounting;
+
+template<typename Options>
+class Access_DependencyCounting<Options, typename Options::Disable> {};
+
+template<typename Options>
+class Access_DependencyCounting<Options, typename Options::Enable> {
+private:
+    TaskBase<Options> *waiting_task; // task that this access belongs to
+public:
+    Access<Options> *next_waiting;   // next access waiting for the same version
+
+    void set_waiting_task(TaskBase<Options> *task) { waiting_task = task; }
+    TaskBase<Options> *get_waiting_task() const { return waiting_task; }
+};
+
+// ============================================================================
+// Option LockHandoff
+// ============================================================================
+template<typename Options, typename T = typename Options::LockHandoff> class Access_LockGrant;
+
+template<typename Options>
+class Access_LockGrant<Options, typename Options::Disable> {
+public:
+    static bool is_granted() { return false; }
+    static bool take_grant() { return false; }
+};
+
+template<typename Options>
+class Access_LockGrant<Options, typename Options::Enable> {
+private:
+    bool granted; // the lock was handed over by the previous holder
+public:
+    Access_LockGrant() : granted(false) {}
+    bool is_granted() const { return granted; }
+    void set_granted() { granted = true; }
+    bool take_grant() {
+        if (!granted)
+            return false;
+        granted = false;
+        return true;
+    }
+};
+
 // ============================================================================
 // Option Lockable
 // ============================================================================
@@ -55,6 +123,7 @@ public:
     static bool get_lock() { return true; }
     static bool needs_lock() { return false; }
     static void release_lock(TaskQueueUnsafe &) {}
+    static void release_grant(TaskQueueUnsafe &) {}
     static bool get_lock_or_notify(TaskBase<Options> *) { return true; }
     static void set_required_quantity(lockcount_type required_) {}
     version_type finished(TaskQueueUnsafe &woken) {
@@ -64,7 +133,9 @@ public:
 };
 
 template<typename Options>
-class Access_Lockable<Options, typename Options::Enable> {
+class Access_Lockable<Options, typename Options::Enable>
+  : public Access_LockGrant<Options>
+{
     typedef typename Options::lockcount_type lockcount_type;
     typedef typename Options::version_type version_type;
     typedef typename Options::WaitListType TaskQueue;
@@ -75,20 +146,27 @@ public:
     Access_Lockable() : required(0) {}
 
     // Check if lock is available, or add a listener
-    bool get_lock_or_notify(TaskBase<Options> *task) const {
+    bool get_lock_or_notify(TaskBase<Options> *task) {
         if (required == 0)
             return true;
 
+        // lock handed over while waiting
+        if (this->take_grant())
+            return true;
+
         const Access<Options> *this_(static_cast<const Access<Options> *>(this));
         return this_->handle->get_lock_or_notify(required, task);
     }
 
     // Get lock if its free, or return false.
     // Low level interface to lock several objects simultaneously
-    bool get_lock() const {
+    bool get_lock() {
         if (required == 0)
             return true;
 
+        if (this->take_grant())
+            return true;
+
         const Access<Options> *this_(static_cast<const Access<Options> *>(this));
         return this_->handle->get_lock(required);
     }
@@ -102,8 +180,18 @@ public:
         this_->handle->release_lock(required, woken);
     }
 
+    // Release a lock that was handed over but is not used after all
+    void release_grant(TaskQueueUnsafe &woken) {
+        if (!this->take_grant())
+            return;
+
+        const Access<Options> *this_(static_cast<const Access<Options> *>(this));
+        this_->handle->release_lock(required, woken);
+    }
+
 public:
     void set_required_quantity(lockcount_type required_) { required = required_; }
+    lockcount_type get_required_quantity() const { return required; }
     bool needs_lock() const { return required != 0; }
     version_type finished(TaskQueueUnsafe &woken) {
         const Access<Options> *this_(static_cast<const Access<Options> *>(this));
@@ -125,7 +213,9 @@ public:
 template<typename Options>
 class Access
   : public detail::Access_Lockable<Options>,
-    public detail::Access_Contributions<Options>
+    public detail::Access_Contributions<Options>,
+    public detail::Access_Locality<Options>,
+    public detail::Access_DependencyCounting<Options>
 {
 public:
     typedef typename Options::AccessInfoType AccessInfo;
@@ -2,6 +2,11 @@
 #define SG_BARRIERPROTOCOL_HPP_INCLUDED
 
 #include "sg/platform/atomic.hpp"
+#include "sg/platform/futex.hpp"
+#include "sg/platform/threadutil.hpp"
+#include "sg/core/spinlock.hpp"
+
+#include <cassert>
 
 namespace sg {
 
@@ -16,17 +21,153 @@ private:
 
     ThreadingManager &tm;
     char padding1[Options::CACHE_LINE_SIZE];
-    unsigned int barrier_counter; // written by everybody, read by main thread
+    typename Options::BarrierCounter barrier_counter; // workers arrive here in each stage
     char padding2[Options::CACHE_LINE_SIZE];
     int state;             // written by anyone, 3 times per try, read by everybody
     int abort;             // read/written on every task submit. written by anyone, 1 time per try, read by main thread.
     char padding3[Options::CACHE_LINE_SIZE];
+    SpinLock barrier_lock; // held by the thread running barrier()
+    int wait_epoch;        // increased when external waiters may have to recheck
+    char padding4[Options::CACHE_LINE_SIZE];
+    int external_waiters;  // threads outside this threading manager that sleep in wait_external()
+    char padding5[Options::CACHE_LINE_SIZE];
+    int main_running;      // the main thread runs a task outside its own barrier, see run_waiting_task()
+    char padding6[Options::CACHE_LINE_SIZE];
+    SpinLock main_lock;    // without workers: held by the thread running tasks with the main executor
+    int main_lock_depth;   // written by the holder of main_lock only
+    ThreadIDType main_lock_owner;
+    char padding7[Options::CACHE_LINE_SIZE];
+    typename Options::IdlePolicy idle_policy;
+
+    struct BarrierFinished {
+        int &state;
+        BarrierFinished(int &state_) : state(state_) {}
+        bool operator()() const { return *static_cast<volatile int *>(&state) == 0; }
+    };
+
+    // the main thread has no tasks that other threads cannot see or run
+    struct MainThreadIdle {
+        BarrierProtocol &bp;
+        MainThreadIdle(BarrierProtocol &bp_) : bp(bp_) {}
+        bool operator()() const { return bp.is_main_thread_idle(); }
+    };
+
+    struct BarrierLocked {
+        SpinLock &lock;
+        BarrierLocked(SpinLock &lock_) : lock(lock_) {}
+        bool operator()() const { return lock.try_lock(); }
+    };
 
 private:
+    static bool stealing(typename Options::Enable) { return true; }
+    static bool stealing(typename Options::Disable) { return false; }
+    static bool stealing() { return stealing(typename Options::Stealing()); }
+
+    // wake an idle worker. if tasks cannot be stolen, only the owner of the
+    // queue can run them, so wake them all.
+    void wake_idle_worker() {
+        if (stealing())
+            idle_policy.wake_one();
+        else
+            idle_policy.wake_all();
+    }
+
+    // new tasks were added: make a barrier in progress start over
+    void abort_barrier() {
+        Atomic::compiler_fence();
+        const int local_abort(abort);
+        if (local_abort != 1) {
+            abort = 1;
+            Atomic::memory_fence_producer();
+        }
+    }
+
+    bool has_workers() {
+        return tm.get_num_cpus() > 1;
+    }
+
+    // Without workers, threads outside the threading manager run the tasks
+    // with the executor of the main thread while they wait, and take turns
+    // with the main thread. The lock is held while running a task, and a
+    // task that waits takes it again on the same thread.
+    void lock_main() {
+        if (*static_cast<volatile int *>(&main_lock_depth) != 0
+            && ThreadUtil::is_current_thread(main_lock_owner)) {
+            ++main_lock_depth;
+            return;
+        }
+        while (!main_lock.try_lock())
+            Atomic::yield();
+        main_lock_owner = ThreadUtil::get_current_thread_id();
+        main_lock_depth = 1;
+    }
+
+    void unlock_main() {
+        if (--main_lock_depth == 0)
+            main_lock.unlock();
+    }
+
+    // run tasks until there are no more
+    void run_tasks(TaskExecutor<Options> *te) {
+        if (te == NULL) {
+            if (!has_workers())
+                while (run_task_external());
+            return;
+        }
+        const bool locked(!has_workers());
+        if (locked)
+            lock_main();
+        TaskQueueUnsafe woken;
+        while (te->execute_tasks(woken));
+        if (locked)
+            unlock_main();
+    }
+
+    // Called by threads outside this threading manager if there are no
+    // workers: run one task with the executor of the main thread. Returns
+    // false if there was none, and no other thread was running one.
+    bool run_task_external() {
+        TaskExecutor<Options> &te(*tm.get_worker(ThreadingManager::MAIN_THREAD_ID));
+        lock_main();
+        TaskQueueUnsafe woken;
+        const bool ran(te.execute_task(woken));
+        if (!woken.empty())
+            te.push_front_list(woken);
+        unlock_main();
+        return ran;
+    }
+
+    void lock_barrier(TaskExecutor<Options> *te) {
+        if (te == NULL) {
+            wait_external(BarrierLocked(barrier_lock));
+            return;
+        }
+        TaskQueueUnsafe woken;
+        while (!barrier_lock.try_lock()) {
+            if (!run_waiting_task(*te, woken))
+                Atomic::yield();
+        }
+        if (!woken.empty())
+            te->push_front_list(woken);
+    }
+
+    bool is_main_thread_idle() {
+        Atomic::compiler_fence();
+        if (main_running != 0)
+            return false;
+        // without stealing, only the main thread can run the tasks in its queue
+        return stealing() || tm.get_task_queues()[ThreadingManager::MAIN_THREAD_ID]->empty_safe();
+    }
+
+    void finish_stage() {
+        state = 0;
+        notify_external_waiters();
+    }
 
 public:
     BarrierProtocol(ThreadingManager &tm_)
-      : tm(tm_), barrier_counter(0), state(0), abort(1)
+      : tm(tm_), state(0), abort(1), wait_epoch(0), external_waiters(0), main_running(0),
+        main_lock_depth(0), main_lock_owner(ThreadUtil::get_current_thread_id())
     {
     }
 
@@ -60,11 +201,8 @@ public:
 
         te.my_barrier_state = local_state;
 
-        // enter barrier
-        const unsigned int local_barrier_counter(Atomic::decrease_nv(&barrier_counter));
-
-        // return if not last
-        if (local_barrier_counter != 0)
+        // enter barrier, and return if not last
+        if (!barrier_counter.arrive(te.get_id() - ThreadingManager::WORKER_THREAD_ID_BASE))
             return abort == 1;
 
         // we are last to enter the barrier
@@ -74,50 +212,83 @@ public:
             // if single worker, the barrier is finished
             if (num_workers == 1) {
                 te.my_barrier_state = 0;
-                state = 0;
+                finish_stage();
                 te.after_barrier();
                 return true;
             }
 
-            // setup state 2, join it, and return
+            // join state 2 before anyone else can, then set it up and return
             te.my_barrier_state = 2;
-            barrier_counter = num_workers - 1;
+            barrier_counter.arrive(te.get_id() - ThreadingManager::WORKER_THREAD_ID_BASE);
             Atomic::memory_fence_producer(); // make sure barrier_counter is visible before state changes
             state = 2;
+            idle_policy.wake_all();
             return abort == 1;
         }
 
         // last in for stage 2 -- finish barrier
         te.my_barrier_state = 0;
-        state = 0;
+        finish_stage();
         te.after_barrier();
         return true;
     }
 
-    // cannot be invoked by more than one thread at a time
-    void barrier(TaskExecutor<Options> &te) {
+    // Wait until all tasks have finished. May be called from any thread
+    // except the workers: te is the executor of the calling thread, which
+    // runs tasks while waiting, or NULL for threads outside this threading
+    // manager, which sleep instead if there are workers to run the tasks.
+    // Only one thread at a time runs the barrier, others wait for it to
+    // finish first.
+    void barrier(TaskExecutor<Options> *te) {
+        assert(te == NULL || te->get_id() == ThreadingManager::MAIN_THREAD_ID);
+
         tm.start_executing();
+        lock_barrier(te);
+        run_barrier(te);
+        barrier_lock.unlock();
+        notify_external_waiters();
+    }
 
-        {
-            TaskQueueUnsafe woken;
-            while (te.execute_tasks(woken));
-        }
+    void barrier(TaskExecutor<Options> &te) {
+        barrier(&te);
+    }
+
+private:
+    void run_barrier(TaskExecutor<Options> *te) {
+
+        run_tasks(te);
 
 		const unsigned int num_workers(static_cast<unsigned int>(tm.get_num_cpus())-1);
 
+        // without workers, the calling thread has run all tasks
         if (num_workers == 0)
             return;
 
+        barrier_counter.init(num_workers);
+
         for (;;) {
-            {
-                TaskQueueUnsafe woken;
-                while (te.execute_tasks(woken));
-            }
+            run_tasks(te);
 
-            barrier_counter = num_workers;
             abort = 0;
             Atomic::memory_fence_producer();
             state = 1;
+            idle_policy.wake_all();
+
+            if (te == NULL) {
+                // the workers run all tasks, including those in the queue
+                // of the main thread (if they can be stolen).
+                wait_external(BarrierFinished(state));
+                if (!is_main_thread_idle()) {
+                    // the main thread is running a task, in a barrier() or
+                    // wait() of its own, or has tasks that only it can run.
+                    // sleep until it is done.
+                    wait_external(MainThreadIdle(*this));
+                    continue;
+                }
+                if (abort == 1 || !tm.get_task_queues()[ThreadingManager::MAIN_THREAD_ID]->empty_safe())
+                    continue;
+                return;
+            }
 
             for (;;) {
                 const int local_state(state);
@@ -126,21 +297,16 @@ public:
                     const int local_abort(abort);
                     if (local_abort == 1)
                         break;
-                    if (!te.get_task_queue().empty_safe())
+                    if (!te->get_task_queue().empty_safe())
                         break;
-                    te.after_barrier();
+                    te->after_barrier();
                     return;
                 }
 
                 const int local_abort(abort);
-                if (local_abort == 1 || !te.get_task_queue().empty_safe()) {
+                if (local_abort == 1 || !te->get_task_queue().empty_safe()) {
                     while (state != 0) {
-
-                        {
-                            TaskQueueUnsafe woken;
-                            while (te.execute_tasks(woken));
-                        }
-
+                        run_tasks(te);
                         Atomic::compiler_fence();
                     }
                     break;
@@ -150,13 +316,130 @@ public:
         }
     }
 
+public:
+    // Run one task while waiting, outside a barrier run by this thread.
+    // Returns false if there was none. Workers do not arrive at a barrier
+    // while they run a task, but the main thread takes no part in barriers
+    // run by other threads. Those must wait for the task it runs, so it is
+    // announced in main_running, and the tasks it wakes are queued instead
+    // of kept in woken.
+    bool run_waiting_task(TaskExecutor<Options> &te, TaskQueueUnsafe &woken) {
+        if (te.get_id() != ThreadingManager::MAIN_THREAD_ID)
+            return te.execute_task(woken);
+        const bool locked(!has_workers());
+        if (locked)
+            lock_main();
+        Atomic::increase(&main_running); // full barrier: announce before taking a task
+        TaskQueueUnsafe main_woken;
+        const bool ran(te.execute_task(main_woken));
+        if (!main_woken.empty())
+            te.push_front_list(main_woken);
+        Atomic::decrease(&main_running);
+        if (locked)
+            unlock_main();
+        notify_external_waiters_after_rmw();
+        return ran;
+    }
+
+    // Called by threads outside this threading manager: sleep until
+    // condition() is true. Anything that can make it true must be followed
+    // by notify_external_waiters(), or notify_external_waiters_after_rmw()
+    // if it was an atomic read-modify-write. Increasing external_waiters is
+    // the fence on this side. Without workers, nobody else may run the
+    // tasks, so run them instead of sleeping.
+    template<typename Condition>
+    void wait_external(const Condition &condition) {
+        if (!has_workers()) {
+            while (!condition()) {
+                if (!run_task_external())
+                    Atomic::yield();
+            }
+            Atomic::memory_fence_consumer();
+            return;
+        }
+        for (;;) {
+            if (condition())
+                break;
+            const int ticket(*static_cast<volatile int *>(&wait_epoch));
+            Atomic::increase(&external_waiters); // full barrier: announce before checking again
+            if (!condition())
+                Futex::wait(&wait_epoch, ticket);
+            Atomic::decrease(&external_waiters);
+        }
+        Atomic::memory_fence_consumer();
+    }
+
+    // Wake external waiters to recheck their conditions. Costs one memory
+    // fence if there are none.
+    void notify_external_waiters() {
+        Atomic::memory_fence(); // the change must be visible before reading external_waiters
+        notify_external_waiters_after_rmw();
+    }
+
+    // As notify_external_waiters(), for changes made with an atomic
+    // read-modify-write, which is a full fence and orders the change before
+    // the read of external_waiters. Finishing a task changes handle
+    // versions and group and graph counters this way, so it costs one read
+    // if there are no waiters.
+    void notify_external_waiters_after_rmw() {
+        if (*static_cast<volatile int *>(&external_waiters) == 0)
+            return;
+        Atomic::increase(&wait_epoch);
+        Futex::wake_all(&wait_epoch);
+    }
+
     void signal_new_work() {
+        abort_barrier();
+        wake_idle_worker();
+    }
+
+    // several tasks were added at once: wake everyone that can help
+    void signal_new_work(size_t num_tasks) {
+        abort_barrier();
+        if (num_tasks == 1)
+            wake_idle_worker();
+        else
+            idle_policy.wake_all();
+    }
+
+    // new work that only the owner of the queue may run
+    void signal_new_pinned_work() {
+        abort_barrier();
+        idle_policy.wake_all();
+    }
+
+    // Called from TaskExecutor when it has nothing to do
+    void idle_no_task(TaskExecutor<Options> &te) {
+        idle_policy.no_task(*this, te, te.idle_state);
+    }
+
+    // Called from TaskExecutor when waiting for the barrier state to change
+    void idle_in_barrier(TaskExecutor<Options> &te) {
+        idle_policy.in_barrier(*this, te, te.idle_state);
+    }
+
+    typename Options::IdlePolicy &get_idle_policy() { return idle_policy; }
+
+    // Called from other threads after TaskExecutor::terminate()
+    void wake_all_idle() {
+        idle_policy.wake_all();
+    }
+
+    // Called from the IdlePolicy before a worker goes to sleep. The worker
+    // must have announced that it is going to sleep, so that anyone changing
+    // the state after this check will wake it.
+    bool may_sleep(TaskExecutor<Options> &te) {
         Atomic::compiler_fence();
-        const int local_abort(abort);
-        if (local_abort != 1) {
-            abort = 1;
-            Atomic::memory_fence_producer();
-        }
+        if (te.terminate_flag || state != te.my_barrier_state)
+            return false;
+        if (!stealing())
+            return te.get_task_queue().empty();
+        TaskQueue **task_queues(tm.get_task_queues());
+        const int num_cpus(tm.get_num_cpus());
+        for (int i = 0; i < num_cpus; ++i)
+            if (!task_queues[i]->empty())
+                return false;
+        return true;
     }
 };
 
@@ -0,0 +1,424 @@
+#ifndef SG_CRITICALPATH_HPP_INCLUDED
+#define SG_CRITICALPATH_HPP_INCLUDED
+
+// ============================================================================
+// Option CriticalPath: Prioritize tasks by their distance to the end of the DAG
+//
+// When enabled, each task gets a bottom level estimate: its own cost plus
+// the largest bottom level of the tasks that depend on it. The estimate is
+// updated incrementally as tasks are submitted, and is converted to a task
+// priority when the task becomes ready, so that a ready list with integer
+// priorities (such as TaskQueueBuckets) runs the most critical tasks first.
+//
+// The cost of a task is set by the user with set_cost(), or otherwise
+// learned as the average run time of earlier tasks of the same type.
+// Costs are measured in thousands of Time::getTime() ticks, which is clock
+// cycles on x86, and user-supplied costs should use the same unit.
+//
+// The priority is the bottom level on a logarithmic scale, with four
+// priority levels per doubling of the bottom level.
+//
+// The graph of unfinished tasks is kept in reference counted nodes, so that
+// no thread needs more than one lock at a time: register_access() locks the
+// handle, and submit and task completion lock one task node at a time.
+// The learned costs are shared by all threads, under a global lock that is
+// only taken for tasks that have no cost set.
+//
+// The levels are lower bounds. A task passes an increase of its level on to
+// the tasks it depends on only when its level has grown by more than 1/16
+// since it last did, so smaller increases add up until they do. The level a
+// task has passed on is thus at most 1/16 below its own, and a level can be
+// that much too low for each task between it and the end of the DAG. This
+// bounds how often a task passes on increases by the number of times its
+// level can grow by 1/16, where exact levels would have to be passed through
+// the whole unfinished graph on every submit. Propagation also stops at
+// finished tasks.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef Enable CriticalPath;
+//       typedef TaskQueueBuckets<Options, 128> ReadyListType;
+//   };
+// ============================================================================
+
+#include "sg/core/accessutil.hpp"
+#include "sg/core/spinlock.hpp"
+#include "sg/core/types.hpp"
+#include "sg/platform/atomic.hpp"
+#include "sg/platform/gettime.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <typeinfo>
+
+namespace sg {
+
+template<typename Options> class Handle;
+template<typename Options> class TaskBase;
+
+namespace detail {
+
+template<typename Options, typename T = typename Options::CriticalPath> class CriticalPath;
+
+// ============================================================================
+// CriticalPathNode: a task in the graph of unfinished tasks
+//
+// A node is referenced by its task until the task finishes, by the nodes of
+// the tasks that depend on it, and by the latest access groups of the
+// handles it accesses. The lock protects everything but the reference count.
+// ============================================================================
+template<typename Options>
+struct CriticalPathNode {
+    typedef typename Types<Options>::template vector_t< CriticalPathNode * >::type nodevector_t;
+
+    SpinLockCompact lock;
+    int refs;
+    bool submitted;
+    bool finished;
+    double cost;
+    double succ_level;       // largest bottom level of the tasks depending on this one
+    double level;            // bottom level estimate: cost + succ_level, once submitted
+    int priority;            // priority corresponding to level
+    double pushed_level;     // level last passed on to preds
+    nodevector_t preds;      // tasks this task depends on. added to before submit, cleared when finished
+
+    CriticalPathNode()
+    : refs(1), submitted(false), finished(false),
+      cost(0.0), succ_level(0.0), level(0.0), priority(0), pushed_level(0.0) {}
+};
+
+// ============================================================================
+// Task_CriticalPath: state stored in each task
+// ============================================================================
+template<typename Options, typename T = typename Options::CriticalPath> class Task_CriticalPath;
+
+template<typename Options>
+class Task_CriticalPath<Options, typename Options::Disable> {
+public:
+    void reset_critical_path() {}
+};
+
+template<typename Options>
+class Task_CriticalPath<Options, typename Options::Enable> {
+    template<typename, typename> friend class CriticalPath;
+
+private:
+    double cp_cost;          // < 0 if not yet known
+    double cp_level;         // bottom level when finished
+    bool cp_learn;           // measure run time
+    Time::TimeUnit cp_start;
+    CriticalPathNode<Options> *cp_node; // from the first access until finished
+
+public:
+    Task_CriticalPath()
+    : cp_cost(-1.0), cp_level(0.0), cp_learn(false), cp_start(0), cp_node(NULL) {}
+
+    ~Task_CriticalPath() {
+        // only tasks that were never run still have a node
+        if (cp_node != NULL)
+            CriticalPath<Options>::release(cp_node);
+    }
+
+    // set cost, in thousands of Time::getTime() ticks. must be called before submit.
+    void set_cost(double cost) { cp_cost = cost; }
+    // the node was released when the task finished
+    void reset_critical_path() {
+        cp_cost = -1.0;
+        cp_level = 0.0;
+        cp_learn = false;
+        cp_start = 0;
+    }
+    double get_critical_path_level() const {
+        if (cp_node == NULL)
+            return cp_level;
+        SpinLockScoped hold(cp_node->lock);
+        return cp_node->level;
+    }
+};
+
+// ============================================================================
+// Handle_CriticalPath: state stored in each handle
+// ============================================================================
+template<typename Options, typename T = typename Options::CriticalPath> class Handle_CriticalPath;
+
+template<typename Options>
+class Handle_CriticalPath<Options, typename Options::Disable> {};
+
+template<typename Options>
+class Handle_CriticalPath<Options, typename Options::Enable> {
+    template<typename, typename> friend class CriticalPath;
+    typedef typename CriticalPathNode<Options>::nodevector_t nodevector_t;
+
+private:
+    typename HandleSpinLock<Options>::type cp_lock; // protects the access groups
+    int cp_group_type;       // access type of the latest group, or -1
+    nodevector_t cp_current; // tasks in the latest group of accesses
+    nodevector_t cp_previous;// tasks in the group before that
+
+public:
+    Handle_CriticalPath() : cp_group_type(-1) {}
+    ~Handle_CriticalPath() {
+        CriticalPath<Options>::release_all(cp_current);
+        CriticalPath<Options>::release_all(cp_previous);
+    }
+};
+
+// ============================================================================
+// CriticalPath: the bookkeeping
+// ============================================================================
+template<typename Options>
+class CriticalPath<Options, typename Options::Disable> {
+    typedef typename Options::version_type version_type;
+    typedef typename Options::ReadyListType::unsafe_t TaskQueueUnsafe;
+public:
+    static version_type schedule(TaskBase<Options> *, Handle<Options> &handle, int type) {
+        return handle.schedule(type);
+    }
+    static void submit(TaskBase<Options> *) {}
+    static void ready(TaskBase<Options> *) {}
+    static void ready_list(TaskQueueUnsafe &) {}
+    static void run_before(TaskBase<Options> *) {}
+    static void run_after(TaskBase<Options> *) {}
+    static void finish(TaskBase<Options> *) {}
+};
+
+template<typename Options>
+class CriticalPath<Options, typename Options::Enable> {
+    template<typename, typename> friend class Task_CriticalPath;
+    template<typename, typename> friend class Handle_CriticalPath;
+    typedef typename Options::version_type version_type;
+    typedef typename Options::ReadyListType::unsafe_t TaskQueueUnsafe;
+    typedef CriticalPathNode<Options> node_t;
+    typedef typename node_t::nodevector_t nodevector_t;
+
+    struct TypeLess {
+        bool operator()(const std::type_info *a, const std::type_info *b) const {
+            return a->before(*b) != 0;
+        }
+    };
+    struct Average {
+        double sum;
+        size_t count;
+        Average() : sum(0.0), count(0) {}
+    };
+    typedef std::map<const std::type_info *, Average, TypeLess> costmap_t;
+
+    // a new bottom level for the tasks a node depends on
+    struct Update {
+        node_t *node;
+        double succ_level;
+        Update(node_t *node_, double succ_level_) : node(node_), succ_level(succ_level_) {}
+    };
+    typedef typename Types<Options>::template vector_t<Update>::type updatevector_t;
+
+    // protects the learned costs
+    static SpinLock &get_lock() {
+        static SpinLock lock;
+        return lock;
+    }
+
+    static costmap_t &get_costs() {
+        static costmap_t costs;
+        return costs;
+    }
+
+    static node_t *get_node(TaskBase<Options> *task) {
+        if (task->cp_node == NULL)
+            task->cp_node = new node_t();
+        return task->cp_node;
+    }
+
+    static void acquire(node_t *node) {
+        Atomic::increase(&node->refs);
+    }
+
+    // drop a reference. the last one frees the node, and drops its references
+    static void release(node_t *node) {
+        if (Atomic::decrease_nv(&node->refs) != 0)
+            return;
+        nodevector_t stack;
+        stack.swap(node->preds);
+        delete node;
+        while (!stack.empty()) {
+            node_t *curr(stack.back());
+            stack.pop_back();
+            if (Atomic::decrease_nv(&curr->refs) != 0)
+                continue;
+            stack.insert(stack.end(), curr->preds.begin(), curr->preds.end());
+            delete curr;
+        }
+    }
+
+    static void release_all(nodevector_t &nodes) {
+        for (size_t i = 0; i < nodes.size(); ++i)
+            release(nodes[i]);
+        nodes.clear();
+    }
+
+    static double get_cost(TaskBase<Options> *task) {
+        if (task->cp_cost >= 0.0)
+            return task->cp_cost;
+        task->cp_learn = true;
+        SpinLockScoped hold(get_lock());
+        typename costmap_t::iterator i(get_costs().find(&typeid(*task)));
+        if (i == get_costs().end() || i->second.count == 0)
+            return 1.0;
+        return i->second.sum / static_cast<double>(i->second.count);
+    }
+
+    // node lock must be held
+    static void set_level(node_t *node, double level) {
+        node->level = level;
+        node->priority = static_cast<int>(4.0 * std::log(1.0 + level) / std::log(2.0));
+    }
+
+    // node lock must be held. the references taken are dropped by propagate()
+    static void push_preds(node_t *node, updatevector_t &stack) {
+        node->pushed_level = node->level;
+        for (size_t i = 0; i < node->preds.size(); ++i) {
+            acquire(node->preds[i]);
+            stack.push_back(Update(node->preds[i], node->level));
+        }
+    }
+
+    // raise the levels of predecessors, for as long as they grow by more than 1/16
+    static void propagate(updatevector_t &stack) {
+        while (!stack.empty()) {
+            const Update update(stack.back());
+            stack.pop_back();
+            node_t *node(update.node);
+            {
+                SpinLockScoped hold(node->lock);
+                if (!node->finished && update.succ_level > node->succ_level) {
+                    node->succ_level = update.succ_level;
+                    // not yet submitted: the level is set from succ_level when it is
+                    if (node->submitted) {
+                        set_level(node, node->cost + node->succ_level);
+                        if (node->level > node->pushed_level + node->pushed_level / 16.0)
+                            push_preds(node, stack);
+                    }
+                }
+            }
+            release(node);
+        }
+    }
+
+public:
+    // schedule an access and add dependency edges. The access groups on the
+    // handle follow the version numbering: consecutive accesses of the same
+    // commutative type form a group that depends on the group before it.
+    static version_type schedule(TaskBase<Options> *task, Handle<Options> &handle, int type) {
+        node_t *node(get_node(task));
+        nodevector_t dropped;
+        version_type version;
+        {
+            SpinLockScoped hold(handle.cp_lock);
+            version = handle.schedule(type);
+
+            if (!AccessUtil<Options>::commutative(type) || type != handle.cp_group_type) {
+                dropped.swap(handle.cp_previous);
+                handle.cp_previous.swap(handle.cp_current);
+                handle.cp_group_type = type;
+            }
+            acquire(node);
+            handle.cp_current.push_back(node);
+            // the task is not submitted, so no other thread reads its preds
+            for (size_t i = 0; i < handle.cp_previous.size(); ++i) {
+                node_t *pred(handle.cp_previous[i]);
+                if (pred == node || *static_cast<volatile bool *>(&pred->finished))
+                    continue;
+                acquire(pred);
+                node->preds.push_back(pred);
+            }
+        }
+        release_all(dropped);
+        return version;
+    }
+
+    // compute the bottom level of a submitted task, and propagate it to its predecessors
+    static void submit(TaskBase<Options> *task) {
+        node_t *node(get_node(task));
+        const double cost(get_cost(task));
+        task->cp_cost = cost;
+
+        updatevector_t stack;
+        {
+            SpinLockScoped hold(node->lock);
+            // a task that depends on another through several handles has
+            // an edge for each. keep one, the others never hold the last reference.
+            nodevector_t &preds(node->preds);
+            std::sort(preds.begin(), preds.end());
+            size_t num_preds = 0;
+            for (size_t i = 0; i < preds.size(); ++i) {
+                if (num_preds > 0 && preds[i] == preds[num_preds - 1])
+                    Atomic::decrease(&preds[i]->refs);
+                else
+                    preds[num_preds++] = preds[i];
+            }
+            preds.resize(num_preds);
+
+            node->cost = cost;
+            node->submitted = true;
+            set_level(node, cost + node->succ_level);
+            push_preds(node, stack);
+        }
+        propagate(stack);
+    }
+
+    // set the priority of a task that becomes ready
+    static void ready(TaskBase<Options> *task) {
+        node_t *node(task->cp_node);
+        if (node != NULL)
+            task->priority = *static_cast<volatile int *>(&node->priority);
+    }
+
+    struct ReadyVisitor {
+        void operator()(TaskBase<Options> *task) { ready(task); }
+    };
+
+    static void ready_list(TaskQueueUnsafe &list) {
+        ReadyVisitor visitor;
+        list.visit(visitor);
+    }
+
+    static void run_before(TaskBase<Options> *task) {
+        if (task->cp_learn)
+            task->cp_start = Time::getTime();
+    }
+
+    static void run_after(TaskBase<Options> *task) {
+        if (!task->cp_learn)
+            return;
+        const double cost(static_cast<double>(Time::getTime() - task->cp_start) / 1000.0);
+        SpinLockScoped hold(get_lock());
+        Average &avg(get_costs()[&typeid(*task)]);
+        avg.sum += cost;
+        ++avg.count;
+    }
+
+    // remove a finished task from the graph. must be called before the task is freed.
+    // the tasks it depended on have finished, so their nodes are not needed either.
+    static void finish(TaskBase<Options> *task) {
+        node_t *node(task->cp_node);
+        if (node == NULL)
+            return;
+        nodevector_t preds;
+        {
+            SpinLockScoped hold(node->lock);
+            node->finished = true;
+            preds.swap(node->preds);
+            task->cp_level = node->level;
+        }
+        task->cp_node = NULL;
+        release_all(preds);
+        release(node);
+    }
+};
+
+} // namespace detail
+
+} // namespace sg
+
+#endif // SG_CRITICALPATH_HPP_INCLUDED
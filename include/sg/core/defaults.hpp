@@ -24,6 +24,7 @@ template<typename Options> class Handle;
 template<typename Options> class HandleBase;
 template<typename Options> class TaskQueueDefault;
 template<typename Options> class TaskQueueDefaultUnsafe;
+template<typename Options> class BarrierProtocol;
 
 // ============================================================================
 // Default Steal Order:  Start from random queue and search upwards
@@ -32,10 +33,12 @@ template<typename Options>
 class DefaultStealOrder {
     typedef typename Options::ReadyListType TaskQueue;
 private:
+    TaskExecutor<Options> *parent;
     size_t seed;
 
 public:
-    void init(TaskExecutor<Options> *parent) {
+    void init(TaskExecutor<Options> *parent_) {
+        parent = parent_;
         seed = (size_t) parent->id;
     }
 
@@ -48,19 +51,101 @@ public:
         for (size_t i = random; i < num_queues; ++i) {
             if (i == id)
                 continue;
-            if (taskQueues[i]->pop_back(dest))
+            if (taskQueues[i]->pop_back(dest)) {
+                parent->tasks_stolen(static_cast<int>(i), 1);
                 return true;
+            }
         }
         for (size_t i = 0; i < random; ++i) {
             if (i == id)
                 continue;
-            if (taskQueues[i]->pop_back(dest))
+            if (taskQueues[i]->pop_back(dest)) {
+                parent->tasks_stolen(static_cast<int>(i), 1);
                 return true;
+            }
         }
         return false;
     }
 };
 
+// ============================================================================
+// Default Idle Policy: Spin
+// Workers that find no tasks yield, and workers waiting in a barrier spin.
+// ThreadState is stored in each TaskExecutor, and reset() whenever it finds
+// a task. wake_one() and wake_all() are called when new work is available
+// or the barrier state changes.
+// ============================================================================
+template<typename Options>
+struct IdleSpin {
+    struct ThreadState {
+        void reset() {}
+    };
+    static void no_task(BarrierProtocol<Options> &, TaskExecutor<Options> &, ThreadState &) {
+        Atomic::yield();
+    }
+    static void in_barrier(BarrierProtocol<Options> &, TaskExecutor<Options> &, ThreadState &) {
+        Atomic::rep_nop();
+    }
+    static void wake_one() {}
+    static void wake_all() {}
+};
+
+// ============================================================================
+// Default Barrier Counter: One counter shared by all workers
+// Counts the workers that have arrived in a stage of the barrier.
+// init() is called by the main thread before each barrier, when no worker is
+// in it. arrive(index) is called once per stage by each worker, with index
+// 0..num_workers-1, and returns true for the last worker to arrive. The
+// counter is then ready for the next stage.
+// ============================================================================
+template<typename Options>
+class BarrierCounterCentral {
+    unsigned int num_workers;
+    unsigned int counter; // written by everybody
+public:
+    BarrierCounterCentral() : num_workers(0), counter(0) {}
+
+    void init(unsigned int num_workers_) {
+        num_workers = counter = num_workers_;
+    }
+
+    bool arrive(int) {
+        if (Atomic::decrease_nv(&counter) != 0)
+            return false;
+        counter = num_workers;
+        return true;
+    }
+};
+
+// ============================================================================
+// Default Submit Policy: Round-robin over all queues
+// Decides which ready list SuperGlue::submit(task) sends a task to.
+// select_queue() is called from the submitting thread. TaskData is added to
+// each task, and ThreadState to each TaskExecutor. run_before() and
+// run_after() are called around each task run.
+// ============================================================================
+template<typename Options>
+class SubmitRoundRobin {
+    typedef typename Options::ThreadingManagerType ThreadingManager;
+private:
+    int next_queue;
+public:
+    struct TaskData {};
+    struct ThreadState {};
+
+    SubmitRoundRobin() : next_queue(0) {}
+
+    int select_queue(ThreadingManager &tman, TaskBase<Options> *) {
+        const int queue = next_queue;
+        // data race here when multiple threads submit tasks, but it
+        // is not important that the distribution is perfectly even.
+        next_queue = (next_queue + 1) % tman.get_num_cpus();
+        return queue;
+    }
+    static void run_before(TaskExecutor<Options> &, TaskBase<Options> *) {}
+    static void run_after(TaskExecutor<Options> &, TaskBase<Options> *) {}
+};
+
 // ============================================================================
 // Default Instrumentation: None
 // One object instantiated per thread.
@@ -76,6 +161,7 @@ struct NoInstrumentation {
     static void run_task_before(TaskBase<Options> *) {}
     static void run_task_after(TaskBase<Options> *) {}
     static void after_barrier() {}
+    static void tasks_stolen(int, size_t) {}
 };
 
 // ============================================================================
@@ -113,6 +199,19 @@ struct DeleteTaskDefault {
     }
 };
 
+// ============================================================================
+// Default Task Allocation: Global operator new
+// Tasks get an operator new and operator delete that call allocate() and
+// deallocate() for any other TaskAllocator. release_thread() is called by
+// each thread of a runtime when it stops running tasks.
+// ============================================================================
+template<typename Options>
+struct TaskAllocDefault {
+    static void *allocate(size_t size) { return ::operator new(size); }
+    static void deallocate(void *p) { ::operator delete(p); }
+    static void release_thread() {}
+};
+
 // ============================================================================
 // Default Thread Affinity
 // ============================================================================
@@ -129,6 +228,8 @@ struct DefaultThreadAffinity {
         cpu_set.set(id);
         ThreadAffinity::set_affinity(cpu_set);
     }
+    // cpu that worker thread id is pinned to
+    static int get_cpu(int id) { return id; }
 };
 
 // ============================================================================
@@ -146,6 +247,9 @@ struct DefaultOptions {
         typedef std::allocator<T2> type;
     };
     typedef DefaultStealOrder<Options> StealOrder;
+    typedef IdleSpin<Options> IdlePolicy;
+    typedef SubmitRoundRobin<Options> SubmitPolicy;
+    typedef BarrierCounterCentral<Options> BarrierCounter;
     typedef ReadWriteAdd AccessInfoType;
     typedef unsigned int version_type;
     typedef unsigned int handleid_type;
@@ -175,10 +279,28 @@ struct DefaultOptions {
     typedef Disable PauseExecution;      // No tasks are executed until setMayExecute(true) is called
     typedef Enable Stealing;             // Task stealing enabled
     typedef Disable Contributions;       // Run tasks but write to temp storage if output handle is busy
+    typedef Disable CriticalPath;        // Set task priorities from the critical path (see criticalpath.hpp)
+    typedef Disable LocalityRouting;     // Woken tasks are queued at the worker that last wrote their data
+    typedef Disable CompactHandle;       // Handles use unpadded locks and allocate version listeners on demand
+    typedef Disable DependencyCounting;  // Tasks wait for all dependencies at once and count the unresolved ones
+    typedef Disable LockFreeVersionQueue;// Version listeners are kept in a lock-free ring (requires DependencyCounting)
+    typedef Disable LockHandoff;         // Released locks are passed to the first waiting task instead of waking all
+    typedef Disable OrderedLocking;      // The locks of a task are taken in order of handle address
+    typedef Disable TaskGroups;          // Tasks can be submitted to a TaskGroup and waited for (see taskgroup.hpp)
+    typedef Disable TaskGraphs;          // Submitted tasks can be captured in a TaskGraph and replayed (see taskgraph.hpp)
+    typedef Disable TaskRecycling;       // Finished tasks can be returned to a TaskPool instead of freed (see taskpool.hpp)
 
     // Size of ThreadWorkspace (only used if ThreadWorkspace is enabled)
     enum { ThreadWorkspace_size = 102400 };
 
+    // Accesses stored inline in tasks with a variable number of accesses
+    // (Task<Options>) before they are moved to the heap. Must be at least 1.
+    enum { TaskInlineAccesses = 4 };
+
+    // Number of versions per handle that can have listeners in the lock-free
+    // ring (only used if LockFreeVersionQueue is enabled). Must be a power of 2.
+    enum { VersionRing_size = 8 };
+
     // Instrumentation
     typedef NoInstrumentation<Options> Instrumentation;
     
@@ -188,6 +310,9 @@ struct DefaultOptions {
     // Releasing task memory
     typedef DeleteTaskDefault<Options> FreeTask;
 
+    // Allocating task memory
+    typedef TaskAllocDefault<Options> TaskAllocator;
+
     // Thread Affinity
     typedef DefaultThreadAffinity<Options> ThreadAffinity;
 
@@ -0,0 +1,205 @@
+#ifndef SG_FUTURE_HPP_INCLUDED
+#define SG_FUTURE_HPP_INCLUDED
+
+#include "sg/core/task.hpp"
+#include "sg/core/versionqueue.hpp"
+#include "sg/platform/atomic.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+
+namespace sg {
+
+template<typename Options> class SuperGlue;
+template<typename Options> class TaskExecutor;
+
+namespace detail {
+
+// result type of a function object, or of a function pointer
+template<typename Function> struct FutureResult { typedef typename Function::result_type type; };
+template<typename R> struct FutureResult<R (*)()> { typedef R type; };
+template<typename R, typename A> struct FutureResult<R (*)(A)> { typedef R type; };
+
+// ============================================================================
+// FutureState: The result of a task, shared by its futures and by the tasks
+// that compute and read it. Allocated by the TaskAllocator, and deleted with
+// the last reference.
+// ============================================================================
+template<typename Options, typename T>
+class FutureState : public Task_Allocator<Options> {
+    typedef typename Options::version_type version_type;
+
+private:
+    int refcount;
+
+    FutureState(const FutureState &);
+    const FutureState &operator=(const FutureState &);
+
+public:
+    SuperGlue<Options> &sg;
+    Handle<Options> handle;     // written by the task that computes the value
+    version_type ready_version; // version of the handle when the value is ready
+    T value;
+
+    FutureState(SuperGlue<Options> &sg_)
+    : refcount(1), sg(sg_), ready_version(0), value() {}
+
+    void add_ref() { Atomic::increase(&refcount); }
+    void release() {
+        if (Atomic::decrease_nv(&refcount) == 0)
+            delete this;
+    }
+
+    // called when the task that computes the value has registered its access
+    void set_ready_version() { ready_version = handle.next_version()-1; }
+
+    bool is_ready() {
+        Atomic::compiler_fence(); // to reload the handle version
+        return version_available(handle.get_current_version(), ready_version);
+    }
+};
+
+// ============================================================================
+// FutureTask: Computes the value of a future by calling function()
+// ============================================================================
+template<typename Options, typename T, typename Function>
+class FutureTask : public Task<Options, 1> {
+private:
+    FutureState<Options, T> *state;
+    Function function;
+
+public:
+    FutureTask(FutureState<Options, T> *state_, Function function_)
+    : state(state_), function(function_) {
+        state->add_ref();
+        this->register_access(Options::AccessInfoType::write, state->handle);
+        state->set_ready_version();
+    }
+    ~FutureTask() { state->release(); }
+
+    void run() { state->value = function(); }
+    void run(TaskExecutor<Options> &) { run(); }
+    std::string get_name() { return "future"; }
+};
+
+// ============================================================================
+// ContinuationTask: Computes the value of a future by calling function() on
+// the value of another future, when that is ready
+// ============================================================================
+template<typename Options, typename T, typename R, typename Function>
+class ContinuationTask : public Task<Options, 2> {
+private:
+    FutureState<Options, T> *input;
+    FutureState<Options, R> *state;
+    Function function;
+
+public:
+    ContinuationTask(FutureState<Options, T> *input_, FutureState<Options, R> *state_, Function function_)
+    : input(input_), state(state_), function(function_) {
+        input->add_ref();
+        state->add_ref();
+        this->register_access(Options::AccessInfoType::read, input->handle);
+        this->register_access(Options::AccessInfoType::write, state->handle);
+        state->set_ready_version();
+    }
+    ~ContinuationTask() {
+        input->release();
+        state->release();
+    }
+
+    void run() { state->value = function(input->value); }
+    void run(TaskExecutor<Options> &) { run(); }
+    std::string get_name() { return "continuation"; }
+};
+
+} // namespace detail
+
+// ============================================================================
+// Future: The value of a task, available when the task has finished
+//
+// The value is stored inline in a shared state, so no handle is needed to
+// pass it on. Continuations added with then() are submitted at once and
+// depend on the value through the scheduler, so they start when it is ready
+// without involving the thread that added them. Several continuations of the
+// same future read the value concurrently.
+//
+// Functions may be function pointers, or function objects with a result_type.
+// The value type must be default constructible and assignable. Like any other
+// tasks on the same handle, continuations of one future must not be added from
+// several threads at the same time.
+//
+// Usage:
+//
+//   int produce();
+//   double transform(const int &);
+//
+//   Future<Options, int> a(submit_future(sg, produce));
+//   Future<Options, double> b(a.then(transform));
+//   double result = b.get();
+// ============================================================================
+template<typename Options, typename T>
+class Future {
+private:
+    detail::FutureState<Options, T> *state; // or NULL
+
+public:
+    Future() : state(NULL) {}
+    // takes over the reference to state
+    explicit Future(detail::FutureState<Options, T> *state_) : state(state_) {}
+    Future(const Future &rhs) : state(rhs.state) {
+        if (state != NULL)
+            state->add_ref();
+    }
+    const Future &operator=(const Future &rhs) {
+        if (rhs.state != NULL)
+            rhs.state->add_ref();
+        if (state != NULL)
+            state->release();
+        state = rhs.state;
+        return *this;
+    }
+    ~Future() {
+        if (state != NULL)
+            state->release();
+    }
+
+    bool valid() const { return state != NULL; }
+
+    bool is_ready() const {
+        assert(valid());
+        return state->is_ready();
+    }
+
+    // Wait until the value is ready and return it. Threads of the runtime run
+    // other tasks while waiting, see SuperGlue::wait().
+    const T &get() const {
+        assert(valid());
+        state->sg.wait(state->handle, state->ready_version);
+        return state->value;
+    }
+
+    // submit a task that calls function(value) when the value is ready
+    template<typename Function>
+    Future<Options, typename detail::FutureResult<Function>::type> then(Function function) const {
+        typedef typename detail::FutureResult<Function>::type R;
+        assert(valid());
+        detail::FutureState<Options, R> *next(new detail::FutureState<Options, R>(state->sg));
+        state->sg.submit(new detail::ContinuationTask<Options, T, R, Function>(state, next, function));
+        return Future<Options, R>(next);
+    }
+};
+
+// submit a task that calls function(), and return a future for its result
+template<typename Options, typename Function>
+Future<Options, typename detail::FutureResult<Function>::type>
+submit_future(SuperGlue<Options> &sg, Function function) {
+    typedef typename detail::FutureResult<Function>::type R;
+    detail::FutureState<Options, R> *state(new detail::FutureState<Options, R>(sg));
+    sg.submit(new detail::FutureTask<Options, R, Function>(state, function));
+    return Future<Options, R>(state);
+}
+
+} // namespace sg
+
+#endif // SG_FUTURE_HPP_INCLUDED
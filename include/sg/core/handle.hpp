@@ -4,6 +4,9 @@
 #include "sg/core/types.hpp"
 #include "sg/platform/atomic.hpp"
 #include "sg/core/spinlock.hpp"
+#include "sg/core/taskqueuesafe.hpp"
+#include "sg/core/versionqueue.hpp"
+#include "sg/core/criticalpath.hpp"
 #include <cassert>
 #include <limits>
 #include <string>
@@ -15,7 +18,6 @@ template<typename Options> class HandleBase;
 template<typename Options> class SchedulerVersion;
 template<typename Options> class TaskBase;
 template<typename Options> class VersionQueue;
-template<typename Options> class VersionQueueExclusive;
 
 namespace detail {
 
@@ -61,6 +63,27 @@ public:
     handleid_type get_global_id() const { return id; }
 };
 
+// ============================================================================
+// Option: LocalityRouting
+// ============================================================================
+template<typename Options, typename T = typename Options::LocalityRouting> class Handle_LastWriter;
+
+template<typename Options>
+class Handle_LastWriter<Options, typename Options::Disable> {};
+
+template<typename Options>
+class Handle_LastWriter<Options, typename Options::Enable> {
+private:
+    int last_writer;
+public:
+    Handle_LastWriter() : last_writer(-1) {}
+
+    // id of the worker that last finished a task writing this handle, or -1.
+    // only a hint: may be read while another worker updates it.
+    int get_last_writer() const { return *static_cast<const volatile int *>(&last_writer); }
+    void set_last_writer(int id) { *static_cast<volatile int *>(&last_writer) = id; }
+};
+
 // ============================================================================
 // Option: Contributions
 // ============================================================================
@@ -79,7 +102,7 @@ class Handle_Contributions<Options, typename Options::Enable>
     typedef typename Options::ContributionType Contribution;
 private:
         Contribution *contrib;
-        SpinLock lock_contrib;
+        typename HandleSpinLock<Options>::type lock_contrib;
     
 public:
         Handle_Contributions() : contrib(0) {}
@@ -125,6 +148,22 @@ public:
         }
 };
 
+// ============================================================================
+// Option: CompactHandle
+// Type of the list of tasks waiting for the lock
+// ============================================================================
+template<typename Options, typename T = typename Options::CompactHandle> struct HandleWaitList;
+
+template<typename Options>
+struct HandleWaitList<Options, typename Options::Disable> {
+    typedef typename Options::WaitListType type;
+};
+
+template<typename Options>
+struct HandleWaitList<Options, typename Options::Enable> {
+    typedef TaskQueueSafe<typename Options::WaitListType::unsafe_t, QueueSpinLockedCompact> type;
+};
+
 // ============================================================================
 // Option: Lockable
 // ============================================================================
@@ -140,7 +179,7 @@ public:
     version_type increase_current_version(TaskQueueUnsafe &woken) {
         HandleBase<Options> *this_(static_cast<HandleBase<Options> *>(this));
         version_type ver = Atomic::increase_nv(&this_->version);
-        this_->version_queue.notify_version_listeners(woken, this_->version);
+        this_->version_queue.notify_version_listeners(woken, ver, this_->version);
         return ver;
     }
 };
@@ -149,7 +188,7 @@ template<typename Options>
 class Handle_Lockable<Options, typename Options::Enable> {
     typedef typename Options::version_type version_type;
     typedef typename Options::lockcount_type lockcount_type;
-    typedef typename Options::WaitListType TaskQueue;
+    typedef typename HandleWaitList<Options>::type TaskQueue;
     typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
 
 private:
@@ -159,8 +198,9 @@ protected:
     // If object is locked or not
     lockcount_type available;
 
-    // Notify lock listeners when the lock is released
-    void notify_lock_listeners(TaskQueueUnsafe &woken) {
+    // Notify lock listeners when the lock is released:
+    // wake all listeners and let them compete for the lock
+    void notify_lock_listeners(TaskQueueUnsafe &woken, typename Options::Disable) {
 
         TaskQueueUnsafe wake;
         {
@@ -174,6 +214,46 @@ protected:
         woken.push_front_list(wake);
     }
 
+    // Notify lock listeners when the lock is released:
+    // take the lock on behalf of the listeners first in line, as long as
+    // it is available, and only wake those. The rest stay in the list.
+    void notify_lock_listeners(TaskQueueUnsafe &woken, typename Options::Enable) {
+
+        TaskQueueUnsafe wake;
+        {
+            TaskQueueExclusive<TaskQueue> list(lock_listener_list);
+            TaskBase<Options> *task;
+            while (list.pop_front(task)) {
+                Access<Options> *access(find_lock_access(task));
+                if (!get_lock(access->get_required_quantity())) {
+                    list.push_front(task);
+                    break;
+                }
+                access->set_granted();
+                wake.push_back(task);
+            }
+        }
+
+        woken.push_front_list(wake);
+    }
+
+    void notify_lock_listeners(TaskQueueUnsafe &woken) {
+        notify_lock_listeners(woken, typename Options::LockHandoff());
+    }
+
+    // the access of a waiting task that waits for this lock
+    Access<Options> *find_lock_access(TaskBase<Options> *task) {
+        Handle<Options> *this_(static_cast<Handle<Options> *>(this));
+        const size_t num_access(task->get_num_access());
+        Access<Options> *access(task->get_access());
+        for (size_t i = 0; i < num_access; ++i) {
+            if (access[i].get_handle() == this_ && access[i].needs_lock() && !access[i].is_granted())
+                return &access[i];
+        }
+        assert(false);
+        return NULL;
+    }
+
 public:
     Handle_Lockable() : available(1) {}
 
@@ -215,7 +295,7 @@ public:
         Handle<Options> *this_(static_cast<Handle<Options> *>(this));
 
         version_type ver = Atomic::increase_nv(&this_->version);
-        this_->version_queue.notify_version_listeners(woken, this_->get_current_version());
+        this_->version_queue.notify_version_listeners(woken, ver, this_->version);
         return ver;
     }
 
@@ -238,7 +318,9 @@ class HandleBase
   : public detail::Handle_Lockable<Options>,
     public detail::Handle_Contributions<Options>,
     public detail::Handle_GlobalId<Options>,
-    public detail::Handle_Name<Options>
+    public detail::Handle_Name<Options>,
+    public detail::Handle_CriticalPath<Options>,
+    public detail::Handle_LastWriter<Options>
 {
     typedef typename Options::version_type version_type;
 
@@ -270,21 +352,17 @@ public:
         return required_version.schedule(type);
     }
 
-    bool is_version_available_or_notify(TaskBase<Options> *task, version_type required_version_) {
+    // listener is the task, or the access if DependencyCounting is enabled
+    typedef typename detail::VersionListeners<Options>::listener_t listener_t;
 
-        // check if required version is available
-        if ((version_type)(version - required_version_) < std::numeric_limits<version_type>::max() / 2)
-            return true;
-
-        // the version may become available here; lock and check again
+    bool is_version_available_or_notify(listener_t *listener, version_type required_version_) {
 
-        VersionQueueExclusive<Options> queue(version_queue);
-        if ((version_type)(version - required_version_) < std::numeric_limits<version_type>::max() / 2)
+        // check if required version is available
+        if (detail::version_available(version, required_version_))
             return true;
 
-        queue.add_version_listener(task, required_version_);
-
-        return false;
+        // the version may become available here; the queue checks again
+        return version_queue.is_version_available_or_add_listener(listener, required_version_, version);
     }
 };
 
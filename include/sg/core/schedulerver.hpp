@@ -3,9 +3,11 @@
 
 #include "sg/core/access_rwa.hpp" // specialize for ReadWriteAdd
 #include "sg/core/spinlock.hpp"
+#include "sg/platform/atomic.hpp"
 
 #include <cstring> // memset
-#include <algorithm> // max_element
+#include <stdint.h>
+#include <algorithm> // max_element, copy
 
 namespace sg {
 
@@ -39,10 +41,20 @@ namespace detail {
         };
 
     public:
+        enum { num_counters = AccessInfo::num_accesses };
+
         SchedulerVersionImpl() {
             std::memset(required_version, 0, sizeof(required_version));
         }
 
+        // save and restore the scheduling state, as num_counters versions
+        void get_state(version_type *state) {
+            std::copy(required_version, required_version + num_counters, state);
+        }
+        void set_state(const version_type *state) {
+            std::copy(state, state + num_counters, required_version);
+        }
+
         version_type next_version() {
             return *std::max_element(required_version, required_version + AccessInfo::num_accesses)+1;
         }
@@ -63,10 +75,21 @@ namespace detail {
         version_type required_version[2];
 
     public:
+        enum { num_counters = 2 };
+
         SchedulerVersionImpl() {
             required_version[0] = required_version[1] = 0;
         }
 
+        void get_state(version_type *state) {
+            state[0] = required_version[0];
+            state[1] = required_version[1];
+        }
+        void set_state(const version_type *state) {
+            required_version[0] = state[0];
+            required_version[1] = state[1];
+        }
+
         version_type next_version() {
             return std::max(required_version[0], required_version[1])+1;
         }
@@ -87,24 +110,120 @@ namespace detail {
     };
 
     // ============================================================================
-    // SchedulerVersion
+    // SchedulerVersionLocked: thread safe, using a spinlock per handle
     // ============================================================================
-    template<typename Options, typename T = typename Options::ThreadSafeSubmit> class SchedulerVersion;
-
     template<typename Options>
-    class SchedulerVersion<Options, typename Options::Enable>
+    class SchedulerVersionLocked
      : public detail::SchedulerVersionImpl<Options, typename Options::AccessInfoType> {
         typedef typename detail::SchedulerVersionImpl<Options, typename Options::AccessInfoType> parent;
         typedef typename Options::version_type version_type;
     private:
-        SpinLock lock;
+        typename HandleSpinLock<Options>::type lock;
     public:
         version_type schedule(int type) {
             SpinLockScoped l(lock);
             return parent::schedule(type);
         }
+        void get_state(version_type *state) {
+            SpinLockScoped l(lock);
+            parent::get_state(state);
+        }
+        void set_state(const version_type *state) {
+            SpinLockScoped l(lock);
+            parent::set_state(state);
+        }
     };
 
+    // ============================================================================
+    // SchedulerVersionLockFree: thread safe, for ReadWriteAdd with 32-bit versions
+    // The two counters are packed into one 64-bit word that is updated with a
+    // compare-and-swap, so threads that submit tasks using the same handle do
+    // not serialize on a lock.
+    // ============================================================================
+    template<typename Options>
+    class SchedulerVersionLockFree {
+    private:
+        typedef typename Options::version_type version_type;
+        uint64_t state; // required version for read in the low half, for add in the high half
+
+        static version_type get_read(uint64_t s) { return static_cast<version_type>(s); }
+        static version_type get_add(uint64_t s) { return static_cast<version_type>(s >> 32); }
+        static uint64_t pack(version_type read, version_type add) {
+            return static_cast<uint64_t>(read) | (static_cast<uint64_t>(add) << 32);
+        }
+        static version_type next_version(uint64_t s) {
+            return std::max(get_read(s), get_add(s))+1;
+        }
+
+    public:
+        enum { num_counters = 2 };
+
+        SchedulerVersionLockFree() : state(0) {}
+
+        void get_state(version_type *state_) {
+            const uint64_t s(*static_cast<volatile uint64_t *>(&state));
+            state_[0] = get_read(s);
+            state_[1] = get_add(s);
+        }
+        void set_state(const version_type *state_) {
+            const uint64_t s(pack(state_[0], state_[1]));
+            for (;;) {
+                const uint64_t old_state(*static_cast<volatile uint64_t *>(&state));
+                if (Atomic::cas(&state, old_state, s) == old_state)
+                    return;
+            }
+        }
+
+        version_type next_version() {
+            return next_version(*static_cast<volatile uint64_t *>(&state));
+        }
+
+        version_type schedule(int type) {
+            for (;;) {
+                const uint64_t old_state(*static_cast<volatile uint64_t *>(&state));
+                const version_type next_ver(next_version(old_state));
+                uint64_t new_state;
+                version_type ver;
+                switch (type) {
+                case ReadWriteAdd::read:
+                    new_state = pack(get_read(old_state), next_ver);
+                    ver = get_read(old_state);
+                    break;
+                case ReadWriteAdd::add:
+                    new_state = pack(next_ver, get_add(old_state));
+                    ver = get_add(old_state);
+                    break;
+                default:
+                    new_state = pack(next_ver, next_ver);
+                    ver = next_ver-1;
+                    break;
+                }
+                if (new_state == old_state || Atomic::cas(&state, old_state, new_state) == old_state)
+                    return ver;
+            }
+        }
+    };
+
+    // choose the lock-free version when possible
+    template<typename Options, typename AccessInfo, bool Packable = (sizeof(typename Options::version_type) == 4)>
+    struct SchedulerVersionThreadSafe {
+        typedef SchedulerVersionLocked<Options> type;
+    };
+
+    template<typename Options>
+    struct SchedulerVersionThreadSafe<Options, ReadWriteAdd, true> {
+        typedef SchedulerVersionLockFree<Options> type;
+    };
+
+    // ============================================================================
+    // SchedulerVersion
+    // ============================================================================
+    template<typename Options, typename T = typename Options::ThreadSafeSubmit> class SchedulerVersion;
+
+    template<typename Options>
+    class SchedulerVersion<Options, typename Options::Enable>
+     : public SchedulerVersionThreadSafe<Options, typename Options::AccessInfoType>::type {};
+
     template<typename Options>
     class SchedulerVersion<Options, typename Options::Disable>
      : public detail::SchedulerVersionImpl<Options, typename Options::AccessInfoType> {
@@ -6,17 +6,16 @@
 
 namespace sg {
 
-class SpinLock {
+// word-sized spinlock, for locks that are embedded in many objects
+class SpinLockCompact {
 private:
-    enum { CACHE_LINE_SIZE = 64 };
     unsigned int v_;
-    char padding[CACHE_LINE_SIZE-sizeof(unsigned int)];
 
-    SpinLock(const SpinLock &);
-    const SpinLock &operator=(const SpinLock &);
+    SpinLockCompact(const SpinLockCompact &);
+    const SpinLockCompact &operator=(const SpinLockCompact &);
 
 public:
-    SpinLock() : v_(0) {}
+    SpinLockCompact() : v_(0) {}
 
     bool try_lock() {
         return Atomic::lock_test_and_set(&v_);
@@ -36,14 +35,21 @@ public:
     }
 };
 
+// spinlock padded to a cache line, to avoid false sharing
+class SpinLock : public SpinLockCompact {
+private:
+    enum { CACHE_LINE_SIZE = 64 };
+    char padding[CACHE_LINE_SIZE-sizeof(SpinLockCompact)];
+};
+
 class SpinLockScoped {
 private:
-    SpinLock & sp_;
+    SpinLockCompact & sp_;
 
     SpinLockScoped( SpinLockScoped const & );
     SpinLockScoped & operator=( SpinLockScoped const & );
 public:
-    explicit SpinLockScoped( SpinLock & sp ): sp_( sp ) {
+    explicit SpinLockScoped( SpinLockCompact & sp ): sp_( sp ) {
         sp.lock();
     }
 
@@ -54,7 +60,7 @@ public:
 
 class SpinLockTryLock {
 private:
-    SpinLock & sp_;
+    SpinLockCompact & sp_;
 
     SpinLockTryLock(SpinLockTryLock const &);
     SpinLockTryLock &operator=(SpinLockTryLock const &);
@@ -62,7 +68,7 @@ private:
 public:
     const bool success;
 
-    explicit SpinLockTryLock(SpinLock &sp) : sp_(sp), success(sp.try_lock()) {}
+    explicit SpinLockTryLock(SpinLockCompact &sp) : sp_(sp), success(sp.try_lock()) {}
 
     ~SpinLockTryLock() {
         if (success)
@@ -70,6 +76,26 @@ public:
     }
 };
 
+namespace detail {
+
+// ============================================================================
+// Option: CompactHandle
+// Type of the locks that are embedded in each handle
+// ============================================================================
+template<typename Options, typename T = typename Options::CompactHandle> struct HandleSpinLock;
+
+template<typename Options>
+struct HandleSpinLock<Options, typename Options::Disable> {
+    typedef SpinLock type;
+};
+
+template<typename Options>
+struct HandleSpinLock<Options, typename Options::Enable> {
+    typedef SpinLockCompact type;
+};
+
+} // namespace detail
+
 } // namespace sg
 
 #endif // SG_SPINLOCK_HPP_INCLUDED
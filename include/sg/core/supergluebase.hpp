@@ -2,6 +2,10 @@
 #define SG_SUPERGLUEBASE_HPP_INCLUDED
 
 #include "sg/core/barrierprotocol.hpp"
+#include "sg/core/taskgraph.hpp"
+#include "sg/core/taskgroup.hpp"
+#include "sg/core/types.hpp"
+#include "sg/core/versionqueue.hpp"
 
 #include <cassert>
 
@@ -31,6 +35,45 @@ public:
     }
 };
 
+// ===========================================================================
+// Option TaskGraphs
+// ===========================================================================
+template<typename Options, typename T = typename Options::TaskGraphs> class SuperGlue_Capture;
+
+template<typename Options>
+class SuperGlue_Capture<Options, typename Options::Disable> {
+public:
+    static bool capture_task(TaskBase<Options> *, int) { return false; }
+};
+
+template<typename Options>
+class SuperGlue_Capture<Options, typename Options::Enable> {
+private:
+    TaskGraph<Options> *capture; // or NULL
+
+public:
+    SuperGlue_Capture() : capture(NULL) {}
+
+    // store submitted tasks in the graph instead of running them
+    void begin_capture(TaskGraph<Options> &graph) {
+        assert(capture == NULL);
+        capture = &graph;
+    }
+
+    void end_capture() {
+        assert(capture != NULL);
+        capture->finalize();
+        capture = NULL;
+    }
+
+    bool capture_task(TaskBase<Options> *task, int queue) {
+        if (capture == NULL)
+            return false;
+        capture->add(task, queue);
+        return true;
+    }
+};
+
 // ===========================================================================
 // CheckLockableRequired -- check that no access types commutes and required
 // exclusive access if lockable is disabled
@@ -53,6 +96,35 @@ struct CheckLockableRequired<Options, typename Options::Disable> {
     enum { access_types_needs_lockable = NeedsLock::result ? 0 : 1};
 };
 
+// ===========================================================================
+// CheckVersionQueue -- check that the lock-free version queue has the
+// DependencyCounting option it requires, a valid ring size, and accesses
+// aligned enough to leave room for the flags in the low bits of their
+// pointers (which may not be the case on 32-bit targets)
+// ===========================================================================
+template<typename Options, typename T = typename Options::LockFreeVersionQueue>
+struct CheckVersionQueue {
+    enum { valid = 1 };
+};
+
+template<typename Options>
+struct CheckVersionQueue<Options, typename Options::Enable> {
+    template<typename T, typename U> struct is_same { enum { value = 0 }; };
+    template<typename T> struct is_same<T, T> { enum { value = 1 }; };
+
+    template<typename T>
+    struct alignment_of {
+        struct padded { char c; T t; };
+        enum { value = sizeof(padded) - sizeof(T) };
+    };
+
+    enum { counting = is_same<typename Options::DependencyCounting, typename Options::Enable>::value };
+    enum { power_of_2 = (Options::VersionRing_size & (Options::VersionRing_size - 1)) == 0 ? 1 : 0 };
+    enum { aligned = static_cast<int>(alignment_of< Access<Options> >::value)
+                     >= static_cast<int>(VersionQueueRing<Options>::LISTENER_ALIGNMENT) ? 1 : 0 };
+    enum { valid = (counting && power_of_2 && aligned) ? 1 : 0 };
+};
+
 template<bool> struct STATIC_ASSERT {};
 template<> struct STATIC_ASSERT<true> { typedef struct {} type; };
 
@@ -72,6 +144,50 @@ struct SANITY_CHECKS {
 
     // check that Lockable isn't disabled when access types require it to be enabled
     typedef typename STATIC_ASSERT< CheckLockableRequired<Options>::access_types_needs_lockable >::type check_lockable;
+
+    // check that LockFreeVersionQueue is used with DependencyCounting, and
+    // that accesses are aligned enough for it
+    typedef typename STATIC_ASSERT< CheckVersionQueue<Options>::valid >::type check_version_queue;
+};
+
+// ===========================================================================
+// Conditions for SuperGlue::wait_until()
+// ===========================================================================
+template<typename Options>
+struct WaitHandleIdle {
+    HandleBase<Options> &handle;
+    WaitHandleIdle(HandleBase<Options> &handle_) : handle(handle_) {}
+    bool operator()() const {
+        Atomic::compiler_fence(); // to reload the handle versions
+        return handle.next_version()-1 == handle.get_current_version();
+    }
+};
+
+template<typename Options>
+struct WaitHandleVersion {
+    typedef typename Options::version_type version_type;
+    HandleBase<Options> &handle;
+    const version_type version;
+    WaitHandleVersion(HandleBase<Options> &handle_, version_type version_)
+    : handle(handle_), version(version_) {}
+    bool operator()() const {
+        Atomic::compiler_fence(); // to reload the handle version
+        return version_available(handle.get_current_version(), version);
+    }
+};
+
+template<typename Options>
+struct WaitGroupFinished {
+    TaskGroup<Options> &group;
+    WaitGroupFinished(TaskGroup<Options> &group_) : group(group_) {}
+    bool operator()() const { return group.is_finished(); }
+};
+
+template<typename Options>
+struct WaitGraphFinished {
+    TaskGraph<Options> &graph;
+    WaitGraphFinished(TaskGraph<Options> &graph_) : graph(graph_) {}
+    bool operator()() const { return graph.is_finished(); }
 };
 
 } // namespace detail
@@ -82,6 +198,7 @@ struct SANITY_CHECKS {
 template<typename Options>
 class SuperGlue
   : public detail::SuperGlue_PauseExecution<Options>,
+    public detail::SuperGlue_Capture<Options>,
     public Options::ThreadAffinity,
     private detail::SANITY_CHECKS<Options>
 {
@@ -96,23 +213,58 @@ private:
 
     bool delete_threadmanager;
 
+    // Wait until condition() is true. Threads of this runtime, including
+    // workers inside a running task, run other tasks while waiting. Other
+    // threads sleep until a task finishes that may have changed the condition,
+    // or run tasks too if the runtime has no workers.
+    template<typename Condition>
+    void wait_until(const Condition &condition) {
+        TaskExecutor<Options> *te(TaskExecutor<Options>::get_current(*tman));
+        if (te == NULL) {
+            tman->barrier_protocol.wait_external(condition);
+            return;
+        }
+
+        TaskQueueUnsafe woken;
+        while (!condition()) {
+            if (!tman->barrier_protocol.run_waiting_task(*te, woken))
+                Atomic::yield();
+        }
+        Atomic::memory_fence_consumer(); // see the results of the tasks
+        if (!woken.empty())
+            te->push_front_list(woken);
+    }
+
+    // add lists of ready tasks to the queues, and signal idle workers once
+    void push_ready(typename Types<Options>::template vector_t<TaskQueueUnsafe>::type &ready, size_t num_ready) {
+        if (num_ready == 0)
+            return;
+        TaskQueue **queues(tman->get_task_queues());
+        const int num_queues(get_num_cpus());
+        for (int i = 0; i < num_queues; ++i) {
+            if (!ready[static_cast<size_t>(i)].empty())
+                queues[i]->push_back_list(ready[static_cast<size_t>(i)]);
+        }
+        tman->barrier_protocol.signal_new_work(num_ready);
+    }
+
 public:
     ThreadingManager *tman;
     TaskExecutor<Options> *main_task_executor;
     char padding0[Options::CACHE_LINE_SIZE];
 
-    int next_queue;
+    typename Options::SubmitPolicy submit_policy;
     char padding2[Options::CACHE_LINE_SIZE];
 
 public:
     SuperGlue(ThreadingManager &tman_)
-     : delete_threadmanager(false), tman(&tman_), next_queue(0) {
+     : delete_threadmanager(false), tman(&tman_) {
         tman->init();
         main_task_executor = tman->get_worker(Options::ThreadingManagerType::MAIN_THREAD_ID);
      }
 
     SuperGlue(int req = -1)
-     : delete_threadmanager(true), tman(new ThreadingManager(req)), next_queue(0) {
+     : delete_threadmanager(true), tman(new ThreadingManager(req)) {
         main_task_executor = tman->get_worker(Options::ThreadingManagerType::MAIN_THREAD_ID);
     }
 
@@ -127,28 +279,87 @@ public:
     // USER INTERFACE {
 
     void submit(TaskBase<Options> *task) {
-        submit(task, next_queue);
-        // data race here when multiple threads submit tasks, but it
-        // is not important that the distribution is perfectly even.
-        next_queue = (next_queue + 1) % get_num_cpus();
+        submit(task, submit_policy.select_queue(*tman, task));
     }
 
     void submit(TaskBase<Options> *task, int cpuid) {
+        if (this->capture_task(task, cpuid))
+            return;
         tman->get_worker(cpuid)->submit(task);
     }
 
+    // submit a range of tasks. ready tasks are added with one push per
+    // queue, and idle workers are signalled once.
+    template<typename Iterator>
+    void submit_batch(Iterator first, Iterator last) {
+        const int num_queues(get_num_cpus());
+        typename Types<Options>::template vector_t<TaskQueueUnsafe>::type ready(static_cast<size_t>(num_queues));
+        size_t num_ready = 0;
+        for (; first != last; ++first) {
+            TaskBase<Options> *task(*first);
+            const int queue(submit_policy.select_queue(*tman, task));
+            if (this->capture_task(task, queue))
+                continue;
+            if (!TaskExecutor<Options>::prepare_submit(task))
+                continue;
+            ready[static_cast<size_t>(queue)].push_back(task);
+            ++num_ready;
+        }
+        push_ready(ready, num_ready);
+    }
+
+    // run a captured task graph again (requires Option TaskGraphs)
+    void replay(TaskGraph<Options> &graph) {
+        typename Types<Options>::template vector_t<TaskQueueUnsafe>::type ready(static_cast<size_t>(get_num_cpus()));
+        push_ready(ready, graph.start(ready));
+    }
+
+    // Wait until all tasks have finished. May be called from the main thread
+    // or from threads outside this runtime, but not from inside a task.
+    // Other threads sleep while the workers run the tasks, or run the tasks
+    // themselves in a runtime with a single thread. With Stealing disabled,
+    // tasks in the queue of the main thread only run when the main thread
+    // takes part, in a barrier() or wait() of its own, and other threads
+    // sleep until it has.
     void barrier() {
-        tman->barrier_protocol.barrier(*main_task_executor);
+        TaskExecutor<Options> *te(TaskExecutor<Options>::get_current(*tman));
+        assert(te == NULL || te == main_task_executor);
+        tman->barrier_protocol.barrier(te);
     }
 
+    // Wait until all tasks that access the handle have finished, including
+    // tasks submitted while waiting. May be called from any thread, see
+    // wait(TaskGroup).
     void wait(HandleBase<Options> &handle) {
-        TaskQueueUnsafe woken;
-        while (handle.next_version()-1 != handle.get_current_version()) {
-            main_task_executor->execute_tasks(woken);
-            Atomic::compiler_fence(); // to reload the handle versions
-        }
-        if (!woken.empty())
-            main_task_executor->push_front_list(woken);
+        wait_until(detail::WaitHandleIdle<Options>(handle));
+    }
+
+    // Wait until the handle has reached the given version. To wait for the
+    // tasks submitted so far, but not for later ones, use
+    // version = handle.next_version()-1 read after submitting.
+    void wait(HandleBase<Options> &handle, typename Options::version_type version) {
+        wait_until(detail::WaitHandleVersion<Options>(handle, version));
+    }
+
+    // submit a task as part of a group (requires Option TaskGroups)
+    void submit(TaskBase<Options> *task, TaskGroup<Options> &group) {
+        task->join_group(group);
+        submit(task);
+    }
+
+    // Wait until the tasks of the latest replay of the graph have finished.
+    // May be called from any thread, see wait(TaskGroup).
+    void wait(TaskGraph<Options> &graph) {
+        wait_until(detail::WaitGraphFinished<Options>(graph));
+    }
+
+    // Wait until all tasks in the group have finished. May be called from any
+    // thread. Workers of this runtime, including from inside a running task,
+    // and the main thread run other tasks while waiting, while other threads
+    // sleep, unless the runtime has a single thread (see barrier()). A task
+    // that waits must not have accesses that the tasks it waits for depend on.
+    void wait(TaskGroup<Options> &group) {
+        wait_until(detail::WaitGroupFinished<Options>(group));
     }
 
     // }
@@ -2,6 +2,10 @@
 #define SG_TASK_HPP_INCLUDED
 
 #include "sg/core/types.hpp"
+#include "sg/core/criticalpath.hpp"
+#include "sg/core/taskgraph.hpp"
+#include "sg/core/taskgroup.hpp"
+#include "sg/core/taskpool.hpp"
 #include "sg/platform/atomic.hpp"
 #include <string>
 #include <stdint.h>
@@ -14,6 +18,7 @@ template<typename Options> class Handle;
 template<typename Options> class Resource;
 template<typename Options> class TaskBase;
 template<typename Options> class TaskExecutor;
+template<typename Options> struct TaskAllocDefault;
 
 namespace detail {
 
@@ -23,18 +28,24 @@ namespace detail {
 template<typename Options, typename T = typename Options::TaskId> class Task_GlobalId;
 
 template<typename Options>
-class Task_GlobalId<Options, typename Options::Disable> {};
+class Task_GlobalId<Options, typename Options::Disable> {
+public:
+    void reset_global_id() {}
+};
 
 template<typename Options>
 class Task_GlobalId<Options, typename Options::Enable> {
     typedef typename Options::taskid_type taskid_type;
 private:
     taskid_type id;
-public:
-    Task_GlobalId() {
+    static taskid_type next_id() {
         static taskid_type global_task_id = 0;
-        id = Atomic::increase_nv(&global_task_id);
+        return Atomic::increase_nv(&global_task_id);
     }
+public:
+    Task_GlobalId() : id(next_id()) {}
+    // a recycled task is a new task
+    void reset_global_id() { id = next_id(); }
     taskid_type get_global_id() const { return id; }
 };
 
@@ -91,7 +102,10 @@ public:
 template<typename Options, typename T = typename Options::Subtasks> class Task_Subtasks;
 
 template<typename Options>
-class Task_Subtasks<Options, typename Options::Disable> {};
+class Task_Subtasks<Options, typename Options::Disable> {
+public:
+    void reset_subtasks() {}
+};
 
 template<typename Options>
 class Task_Subtasks<Options, typename Options::Enable> {
@@ -99,6 +113,76 @@ public:
     size_t subtask_count;
     TaskBase<Options> *parent;
     Task_Subtasks() : subtask_count(0), parent(NULL) {}
+    void reset_subtasks() {
+        subtask_count = 0;
+        parent = NULL;
+    }
+};
+
+// ============================================================================
+// Option DependencyCounting
+// ============================================================================
+template<typename Options, typename T = typename Options::DependencyCounting> class Task_DependencyCounting;
+
+// Waits for one access at a time: the task is added as a listener on the first
+// version that is not available, and is checked again from that access when
+// the version is reached.
+template<typename Options>
+class Task_DependencyCounting<Options, typename Options::Disable> {
+protected:
+    static bool dependencies_solved_or_notify(TaskBase<Options> *task, size_t &access_idx) {
+        const size_t num_access(task->get_num_access());
+        for (; access_idx < num_access; ++access_idx) {
+            Access<Options> &a(task->get_access(access_idx));
+            if (!a.get_handle()->is_version_available_or_notify(task, a.required_version)) {
+                ++access_idx; // We consider this dependency fulfilled now, as it will be when we get the callback.
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Waits for all accesses at once: each access that is not available is added
+// as a listener on its version, and the task counts the unresolved accesses.
+// The access that resolves the last dependency makes the task ready, so this
+// is only called once, when the task is submitted.
+template<typename Options>
+class Task_DependencyCounting<Options, typename Options::Enable> {
+public:
+    // accesses waiting for a version, plus one while the task is being registered
+    int unresolved;
+
+protected:
+    static bool dependencies_solved_or_notify(TaskBase<Options> *task, size_t &access_idx) {
+        const size_t num_access(task->get_num_access());
+        task->unresolved = static_cast<int>(num_access) + 1;
+        int resolved = 1;
+        for (; access_idx < num_access; ++access_idx) {
+            Access<Options> &a(task->get_access(access_idx));
+            a.set_waiting_task(task);
+            if (a.get_handle()->is_version_available_or_notify(&a, a.required_version))
+                ++resolved;
+        }
+        return Atomic::add_nv(&task->unresolved, -resolved) == 0;
+    }
+};
+
+// ============================================================================
+// Option TaskAllocator
+// ============================================================================
+template<typename Options, typename Alloc = typename Options::TaskAllocator> class Task_Allocator;
+
+template<typename Options>
+class Task_Allocator<Options, TaskAllocDefault<Options> > {};
+
+template<typename Options, typename Alloc>
+class Task_Allocator {
+public:
+    static void *operator new(size_t size) { return Alloc::allocate(size); }
+    static void operator delete(void *p) { Alloc::deallocate(p); }
+    static void *operator new(size_t, void *p) { return p; }
+    static void operator delete(void *, void *) {}
 };
 
 } // namespace detail
@@ -113,7 +197,14 @@ class TaskBaseDefault
     public detail::Task_GlobalId<Options>,
     public detail::Task_TaskName<Options>,
     public detail::Task_Contributions<Options>,
-    public detail::Task_Subtasks<Options>
+    public detail::Task_Subtasks<Options>,
+    public detail::Task_CriticalPath<Options>,
+    public detail::Task_Allocator<Options>,
+    public detail::Task_DependencyCounting<Options>,
+    public detail::Task_Group<Options>,
+    public detail::Task_Graph<Options>,
+    public detail::Task_Recycle<Options>,
+    public Options::SubmitPolicy::TaskData
 {
     template<typename, typename> friend class Task_PassThreadId;
     template<typename, typename> friend class Task_AccessData;
@@ -135,15 +226,18 @@ public:
     Access<Options> &get_access(size_t i) const { return access_ptr[i]; }
     bool are_dependencies_solved_or_notify() {
         TaskBase<Options> *this_(static_cast<TaskBase<Options> *>(this));
+        return detail::Task_DependencyCounting<Options>::dependencies_solved_or_notify(this_, access_idx);
+    }
 
-        for (; access_idx < num_access; ++access_idx) {
-
-            if (!access_ptr[access_idx].get_handle()->is_version_available_or_notify(this_, access_ptr[access_idx].required_version)) {
-                ++access_idx; // We consider this dependency fulfilled now, as it will be when we get the callback.
-                return false;
-            }
-        }
-        return true;
+    // forget the state of a finished task, so that it can be submitted again
+    void reset() {
+        num_access = 0;
+        access_idx = 0;
+        this->reset_global_id();
+        this->reset_subtasks();
+        this->reset_critical_path();
+        this->reset_group();
+        this->reset_graph();
     }
 };
 
@@ -172,11 +266,12 @@ public:
         a.required_version = version;
         if (AccessUtil<Options>::needs_lock(type))
             a.set_required_quantity(1);
+        a.set_writes(!AccessUtil<Options>::readonly(type));
         Options::LogDAG::add_dependency(static_cast<TaskBaseType *>(this), &handle, version, type);
         ++TaskBaseType::num_access;
     }
     void register_access(AccessType type, Handle<Options> &handle) {
-        fulfill(type, handle, handle.schedule(type));
+        fulfill(type, handle, detail::CriticalPath<Options>::schedule(this, handle, type));
     }
     void require(Resource<Options> &resource, lockcount_type quantity = 1) {
         Access<Options> &a(access[TaskBaseType::num_access]);
@@ -186,6 +281,12 @@ public:
         //Options::LogDAG::add_dependency(static_cast<TaskBaseType *>(this), &handle, version, type);
         ++TaskBaseType::num_access;
     }
+    // clear the accesses of a finished task, so that they can be registered again
+    void reset() {
+        for (size_t i = 0; i < TaskBaseType::num_access; ++i)
+            access[i] = Access<Options>(NULL, 0);
+        TaskBaseType::reset();
+    }
 };
 
 // Specialization for zero dependencies
@@ -193,6 +294,8 @@ template<typename Options, typename TaskBaseType>
 class TaskAccessMixin<Options, TaskBaseType, 0> : public TaskBaseType {};
 
 // Specialization for variable number of dependencies
+// The first Options::TaskInlineAccesses accesses are stored in the task, and
+// the accesses are moved to a vector only when there are more.
 template<typename Options, typename TaskBaseType>
 class TaskAccessMixin<Options, TaskBaseType, -1> : public TaskBaseType {
     typedef typename Options::AccessInfoType AccessInfo;
@@ -200,28 +303,53 @@ class TaskAccessMixin<Options, TaskBaseType, -1> : public TaskBaseType {
     typedef typename Types<Options>::template vector_t< Access<Options> >::type access_vector_t;
     typedef typename Options::version_type version_type;
     typedef typename Options::lockcount_type lockcount_type;
+    enum { num_inline = Options::TaskInlineAccesses };
+
+    Access<Options> &add_access(const Access<Options> &a) {
+        const size_t n(TaskBaseType::num_access);
+        ++TaskBaseType::num_access;
+        if (n < num_inline) {
+            inline_access[n] = a;
+            return inline_access[n];
+        }
+        if (n == num_inline) {
+            access.reserve(2 * num_inline);
+            access.assign(inline_access, inline_access + num_inline);
+        }
+        access.push_back(a);
+        TaskBase<Options>::access_ptr = &access[0]; // vector may be reallocated at any add
+        return access[n];
+    }
+
 protected:
-    access_vector_t access;
+    Access<Options> inline_access[num_inline];
+    access_vector_t access; // all accesses, if there are more than num_inline
 public:
+    TaskAccessMixin() {
+        TaskBaseType::access_ptr = &inline_access[0];
+    }
+
     void fulfill(AccessType type, Handle<Options> &handle, version_type version) {
-        access.push_back(Access<Options>(&handle, version));
-        Access<Options> &a(access[access.size()-1]);
+        Access<Options> &a(add_access(Access<Options>(&handle, version)));
         if (AccessUtil<Options>::needs_lock(type))
             a.set_required_quantity(1);
+        a.set_writes(!AccessUtil<Options>::readonly(type));
         Options::LogDAG::add_dependency(static_cast<TaskBaseType *>(this), &handle, version, type);
-        ++TaskBaseType::num_access;
-        TaskBase<Options>::access_ptr = &access[0]; // vector may be reallocated at any add
     }
 
     void register_access(AccessType type, Handle<Options> &handle) {
-        fulfill(type, handle, handle.schedule(type));
+        fulfill(type, handle, detail::CriticalPath<Options>::schedule(this, handle, type));
     }
     void require(Resource<Options> &resource, lockcount_type quantity = 1) {
-        access.push_back(Access<Options>(&resource, 0));
-        Access<Options> &a(access[access.size()-1]);
+        Access<Options> &a(add_access(Access<Options>(&resource, 0)));
         a.set_required_quantity(quantity);
-        ++TaskBaseType::num_access;
-        TaskBase<Options>::access_ptr = &access[0]; // vector may be reallocated at any add
+    }
+    // clear the accesses of a finished task, so that they can be registered
+    // again. the vector keeps its capacity.
+    void reset() {
+        access.clear();
+        TaskBaseType::reset();
+        TaskBaseType::access_ptr = &inline_access[0];
     }
 };
 
@@ -2,6 +2,13 @@
 #define SG_TASKEXECUTOR_HPP_INCLUDED
 
 #include "sg/platform/atomic.hpp"
+#include "sg/platform/platform.hpp"
+#include "sg/platform/threadutil.hpp"
+#include "sg/core/criticalpath.hpp"
+#include "sg/core/taskgraph.hpp"
+#include "sg/core/taskgroup.hpp"
+#include "sg/core/taskpool.hpp"
+#include <functional>
 #include <iostream>
 #include <cstdlib> // exit()
 #include <cstdio> // exit()
@@ -10,6 +17,7 @@ namespace sg {
 
 template<typename Options> class TaskBase;
 template<typename Options> class Access;
+template<typename Options> class Handle;
 template<typename Options> class SuperGlue;
 template<typename Options> class TaskExecutor;
 
@@ -163,6 +171,199 @@ public:
     }
 };
 
+// ============================================================================
+// Option LocalityRouting
+// Each handle remembers which worker last finished a task writing it. Tasks
+// woken by a finished task are queued at the worker that last wrote one of
+// their handles, since that worker's caches most likely still hold the data.
+// Tasks stay here if this worker wrote any of their handles. Routed tasks are
+// pushed to the front of the other worker's ready list, where its owner takes
+// them first. Thieves take tasks from the back, so they can still be stolen.
+// ============================================================================
+template<typename Options, typename T = typename Options::LocalityRouting> class TaskExecutor_Locality;
+
+template<typename Options>
+class TaskExecutor_Locality<Options, typename Options::Disable> {
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+public:
+    static void record_writer(Access<Options> &) {}
+    static void route_woken(TaskQueueUnsafe &) {}
+};
+
+template<typename Options>
+class TaskExecutor_Locality<Options, typename Options::Enable> {
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+
+    // worker whose caches most likely hold the data of the task, or -1
+    int get_preferred_worker(TaskBase<Options> *task, int id) {
+        int preferred = -1;
+        const size_t num_access = task->get_num_access();
+        for (size_t i = 0; i < num_access; ++i) {
+            const int writer = task->get_access(i).get_handle()->get_last_writer();
+            if (writer == id)
+                return id;
+            if (preferred == -1)
+                preferred = writer;
+        }
+        return preferred;
+    }
+
+public:
+    void record_writer(Access<Options> &access) {
+        TaskExecutor<Options> *this_(static_cast<TaskExecutor<Options> *>(this));
+        if (access.writes())
+            access.get_handle()->set_last_writer(this_->get_id());
+    }
+
+    void route_woken(TaskQueueUnsafe &woken) {
+        if (woken.empty())
+            return;
+        TaskExecutor<Options> *this_(static_cast<TaskExecutor<Options> *>(this));
+        const int id = this_->get_id();
+        const int num_queues = this_->get_threading_manager().get_num_cpus();
+        TaskQueue **queues = this_->get_threading_manager().get_task_queues();
+        TaskQueueUnsafe keep;
+        bool routed = false;
+        TaskBase<Options> *task;
+        while (woken.pop_front(task)) {
+            const int target = task->get_location() == -1 ? get_preferred_worker(task, id) : -1;
+            if (target == -1 || target == id || target >= num_queues) {
+                keep.push_back(task);
+                continue;
+            }
+            CriticalPath<Options>::ready(task);
+            // the owner takes tasks from the front, thieves from the back
+            queues[target]->push_front(task);
+            routed = true;
+        }
+        woken.swap(keep);
+        if (routed)
+            this_->get_threading_manager().barrier_protocol.signal_new_pinned_work();
+    }
+};
+
+// ============================================================================
+// Option OrderedLocking
+// Without it, the locks of a task are taken in the order the accesses were
+// registered. Tasks that lock overlapping handles in different orders can
+// then keep taking one lock each, failing on the other and releasing, over
+// and over. With it, all tasks take their locks in order of handle address,
+// so a task that fails to get a lock holds none that the current holder of
+// that lock can be waiting for.
+// On failure, all locks taken are released (including locks handed over by
+// LockHandoff), and the task waits for the lock it failed to get.
+// ============================================================================
+template<typename Options, typename T = typename Options::OrderedLocking> class TaskExecutor_LockOrder;
+
+template<typename Options>
+class TaskExecutor_LockOrderBase {
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+protected:
+    // Called when the task failed to get the lock of the access, and holds
+    // no other locks or grants. Returns false if the task now waits for the
+    // lock, or true if the lock was released meanwhile and the task should
+    // try again. Once the task is listening, the lock can be handed over to
+    // it and the task run by another worker, so it must not be touched.
+    static bool wait_for_lock(TaskBase<Options> *task, Access<Options> &access, TaskQueueUnsafe &woken) {
+        if (!access.get_lock_or_notify(task))
+            return false;
+        access.release_lock(woken);
+        return true;
+    }
+};
+
+template<typename Options>
+class TaskExecutor_LockOrder<Options, typename Options::Disable>
+  : private TaskExecutor_LockOrderBase<Options> {
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+public:
+    static bool try_lock(TaskBase<Options> *task, TaskQueueUnsafe &woken) {
+
+        const size_t num_access = task->get_num_access();
+        Access<Options> *access(task->get_access());
+        for (;;) {
+            size_t i = 0;
+            while (i < num_access && access[i].get_lock())
+                ++i;
+            if (i == num_access)
+                return true;
+
+            for (size_t j = 0; j < i; ++j)
+                access[i-j-1].release_lock(woken);
+            // locks handed over to later accesses must not be held while waiting
+            for (size_t j = i + 1; j < num_access; ++j)
+                access[j].release_grant(woken);
+            if (!TaskExecutor_LockOrder::wait_for_lock(task, access[i], woken))
+                return false;
+        }
+    }
+};
+
+template<typename Options>
+class TaskExecutor_LockOrder<Options, typename Options::Enable>
+  : private TaskExecutor_LockOrderBase<Options> {
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+
+    // lock order: handle address, then registration order
+    static bool before(Access<Options> *access, size_t i, size_t j) {
+        Handle<Options> *hi(access[i].get_handle());
+        Handle<Options> *hj(access[j].get_handle());
+        if (hi == hj)
+            return i < j;
+        return std::less<Handle<Options> *>()(hi, hj);
+    }
+
+    // take the locks in order. returns the access that failed, or
+    // num_access if all locks were taken.
+    static size_t lock_in_order(Access<Options> *access, size_t num_access) {
+        // tasks have few accesses, so find the next lock by scanning
+        // instead of sorting into a separate array.
+        size_t prev = num_access;
+        for (;;) {
+            size_t next = num_access;
+            for (size_t i = 0; i < num_access; ++i) {
+                if (!access[i].needs_lock())
+                    continue;
+                if (prev != num_access && !before(access, prev, i))
+                    continue;
+                if (next == num_access || before(access, i, next))
+                    next = i;
+            }
+            if (next == num_access || !access[next].get_lock())
+                return next;
+            prev = next;
+        }
+    }
+
+public:
+    static bool try_lock(TaskBase<Options> *task, TaskQueueUnsafe &woken) {
+
+        const size_t num_access = task->get_num_access();
+        Access<Options> *access(task->get_access());
+        for (;;) {
+            const size_t failed = lock_in_order(access, num_access);
+            if (failed == num_access)
+                return true;
+
+            for (size_t i = 0; i < num_access; ++i) {
+                if (i == failed || !access[i].needs_lock())
+                    continue;
+                if (before(access, i, failed))
+                    access[i].release_lock(woken);
+                else
+                    access[i].release_grant(woken);
+            }
+            if (!TaskExecutor_LockOrder::wait_for_lock(task, access[failed], woken))
+                return false;
+        }
+    }
+};
+
 } // namespace detail
 
 // ============================================================================
@@ -174,6 +375,7 @@ class TaskExecutorBase
     public detail::TaskExecutor_PassTaskExecutor<Options>,
     public detail::TaskExecutor_Stealing<Options>,
     public detail::TaskExecutor_Subtasks<Options>,
+    public detail::TaskExecutor_Locality<Options>,
     public Options::Instrumentation
 {
     template<typename, typename> friend class TaskExecutor_Stealing;
@@ -205,6 +407,7 @@ public:
                 const int location = task->get_location();
                 if (location != -1 && location != id) {
                     tman.get_task_queues()[location]->push_front(task);
+                    tman.barrier_protocol.signal_new_pinned_work();
                     continue;
                 }
 
@@ -226,13 +429,19 @@ public:
             TaskQueueUnsafe().swap(woken);
         }
 
+        TaskExecutor<Options> *this_(static_cast<TaskExecutor<Options> *>(this));
         Options::Instrumentation::run_task_before(task);
+        detail::CriticalPath<Options>::run_before(task);
+        Options::SubmitPolicy::run_before(*this_, task);
 
         detail::TaskExecutor_PassTaskExecutor<Options>::invoke_task_impl(task);
 
+        Options::SubmitPolicy::run_after(*this_, task);
+        detail::CriticalPath<Options>::run_after(task);
         Options::Instrumentation::run_task_after(task);
 
         detail::TaskExecutor_Subtasks<Options>::finished(task, woken);
+        detail::TaskExecutor_Locality<Options>::route_woken(woken);
     }
 
     bool run_contrib(TaskBase<Options> *task) {
@@ -258,31 +467,38 @@ public:
     }
 
     bool try_lock(TaskBase<Options> *task, TaskQueueUnsafe &woken) {
-
-        const size_t num_access = task->get_num_access();
-        Access<Options> *access(task->get_access());
-        for (size_t i = 0; i < num_access; ++i) {
-            if (!access[i].get_lock_or_notify(task)) {
-                for (size_t j = 0; j < i; ++j)
-                    access[i-j-1].release_lock(woken);
-                return false;
-            }
-        }
-        return true;
+        return detail::TaskExecutor_LockOrder<Options>::try_lock(task, woken);
     }
 
     void release_task(TaskBase<Options> *task, TaskQueueUnsafe &woken) {
+        detail::CriticalPath<Options>::finish(task);
         const size_t num_access = task->get_num_access();
         Access<Options> *access(task->get_access());
         for (size_t i = num_access; i > 0; --i) {
+            detail::TaskExecutor_Locality<Options>::record_writer(access[i - 1]);
             version_type ver = access[i - 1].finished(woken);
             Options::LogDAG::task_finish(task, access[i-1].get_handle(), ver);
         }
-        Options::FreeTask::free(task);
+        if (!detail::Task_Graph<Options>::finish_graph(task, woken)) {
+            detail::Task_Group<Options>::finish_group(task);
+            detail::Task_Recycle<Options>::free(task);
+        }
+        tman.barrier_protocol.notify_external_waiters_after_rmw();
     }
 
-    void submit_front(TaskBase<Options> *task) {
+    // returns true if the task is ready to be queued, and otherwise
+    // registers it to be woken when its dependencies are solved.
+    static bool prepare_submit(TaskBase<Options> *task) {
+        detail::CriticalPath<Options>::submit(task);
         if (!task->are_dependencies_solved_or_notify())
+            return false;
+
+        detail::CriticalPath<Options>::ready(task);
+        return true;
+    }
+
+    void submit_front(TaskBase<Options> *task) {
+        if (!prepare_submit(task))
             return;
 
         ready_list.push_front(task);
@@ -290,6 +506,7 @@ public:
     }
 
     void push_front_list(TaskQueueUnsafe &wake) {
+        detail::CriticalPath<Options>::ready_list(wake);
         ready_list.push_front_list(wake);
         tman.barrier_protocol.signal_new_work();
     }
@@ -297,27 +514,65 @@ public:
 public:
     bool terminate_flag;
     int my_barrier_state;
+    typename Options::IdlePolicy::ThreadState idle_state;
+    typename Options::SubmitPolicy::ThreadState submit_state;
 
+    // Executors are created on the thread they belong to
     TaskExecutorBase(int id_, ThreadingManager &tman_)
       : Options::Instrumentation(id_), id(id_), tman(tman_),
         terminate_flag(false), my_barrier_state(0)
     {
         TaskExecutor<Options> *this_(static_cast<TaskExecutor<Options> *>(this));
         this_->init_stealing();
+        current = this_;
+        thread_id = ThreadUtil::get_current_thread_id();
+    }
+
+    ~TaskExecutorBase() {
+        if (current == static_cast<TaskExecutor<Options> *>(this))
+            current = NULL;
+        // workers release their allocator state when leaving work_loop(),
+        // the main thread when its executor is destroyed
+        if (ThreadUtil::is_current_thread(thread_id))
+            Options::TaskAllocator::release_thread();
+    }
+
+    // The executor of the calling thread, or NULL if the thread does not
+    // belong to the given threading manager
+    static TaskExecutor<Options> *get_current(ThreadingManager &tman_) {
+        TaskExecutor<Options> *te(current);
+        if (te != NULL && &te->get_threading_manager() == &tman_)
+            return te;
+        // current only holds the latest executor created on this thread, so
+        // a thread that created several runtimes is found by its thread id
+        te = tman_.get_worker(ThreadingManager::MAIN_THREAD_ID);
+        if (ThreadUtil::is_current_thread(te->thread_id))
+            return te;
+        return NULL;
     }
 
     // Called from this thread only
     bool execute_tasks(TaskQueueUnsafe &woken) {
+        if (execute_task(woken))
+            return true;
+
+        TaskExecutor<Options> *this_(static_cast<TaskExecutor<Options> *>(this));
+        tman.barrier_protocol.idle_no_task(*this_);
+        return false;
+    }
+
+    // Called from this thread only.
+    // Run one task if there is any, without idling if there is not.
+    bool execute_task(TaskQueueUnsafe &woken) {
         for (;;) {
             TaskBase<Options> *task;
 
             if (!woken.pop_front(task)) {
                 task = get_task_internal();
-                if (task == 0) {
-                    Atomic::yield();
+                if (task == 0)
                     return false;
-                }
             }
+            idle_state.reset();
 
             // run with contributions, if that is activated
             if (run_contrib(task)) {
@@ -339,6 +594,7 @@ public:
     // Called from other threads
     void terminate() {
         terminate_flag = true;
+        tman.barrier_protocol.wake_all_idle();
     }
 
     void work_loop() {
@@ -348,15 +604,17 @@ public:
             while (execute_tasks(woken));
 
 			while (!tman.barrier_protocol.update_barrier_state(*this_))
-                Atomic::rep_nop();
+                tman.barrier_protocol.idle_in_barrier(*this_);
 
-			if (terminate_flag)
+			if (terminate_flag) {
+                Options::TaskAllocator::release_thread();
                 return;
+            }
         }
     }
 
     void submit(TaskBase<Options> *task) {
-        if (!task->are_dependencies_solved_or_notify())
+        if (!prepare_submit(task))
             return;
 
         ready_list.push_back(task);
@@ -366,8 +624,14 @@ public:
     TaskQueue &get_task_queue() { return ready_list; }
     int get_id() const { return id; }
     ThreadingManager &get_threading_manager() { return tman; }
+
+private:
+    ThreadIDType thread_id; // the thread this executor belongs to
+    static SG_TLS TaskExecutor<Options> *current;
 };
 
+template<typename Options> SG_TLS TaskExecutor<Options> *TaskExecutorBase<Options>::current = NULL;
+
 // export Options::TaskExecutorType as TaskExecutor (default: TaskExecutorBase<Options>)
 template<typename Options> class TaskExecutor : public Options::TaskExecutorType {
 public:
@@ -0,0 +1,319 @@
+#ifndef SG_TASKGRAPH_HPP_INCLUDED
+#define SG_TASKGRAPH_HPP_INCLUDED
+
+#include "sg/core/taskpool.hpp"
+#include "sg/core/types.hpp"
+#include "sg/platform/atomic.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <utility>
+
+namespace sg {
+
+template<typename Options> class Access;
+template<typename Options> class Handle;
+template<typename Options> class SchedulerVersion;
+template<typename Options> class TaskBase;
+
+namespace detail {
+template<typename Options, typename T> class Task_Graph;
+} // namespace detail
+
+// ============================================================================
+// TaskGraph: Tasks recorded once and run many times (Option TaskGraphs)
+//
+// Tasks submitted between SuperGlue::begin_capture(graph) and end_capture()
+// are not run, but stored in the graph. end_capture() turns the versions the
+// tasks were scheduled at into edges between the tasks. Each replay(graph)
+// then runs the same task objects again: it resets one counter per task and
+// queues the tasks without predecessors, and each finished task counts down
+// its successors. Tasks are not allocated, scheduled, registered as version
+// listeners or deleted again.
+//
+// The tasks still finish their accesses as usual, so handles stay consistent
+// and other tasks can be submitted on them between or during replays. The
+// handles must not have unfinished tasks when the capture starts, or when a
+// replay starts, and must not be used between the capture and the first
+// replay. Wait for a replay with wait(graph) or barrier() before the next.
+//
+// The graph owns its tasks and frees them when it is destroyed. Tasks in a
+// graph must not be in a TaskGroup, and tasks must be submitted from one
+// thread during the capture.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef Enable TaskGraphs;
+//   };
+//
+//   TaskGraph<Options> graph;
+//   sg.begin_capture(graph);
+//   step(sg); // submits tasks
+//   sg.end_capture();
+//   for (int i = 0; i < num_steps; ++i) {
+//       sg.replay(graph);
+//       sg.wait(graph);
+//   }
+// ============================================================================
+template<typename Options>
+class TaskGraph {
+    template<typename, typename> friend class detail::Task_Graph;
+    typedef typename Options::version_type version_type;
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+
+    enum { num_counters = SchedulerVersion<Options>::num_counters };
+
+    struct Node {
+        TaskBase<Options> *task;
+        int queue;              // queue the task was submitted to
+        int num_predecessors;
+        int unresolved;         // predecessors not yet finished in this replay
+        size_t first_successor; // index into successors
+        size_t num_successors;
+    };
+
+    // scheduling state of a handle after the captured tasks, relative to the
+    // version of the handle when they were captured
+    struct HandleState {
+        Handle<Options> *handle;
+        version_type state[num_counters];
+    };
+
+    // an access of a captured task, at a version relative to the handle
+    struct AccessRecord {
+        Handle<Options> *handle;
+        version_type level;
+        size_t node;
+        bool operator<(const AccessRecord &rhs) const {
+            if (handle != rhs.handle)
+                return std::less<Handle<Options> *>()(handle, rhs.handle);
+            return level < rhs.level;
+        }
+    };
+
+    typedef std::pair<size_t, size_t> edge_t;
+
+    typename Types<Options>::template vector_t<Node>::type nodes;
+    typename Types<Options>::template vector_t<size_t>::type successors;
+    typename Types<Options>::template vector_t<size_t>::type roots;
+    typename Types<Options>::template vector_t<HandleState>::type handles;
+    bool finalized;
+    size_t num_replays;
+    char padding1[Options::CACHE_LINE_SIZE];
+    int outstanding; // tasks of the current replay that have not finished
+    char padding2[Options::CACHE_LINE_SIZE];
+
+    TaskGraph(const TaskGraph &);
+    const TaskGraph &operator=(const TaskGraph &);
+
+    // version relative to base, or 0 if it was already reached
+    static version_type relative(version_type version, version_type base) {
+        const version_type rel(version - base);
+        if (rel > std::numeric_limits<version_type>::max() / 2)
+            return 0;
+        return rel;
+    }
+
+    void add_handle(Handle<Options> *handle) {
+        const version_type base(handle->get_current_version());
+        HandleState hs;
+        hs.handle = handle;
+        handle->required_version.get_state(hs.state);
+        for (size_t i = 0; i < num_counters; ++i)
+            hs.state[i] = relative(hs.state[i], base);
+        handles.push_back(hs);
+    }
+
+    // edges from each access to those at the previous level of the same handle
+    void add_edges(const AccessRecord *first, const AccessRecord *last,
+                   typename Types<Options>::template vector_t<edge_t>::type &edges) {
+        const AccessRecord *prev_begin(first);
+        const AccessRecord *prev_end(first);
+        while (first != last) {
+            const AccessRecord *level_end(first);
+            while (level_end != last && level_end->level == first->level)
+                ++level_end;
+            for (const AccessRecord *p = prev_begin; p != prev_end; ++p)
+                for (const AccessRecord *c = first; c != level_end; ++c)
+                    if (p->node != c->node)
+                        edges.push_back(edge_t(p->node, c->node));
+            prev_begin = first;
+            prev_end = level_end;
+            first = level_end;
+        }
+    }
+
+public:
+    TaskGraph() : finalized(false), num_replays(0), outstanding(0) {}
+
+    ~TaskGraph() {
+        assert(is_finished());
+        for (size_t i = 0; i < nodes.size(); ++i)
+            detail::Task_Recycle<Options>::free(nodes[i].task);
+    }
+
+    size_t get_num_tasks() const { return nodes.size(); }
+    size_t get_num_edges() const { return successors.size(); }
+
+    bool is_finished() const {
+        return *static_cast<const volatile int *>(&outstanding) == 0;
+    }
+
+    // Called by SuperGlue while capturing
+    void add(TaskBase<Options> *task, int queue) {
+        assert(!finalized);
+        task->graph = this;
+        task->graph_node = nodes.size();
+        Node node;
+        node.task = task;
+        node.queue = queue;
+        node.num_predecessors = 0;
+        node.unresolved = 0;
+        node.first_successor = 0;
+        node.num_successors = 0;
+        nodes.push_back(node);
+    }
+
+    // Called by SuperGlue when the capture ends. Access levels are the
+    // required versions relative to the current version of the handle. An
+    // access can run when all accesses at lower levels have finished, so it
+    // depends on the accesses at the nearest lower level.
+    void finalize() {
+        assert(!finalized);
+        typename Types<Options>::template vector_t<AccessRecord>::type records;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            TaskBase<Options> *task(nodes[i].task);
+            for (size_t j = 0; j < task->get_num_access(); ++j) {
+                Access<Options> &a(task->get_access(j));
+                AccessRecord record;
+                record.handle = a.get_handle();
+                record.level = relative(a.required_version, record.handle->get_current_version());
+                record.node = i;
+                records.push_back(record);
+            }
+        }
+        std::sort(records.begin(), records.end());
+
+        typename Types<Options>::template vector_t<edge_t>::type edges;
+        for (size_t begin = 0; begin < records.size(); ) {
+            size_t end = begin;
+            while (end < records.size() && records[end].handle == records[begin].handle)
+                ++end;
+            add_handle(records[begin].handle);
+            add_edges(&records[begin], &records[0] + end, edges);
+            begin = end;
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        // edges are sorted by predecessor, so the successors of each node
+        // are consecutive
+        successors.resize(edges.size());
+        for (size_t i = 0; i < edges.size(); ++i) {
+            Node &pred(nodes[edges[i].first]);
+            if (pred.num_successors == 0)
+                pred.first_successor = i;
+            ++pred.num_successors;
+            successors[i] = edges[i].second;
+            ++nodes[edges[i].second].num_predecessors;
+        }
+        for (size_t i = 0; i < nodes.size(); ++i)
+            if (nodes[i].num_predecessors == 0)
+                roots.push_back(i);
+        finalized = true;
+    }
+
+    // Called by SuperGlue::replay(): prepare to run all tasks again, and
+    // add the tasks that are ready at once to the queues they were
+    // submitted to. Returns the number of ready tasks.
+    size_t start(typename Types<Options>::template vector_t<TaskQueueUnsafe>::type &ready) {
+        assert(finalized && is_finished());
+
+        // schedule the accesses of the graph on each handle at once
+        for (size_t i = 0; i < handles.size(); ++i) {
+            Handle<Options> *handle(handles[i].handle);
+            const version_type current(handle->get_current_version());
+            assert(num_replays == 0 || handle->next_version()-1 == current);
+            version_type state[num_counters];
+            for (size_t j = 0; j < num_counters; ++j)
+                state[j] = current + handles[i].state[j];
+            handle->required_version.set_state(state);
+        }
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+            nodes[i].unresolved = nodes[i].num_predecessors;
+        outstanding = static_cast<int>(nodes.size());
+        ++num_replays;
+        Atomic::memory_fence_producer(); // counters must be visible before tasks run
+
+        for (size_t i = 0; i < roots.size(); ++i) {
+            const Node &node(nodes[roots[i]]);
+            ready[static_cast<size_t>(node.queue)].push_back(node.task);
+        }
+        return roots.size();
+    }
+
+    // Called when a task has finished: count down its successors
+    void finished(size_t index, TaskQueueUnsafe &woken) {
+        const Node &node(nodes[index]);
+        for (size_t i = 0; i < node.num_successors; ++i) {
+            Node &succ(nodes[successors[node.first_successor + i]]);
+            if (Atomic::decrease_nv(&succ.unresolved) == 0)
+                woken.push_back(succ.task);
+        }
+        Atomic::decrease(&outstanding);
+    }
+};
+
+namespace detail {
+
+// ============================================================================
+// Option TaskGraphs
+// ============================================================================
+template<typename Options, typename T = typename Options::TaskGraphs> class Task_Graph;
+
+template<typename Options>
+class Task_Graph<Options, typename Options::Disable> {
+    typedef typename Options::ReadyListType::unsafe_t TaskQueueUnsafe;
+public:
+    static bool finish_graph(TaskBase<Options> *, TaskQueueUnsafe &) { return false; }
+    void reset_graph() {}
+};
+
+template<typename Options>
+class Task_Graph<Options, typename Options::Enable> {
+    template<typename> friend class sg::TaskGraph;
+    typedef typename Options::ReadyListType::unsafe_t TaskQueueUnsafe;
+
+private:
+    TaskGraph<Options> *graph; // or NULL
+    size_t graph_node;
+
+public:
+    Task_Graph() : graph(NULL), graph_node(0) {}
+
+    void reset_graph() {
+        graph = NULL;
+        graph_node = 0;
+    }
+
+    // called when the task has finished and released its accesses. returns
+    // true if the task belongs to a graph, and must not be freed.
+    static bool finish_graph(TaskBase<Options> *task, TaskQueueUnsafe &woken) {
+        TaskGraph<Options> *graph(task->graph);
+        if (graph == NULL)
+            return false;
+        graph->finished(task->graph_node, woken);
+        return true;
+    }
+};
+
+} // namespace detail
+
+} // namespace sg
+
+#endif // SG_TASKGRAPH_HPP_INCLUDED
@@ -0,0 +1,92 @@
+#ifndef SG_TASKGROUP_HPP_INCLUDED
+#define SG_TASKGROUP_HPP_INCLUDED
+
+#include "sg/platform/atomic.hpp"
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+
+namespace detail {
+template<typename Options, typename T> class Task_Group;
+} // namespace detail
+
+// ============================================================================
+// TaskGroup: Tasks that can be waited for together (Option TaskGroups)
+//
+// Tasks join a group when submitted with SuperGlue::submit(task, group), and
+// SuperGlue::wait(group) returns when all of them have finished. A group can
+// be reused once it has been waited for, and must outlive its tasks.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef Enable TaskGroups;
+//   };
+//
+//   TaskGroup<Options> group;
+//   sg.submit(new MyTask(...), group);
+//   sg.wait(group);
+// ============================================================================
+template<typename Options>
+class TaskGroup {
+    template<typename, typename> friend class detail::Task_Group;
+
+private:
+    int outstanding; // tasks submitted and not yet finished
+    char padding[Options::CACHE_LINE_SIZE];
+
+    TaskGroup(const TaskGroup &);
+    const TaskGroup &operator=(const TaskGroup &);
+
+public:
+    TaskGroup() : outstanding(0) {}
+
+    bool is_finished() const {
+        return *static_cast<const volatile int *>(&outstanding) == 0;
+    }
+};
+
+namespace detail {
+
+// ============================================================================
+// Option TaskGroups
+// ============================================================================
+template<typename Options, typename T = typename Options::TaskGroups> class Task_Group;
+
+template<typename Options>
+class Task_Group<Options, typename Options::Disable> {
+public:
+    static void finish_group(TaskBase<Options> *) {}
+    void reset_group() {}
+};
+
+template<typename Options>
+class Task_Group<Options, typename Options::Enable> {
+private:
+    TaskGroup<Options> *group; // or NULL
+
+public:
+    Task_Group() : group(NULL) {}
+
+    void reset_group() { group = NULL; }
+
+    // called before the task is submitted
+    void join_group(TaskGroup<Options> &group_) {
+        group = &group_;
+        Atomic::increase(&group_.outstanding);
+    }
+
+    // called when the task has finished and released its accesses
+    static void finish_group(TaskBase<Options> *task) {
+        TaskGroup<Options> *group(task->group);
+        if (group != NULL)
+            Atomic::decrease(&group->outstanding);
+    }
+};
+
+} // namespace detail
+
+} // namespace sg
+
+#endif // SG_TASKGROUP_HPP_INCLUDED
@@ -0,0 +1,150 @@
+#ifndef SG_TASKPOOL_HPP_INCLUDED
+#define SG_TASKPOOL_HPP_INCLUDED
+
+#include "sg/core/spinlock.hpp"
+#include "sg/core/types.hpp"
+#include "sg/platform/atomic.hpp"
+
+#include <cassert>
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+
+namespace detail {
+template<typename Options, typename T> class Task_Recycle;
+} // namespace detail
+
+// ============================================================================
+// TaskPoolBase: Where finished tasks are returned (Option TaskRecycling)
+// ============================================================================
+template<typename Options>
+class TaskPoolBase {
+public:
+    // called by the worker that finished the task, instead of freeing it
+    virtual void recycle(TaskBase<Options> *task) = 0;
+
+protected:
+    virtual ~TaskPoolBase() {}
+};
+
+// ============================================================================
+// TaskPool: User-owned pool of tasks that are reused (Option TaskRecycling)
+//
+// get() returns a task that has finished and been reset(), or a new one if
+// there is none. The task is then set up and submitted as usual, and is
+// returned to the pool when it has finished, instead of being freed. After
+// the first time step, an iterative workload that takes its tasks from pools
+// allocates no tasks.
+//
+// TaskType must be default constructible, and register its accesses in a
+// method that is called after get() rather than in its constructor. The
+// pool must outlive its tasks, and deletes them when it is destroyed.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef Enable TaskRecycling;
+//   };
+//
+//   struct MyTask : public Task<Options, 1> {
+//       void setup(Handle<Options> &h) {
+//           register_access(ReadWriteAdd::write, h);
+//       }
+//       void run() { ... }
+//   };
+//
+//   TaskPool<Options, MyTask> pool;
+//   MyTask *task = pool.get();
+//   task->setup(h);
+//   sg.submit(task);
+// ============================================================================
+template<typename Options, typename TaskType>
+class TaskPool : public TaskPoolBase<Options> {
+private:
+    SpinLock lock;
+    typename Types<Options>::template vector_t<TaskType *>::type finished; // protected by lock
+    char padding[Options::CACHE_LINE_SIZE];
+    int num_tasks; // tasks created by this pool
+
+    TaskPool(const TaskPool &);
+    const TaskPool &operator=(const TaskPool &);
+
+public:
+    TaskPool() : num_tasks(0) {}
+
+    ~TaskPool() {
+        assert(finished.size() == static_cast<size_t>(num_tasks));
+        for (size_t i = 0; i < finished.size(); ++i)
+            delete finished[i];
+    }
+
+    // a task ready to be set up and submitted
+    TaskType *get() {
+        TaskType *task(NULL);
+        {
+            SpinLockScoped hold(lock);
+            if (!finished.empty()) {
+                task = finished.back();
+                finished.pop_back();
+            }
+        }
+        if (task == NULL) {
+            task = new TaskType();
+            task->pool = this;
+            Atomic::increase(&num_tasks);
+            return task;
+        }
+        task->reset();
+        return task;
+    }
+
+    void recycle(TaskBase<Options> *task) {
+        SpinLockScoped hold(lock);
+        finished.push_back(static_cast<TaskType *>(task));
+    }
+
+    // tasks created by this pool, finished or not
+    size_t get_num_tasks() const { return static_cast<size_t>(num_tasks); }
+};
+
+namespace detail {
+
+// ============================================================================
+// Option TaskRecycling
+// ============================================================================
+template<typename Options, typename T = typename Options::TaskRecycling> class Task_Recycle;
+
+template<typename Options>
+class Task_Recycle<Options, typename Options::Disable> {
+public:
+    static void free(TaskBase<Options> *task) {
+        Options::FreeTask::free(task);
+    }
+};
+
+template<typename Options>
+class Task_Recycle<Options, typename Options::Enable> {
+    template<typename, typename> friend class sg::TaskPool;
+
+private:
+    TaskPoolBase<Options> *pool; // or NULL
+
+public:
+    Task_Recycle() : pool(NULL) {}
+
+    // return a finished task to its pool, or free it if it has none
+    static void free(TaskBase<Options> *task) {
+        TaskPoolBase<Options> *pool(task->pool);
+        if (pool != NULL)
+            pool->recycle(task);
+        else
+            Options::FreeTask::free(task);
+    }
+};
+
+} // namespace detail
+
+} // namespace sg
+
+#endif // SG_TASKPOOL_HPP_INCLUDED
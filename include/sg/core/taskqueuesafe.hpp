@@ -8,8 +8,10 @@
 // push_back
 // push_front
 // push_front_list
+// push_back_list
 // pop_back
 // pop_front
+// pop_back_half (only if supported by the unsafe queue)
 // empty
 // empty_safe
 // swap
@@ -35,6 +37,21 @@ public:
     void unlock() { spinlock.unlock(); }
 };
 
+// unpadded lock, for queues embedded in each handle
+class QueueSpinLockedCompact {
+    SpinLockCompact spinlock;
+
+public:
+    struct ScopedLockHolder : public SpinLockScoped {
+        ScopedLockHolder(QueueSpinLockedCompact &qsl) : SpinLockScoped(qsl.spinlock) {}
+    };
+    struct ScopedLockHolderTry : public SpinLockTryLock {
+        ScopedLockHolderTry(QueueSpinLockedCompact &qsl) : SpinLockTryLock(qsl.spinlock) {}
+    };
+    void lock() { spinlock.lock(); }
+    void unlock() { spinlock.unlock(); }
+};
+
 template<typename TaskQueueUnsafe, typename LockType>
 class TaskQueueSafe {
     template<typename, typename> friend class Log_DumpState;
@@ -78,6 +95,12 @@ public:
         queue.push_front_list(list);
     }
 
+    // takes ownership of input list
+    void push_back_list(TaskQueueUnsafe &list) {
+        ScopedLockHolder hold(queuelock);
+        queue.push_back_list(list);
+    }
+
     bool pop_front(value_type * &elem) {
         ScopedLockHolder hold(queuelock);
         return queue.pop_front(elem);
@@ -90,6 +113,15 @@ public:
         return queue.pop_back(elem);
     }
 
+    // moves up to half of the tasks (at most max_count) from the back of this
+    // queue to dest, with a single lock acquisition. returns the number moved.
+    size_t pop_back_half(TaskQueueUnsafe &dest, size_t max_count) {
+        if (queue.empty())
+            return 0;
+        ScopedLockHolder hold(queuelock);
+        return queue.pop_back_half(dest, max_count);
+    }
+
     bool try_steal(value_type * &elem) {
         ScopedLockHolderTry hold(queuelock);
         if (!hold.success)
@@ -132,6 +164,8 @@ public:
         tq.unlock();
     }
     void push_back(value_type *elem) { tq.get_unsafe_queue().push_back(elem); }
+    void push_front(value_type *elem) { tq.get_unsafe_queue().push_front(elem); }
+    bool pop_front(value_type * &elem) { return tq.get_unsafe_queue().pop_front(elem); }
     void swap(typename TaskQueueType::unsafe_t &rhs) { tq.get_unsafe_queue().swap(rhs); }
     bool empty() { return tq.get_unsafe_queue().empty(); }
 };
@@ -80,6 +80,22 @@ public:
         }
     }
 
+    // takes ownership of input list
+    void push_back_list(TaskQueueDefaultUnsafe &rhs) {
+        if (rhs.first == 0)
+            return;
+        if (first == 0) {
+            first = rhs.first;
+            last = rhs.last;
+        }
+        else {
+            last->nextPrev ^= reinterpret_cast<uintptr_t>(rhs.first);
+            rhs.first->nextPrev ^= reinterpret_cast<uintptr_t>(last);
+            last = rhs.last;
+        }
+        rhs.first = rhs.last = 0;
+    }
+
     bool pop_front(TaskBase<Options> * &elem) {
         if (first == 0)
             return false;
@@ -108,6 +124,51 @@ public:
         return true;
     }
 
+    // moves up to half of the elements (at least one, at most max_count) from
+    // the back of this list to the front of dest, keeping their order.
+    // walks from both ends, so the cost is proportional to the number moved.
+    size_t pop_back_half(TaskQueueDefaultUnsafe &dest, size_t max_count) {
+        if (last == 0 || max_count == 0)
+            return 0;
+
+        TaskBase<Options> *front(first);
+        TaskBase<Options> *front_prev(0);
+        TaskBase<Options> *back(last);
+        TaskBase<Options> *back_next(0);
+        size_t count = 1;
+
+        for (; count < max_count; ++count) {
+            TaskBase<Options> *front_next = reinterpret_cast<TaskBase<Options> *>(
+                reinterpret_cast<uintptr_t>(front_prev) ^ front->nextPrev);
+            front_prev = front;
+            front = front_next;
+
+            TaskBase<Options> *candidate = reinterpret_cast<TaskBase<Options> *>(
+                reinterpret_cast<uintptr_t>(back_next) ^ back->nextPrev);
+            if (candidate == front || candidate == front_prev)
+                break;
+            back_next = back;
+            back = candidate;
+        }
+
+        TaskQueueDefaultUnsafe stolen;
+        stolen.first = back;
+        stolen.last = last;
+
+        TaskBase<Options> *new_last = reinterpret_cast<TaskBase<Options> *>(
+            reinterpret_cast<uintptr_t>(back_next) ^ back->nextPrev);
+        if (new_last == 0)
+            first = last = 0;
+        else {
+            new_last->nextPrev ^= reinterpret_cast<uintptr_t>(back);
+            back->nextPrev ^= reinterpret_cast<uintptr_t>(new_last);
+            last = new_last;
+        }
+
+        dest.push_front_list(stolen);
+        return count;
+    }
+
     template<typename Visitor>
     void visit(Visitor &visitor) {
 
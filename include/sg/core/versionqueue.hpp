@@ -6,27 +6,27 @@
 #include "sg/core/spinlock.hpp"
 #include "sg/platform/atomic.hpp"
 #include <limits>
+#include <stdint.h>
 
 namespace sg {
 
+template<typename Options> class Access;
 template<typename Options> class TaskBase;
 template<typename Options> class TaskExecutor;
 
-template <typename Options>
-class VersionQueue {
-    template<typename> friend class VersionQueueExclusive;
-private:
-    typedef typename Options::version_type version_type;
-    typedef typename Options::WaitListType WaitListType;
-    typedef typename WaitListType::unsafe_t TaskQueueUnsafe;
-    typedef elem_t<version_type, TaskQueueUnsafe> vecelem_t;
-    typedef typename Types<Options>::template deque_t<vecelem_t>::type elemdeque_t;
-    typedef ordered_vec_t< elemdeque_t, version_type, TaskQueueUnsafe> versionmap_t;
+namespace detail {
 
-    // lock that must be held during usage of the listener list, and when unlocking
-    SpinLock version_listener_spinlock;
-    // version listeners, per version
-    versionmap_t version_listeners;
+// ============================================================================
+// Option: DependencyCounting
+// What waits for a version, and how it is woken
+// ============================================================================
+template<typename Options, typename T = typename Options::DependencyCounting> class VersionListeners;
+
+// Tasks wait, linked into a task list. A woken task continues checking its
+// remaining dependencies, and may be added as a listener on another version.
+template<typename Options>
+class VersionListeners<Options, typename Options::Disable> {
+    typedef typename Options::WaitListType::unsafe_t TaskQueueUnsafe;
 
     struct DependenciesNotSolvedPredicate {
         bool operator()(TaskBase<Options> *elem) {
@@ -34,60 +34,367 @@ private:
         }
     };
 
+public:
+    typedef TaskBase<Options> listener_t;
+    typedef TaskQueueUnsafe list_t;
+
+    static void add(list_t &list, listener_t *task) { list.push_back(task); }
+
+    static void wake(list_t &list, TaskQueueUnsafe &woken) {
+        // iterate through list and remove elements that are not ready
+        list.erase_if(DependenciesNotSolvedPredicate());
+        if (!list.empty())
+            woken.push_front_list(list);
+    }
+};
+
+// Accesses wait, so that a task can wait for several versions at once.
+// Waking an access decreases the count of unresolved accesses of its task,
+// and the task is ready when that count reaches zero.
+template<typename Options>
+class VersionListeners<Options, typename Options::Enable> {
+    typedef typename Options::WaitListType::unsafe_t TaskQueueUnsafe;
+
+public:
+    typedef Access<Options> listener_t;
+    struct list_t {
+        listener_t *first;
+        listener_t *last;
+        list_t() : first(NULL), last(NULL) {}
+    };
+
+    static void add(list_t &list, listener_t *access) {
+        access->next_waiting = NULL;
+        if (list.last == NULL)
+            list.first = access;
+        else
+            list.last->next_waiting = access;
+        list.last = access;
+    }
+
+    static void wake(list_t &list, TaskQueueUnsafe &woken) {
+        for (listener_t *access = list.first; access != NULL; ) {
+            // the access may be freed with its task once the count is decreased
+            listener_t *next(access->next_waiting);
+            TaskBase<Options> *task(access->get_waiting_task());
+            if (Atomic::decrease_nv(&task->unresolved) == 0)
+                woken.push_front(task);
+            access = next;
+        }
+    }
+};
+
+// ============================================================================
+// Option: CompactHandle
+// Storage of the version listeners
+// ============================================================================
+template<typename Options, typename VersionMap, typename T = typename Options::CompactHandle> class VersionQueue_Listeners;
+
+template<typename Options, typename VersionMap>
+class VersionQueue_Listeners<Options, VersionMap, typename Options::Disable> {
+private:
+    VersionMap version_listeners;
+protected:
+    // returns the listeners, or NULL if there are none
+    VersionMap *find_listeners() { return &version_listeners; }
+    VersionMap &get_listeners() { return version_listeners; }
+    // returns the listeners to free if they were emptied, or NULL
+    VersionMap *release_if_empty() { return NULL; }
+};
+
+// Allocate the listeners when the first task has to wait, and free them when
+// they are emptied, so that handles that no task waits on stay small.
+template<typename Options, typename VersionMap>
+class VersionQueue_Listeners<Options, VersionMap, typename Options::Enable> {
+private:
+    VersionMap *version_listeners;
+
+    VersionQueue_Listeners(const VersionQueue_Listeners &);
+    const VersionQueue_Listeners &operator=(const VersionQueue_Listeners &);
+
 protected:
-    SpinLock &get_lock() { return version_listener_spinlock; }
-    void add_version_listener(TaskBase<Options> *task, version_type version) {
-        version_listeners[version].push_back(task);
+    VersionQueue_Listeners() : version_listeners(NULL) {}
+    ~VersionQueue_Listeners() { delete version_listeners; }
+
+    VersionMap *find_listeners() { return version_listeners; }
+    VersionMap &get_listeners() {
+        if (version_listeners == NULL)
+            version_listeners = new VersionMap;
+        return *version_listeners;
+    }
+    VersionMap *release_if_empty() {
+        VersionMap *listeners(version_listeners);
+        if (listeners == NULL || !listeners->empty())
+            return NULL;
+        version_listeners = NULL;
+        return listeners;
     }
+};
+
+template<typename Options>
+struct VersionQueueTypes {
+    typedef typename Options::version_type version_type;
+    typedef typename VersionListeners<Options>::list_t list_t;
+    typedef elem_t<version_type, list_t> vecelem_t;
+    typedef typename Types<Options>::template deque_t<vecelem_t>::type elemdeque_t;
+    typedef ordered_vec_t< elemdeque_t, version_type, list_t> versionmap_t;
+};
+
+// is version "required" available when the current version is "current"
+template<typename version_type>
+bool version_available(version_type current, version_type required) {
+    return (version_type)(current - required) < std::numeric_limits<version_type>::max() / 2;
+}
+
+// ============================================================================
+// VersionQueueLocked: listeners in an ordered map, protected by a spinlock
+// ============================================================================
+template <typename Options>
+class VersionQueueLocked
+ : public VersionQueue_Listeners<Options, typename VersionQueueTypes<Options>::versionmap_t>
+{
+private:
+    typedef typename Options::version_type version_type;
+    typedef typename Options::WaitListType WaitListType;
+    typedef typename WaitListType::unsafe_t TaskQueueUnsafe;
+    typedef typename VersionQueueTypes<Options>::versionmap_t versionmap_t;
+    typedef typename HandleSpinLock<Options>::type LockType;
+    typedef VersionListeners<Options> Listeners;
+    typedef typename Listeners::listener_t listener_t;
+    typedef typename Listeners::list_t list_t;
+
+    // lock that must be held during usage of the listener list, and when unlocking
+    LockType version_listener_spinlock;
 
 public:
-    void notify_version_listeners(TaskQueueUnsafe &woken, version_type version) {
+    // returns true if the required version is available, and otherwise adds
+    // the listener to be notified when it is. current is the handle version.
+    bool is_version_available_or_add_listener(listener_t *listener, version_type required,
+                                              const version_type &current) {
+        SpinLockScoped hold(version_listener_spinlock);
+        if (version_available(current, required))
+            return true;
+        Listeners::add(this->get_listeners()[required], listener);
+        return false;
+    }
+
+    void notify_version_listeners(TaskQueueUnsafe &woken, version_type version, const version_type &) {
 
         for (;;) {
-            TaskQueueUnsafe list;
+            list_t list;
+            versionmap_t *emptied;
             {
                 SpinLockScoped hold(version_listener_spinlock);
 
+                versionmap_t *version_listeners(this->find_listeners());
+
                 // return if there are no version listeners
-                if (version_listeners.empty())
+                if (version_listeners == NULL || version_listeners->empty())
                     return;
 
                 // return if next version listener is for future version
 
-                if ((version_type)(version - version_listeners.first_key()) >= std::numeric_limits<version_type>::max() / 2)
+                if (!version_available(version, version_listeners->first_key()))
                     return;
 
-                list = version_listeners.pop_front();
+                list = version_listeners->pop_front();
+                emptied = this->release_if_empty();
             }
+            delete emptied;
 
             // Note that a version is increased while holding a lock, and adding a
             // version listener requires holding the same lock. Hence, it is not
             // possible to add a listener for an old version here.
             // The version number is already increased when we wake tasks.
 
-            // iterate through list and remove elements that are not ready
-
-            list.erase_if(DependenciesNotSolvedPredicate());
-
-            if (!list.empty())
-                woken.push_front_list(list);
+            Listeners::wake(list, woken);
         }
     }
 };
 
-template<typename Options>
-class VersionQueueExclusive {
+// ============================================================================
+// VersionQueueRing: lock-free listener stacks in a ring indexed by version
+//
+// Each slot of the ring holds a stack of accesses waiting for one version.
+// Accesses are pushed with a compare-and-swap, and reaching a version takes
+// the whole stack with another, so tasks that wait for the same version do
+// not serialize on a lock.
+//
+// A slot word is a pointer to the top access, with the low bits holding
+// the generation (version / VersionRing_size, modulo 4) that the slot is
+// used for, and a flag that is set when that version has been reached. An
+// access that finds a reached slot checks the handle version again, and
+// reuses the slot if its own version is not available.
+//
+// Accesses for versions more than VersionRing_size ahead of the current
+// version, or whose slot is still in use by another version, are kept in an
+// ordered map protected by a spinlock, as in VersionQueueLocked.
+//
+// Requires DependencyCounting, since the accesses are the listeners.
+// ============================================================================
+template <typename Options>
+class VersionQueueRing
+ : public VersionQueue_Listeners<Options, typename VersionQueueTypes<Options>::versionmap_t>
+{
+private:
     typedef typename Options::version_type version_type;
+    typedef typename Options::WaitListType WaitListType;
+    typedef typename WaitListType::unsafe_t TaskQueueUnsafe;
+    typedef typename VersionQueueTypes<Options>::versionmap_t versionmap_t;
+    typedef typename HandleSpinLock<Options>::type LockType;
+    typedef VersionListeners<Options> Listeners;
+    typedef typename Listeners::listener_t listener_t;
+    typedef typename Listeners::list_t list_t;
+
+    enum { RING_SIZE = Options::VersionRing_size };
+    enum { REACHED = 1, FLAGS = 7 };
+
+public:
+    // the flags are stored in the low bits of the listener pointers
+    enum { LISTENER_ALIGNMENT = FLAGS + 1 };
+
 private:
-    VersionQueue<Options> &queue;
-    SpinLockScoped lock;
+
+    uintptr_t slots[RING_SIZE];
+    // number of listeners in the ordered map, to avoid locking when it is empty
+    int num_overflow;
+    // lock that must be held during usage of the ordered map
+    LockType overflow_lock;
+
+    VersionQueueRing(const VersionQueueRing &);
+    const VersionQueueRing &operator=(const VersionQueueRing &);
+
+    static uintptr_t get_tag(version_type version) {
+        return static_cast<uintptr_t>((version / RING_SIZE) & 3) << 1;
+    }
+    static listener_t *get_top(uintptr_t slot) {
+        return reinterpret_cast<listener_t *>(slot & ~static_cast<uintptr_t>(FLAGS));
+    }
+    static version_type load(const version_type &v) {
+        return *static_cast<const volatile version_type *>(&v);
+    }
+
+    bool add_overflow(listener_t *listener, version_type required, const version_type &current) {
+        Atomic::increase(&num_overflow);
+        SpinLockScoped hold(overflow_lock);
+        if (version_available(load(current), required)) {
+            Atomic::decrease(&num_overflow);
+            return true;
+        }
+        Listeners::add(this->get_listeners()[required], listener);
+        return false;
+    }
+
+    void notify_overflow(TaskQueueUnsafe &woken, version_type version) {
+        if (*static_cast<volatile int *>(&num_overflow) == 0)
+            return;
+
+        for (;;) {
+            list_t list;
+            versionmap_t *emptied;
+            {
+                SpinLockScoped hold(overflow_lock);
+                versionmap_t *version_listeners(this->find_listeners());
+                if (version_listeners == NULL || version_listeners->empty())
+                    return;
+                if (!version_available(version, version_listeners->first_key()))
+                    return;
+                list = version_listeners->pop_front();
+                emptied = this->release_if_empty();
+            }
+            delete emptied;
+
+            int count = 0;
+            for (listener_t *a = list.first; a != NULL; a = a->next_waiting)
+                ++count;
+            Atomic::add_nv(&num_overflow, -count);
+            Listeners::wake(list, woken);
+        }
+    }
+
 public:
-    VersionQueueExclusive(VersionQueue<Options> &queue_) : queue(queue_), lock(queue.get_lock()) {}
-    void add_version_listener(TaskBase<Options> *task, version_type version) {
-        queue.add_version_listener(task, version);
+    VersionQueueRing() : num_overflow(0) {
+        // mark all slots as reached, for a generation that is not yet in use
+        for (size_t i = 0; i < RING_SIZE; ++i)
+            slots[i] = get_tag(static_cast<version_type>(i + 3 * RING_SIZE)) | REACHED;
+    }
+
+    // returns true if the required version is available, and otherwise adds
+    // the listener to be notified when it is. current is the handle version.
+    bool is_version_available_or_add_listener(listener_t *listener, version_type required,
+                                              const version_type &current) {
+        // versions further ahead could share a slot with a version in use
+        if ((version_type)(required - load(current)) > RING_SIZE)
+            return add_overflow(listener, required, current);
+
+        uintptr_t *slot(&slots[required % RING_SIZE]);
+        const uintptr_t tag(get_tag(required));
+        for (;;) {
+            const uintptr_t old(*static_cast<volatile uintptr_t *>(slot));
+            if ((old & FLAGS) == tag) {
+                // slot is waiting for this version
+                listener->next_waiting = get_top(old);
+                if (Atomic::cas(slot, old, reinterpret_cast<uintptr_t>(listener) | tag) == old)
+                    return false;
+            }
+            else if ((old & REACHED) != 0) {
+                // the version of the slot is reached. if it was not this version, reuse the slot
+                if (version_available(load(current), required))
+                    return true;
+                listener->next_waiting = NULL;
+                if (Atomic::cas(slot, old, reinterpret_cast<uintptr_t>(listener) | tag) == old)
+                    return false;
+            }
+            else
+                return add_overflow(listener, required, current); // slot is in use by another version
+        }
+    }
+
+    // version is the version that was just reached
+    void notify_version_listeners(TaskQueueUnsafe &woken, version_type version, const version_type &current) {
+        uintptr_t *slot(&slots[version % RING_SIZE]);
+        const uintptr_t tag(get_tag(version));
+        for (;;) {
+            const uintptr_t old(*static_cast<volatile uintptr_t *>(slot));
+            if ((old & FLAGS) != tag && (old & REACHED) == 0)
+                break; // slot is in use by another version
+            if (Atomic::cas(slot, old, tag | REACHED) != old)
+                continue;
+            if ((old & FLAGS) != tag)
+                break;
+
+            // the stack may contain accesses for a version that is a multiple
+            // of 4*VersionRing_size away, which must be added again
+            list_t list;
+            for (listener_t *a = get_top(old); a != NULL; ) {
+                listener_t *next(a->next_waiting);
+                if (version_available(load(current), a->required_version)
+                    || is_version_available_or_add_listener(a, a->required_version, current))
+                    Listeners::add(list, a);
+                a = next;
+            }
+            Listeners::wake(list, woken);
+            break;
+        }
+        notify_overflow(woken, version);
     }
 };
 
+// ============================================================================
+// Option: LockFreeVersionQueue
+// ============================================================================
+template<typename Options, typename T = typename Options::LockFreeVersionQueue> class VersionQueue;
+
+template<typename Options>
+class VersionQueue<Options, typename Options::Disable> : public VersionQueueLocked<Options> {};
+
+template<typename Options>
+class VersionQueue<Options, typename Options::Enable> : public VersionQueueRing<Options> {};
+
+} // namespace detail
+
+template<typename Options> class VersionQueue : public detail::VersionQueue<Options> {};
+
 } // namespace sg
 
 #endif // SG_VERSIONQUEUE_HPP_INCLUDED
@@ -0,0 +1,100 @@
+#ifndef SG_BARRIER_TREE_HPP_INCLUDED
+#define SG_BARRIER_TREE_HPP_INCLUDED
+
+#include "sg/platform/atomic.hpp"
+
+// ============================================================================
+// BarrierCounterTree: Combining tree of barrier counters
+//
+// With the default BarrierCounterCentral, every worker decrements the same
+// counter in each stage of a barrier, and the cache line holding it moves
+// between all cores in turn. Here, workers are split into groups of Fanin,
+// and each group decrements its own counter. The last worker to arrive in a
+// group continues to the counter of the level above, and so on up to the
+// root. No counter is touched by more than Fanin workers per stage, and each
+// counter has its own cache line.
+//
+// Only the counting is changed: workers still execute tasks while in the
+// barrier, and are released by the barrier state shared by all, which is
+// only written once per stage.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef BarrierCounterTree<Options> BarrierCounter;
+//   };
+// ============================================================================
+
+namespace sg {
+
+template<typename Options, unsigned int Fanin = 4>
+class BarrierCounterTree {
+private:
+    struct Node {
+        unsigned int counter;   // arrivals left in this stage
+        unsigned int expected;  // arrivals per stage
+        Node *parent;           // NULL for root
+        char padding[Options::CACHE_LINE_SIZE];
+    };
+
+    Node *nodes;
+    unsigned int num_workers;
+
+    BarrierCounterTree(const BarrierCounterTree &);
+    const BarrierCounterTree &operator=(const BarrierCounterTree &);
+
+    static unsigned int num_groups(unsigned int n) { return (n + Fanin - 1) / Fanin; }
+
+public:
+    BarrierCounterTree() : nodes(NULL), num_workers(0) {}
+    ~BarrierCounterTree() { delete [] nodes; }
+
+    void init(unsigned int num_workers_) {
+        if (num_workers_ == num_workers)
+            return;
+        delete [] nodes;
+        num_workers = num_workers_;
+
+        // levels are stored leaves first, root last
+        unsigned int num_nodes = 0;
+        for (unsigned int n = num_groups(num_workers); ; n = num_groups(n)) {
+            num_nodes += n;
+            if (n == 1)
+                break;
+        }
+        nodes = new Node[num_nodes];
+
+        unsigned int level_start = 0;
+        unsigned int children = num_workers;
+        for (;;) {
+            const unsigned int n = num_groups(children);
+            for (unsigned int i = 0; i < n; ++i) {
+                Node &node(nodes[level_start + i]);
+                node.expected = (i + 1 < n) ? Fanin : children - i * Fanin;
+                node.counter = node.expected;
+                node.parent = (n == 1) ? NULL : &nodes[level_start + n + i / Fanin];
+            }
+            if (n == 1)
+                break;
+            level_start += n;
+            children = n;
+        }
+    }
+
+    bool arrive(int index) {
+        Node *node = &nodes[static_cast<unsigned int>(index) / Fanin];
+        for (;;) {
+            if (Atomic::decrease_nv(&node->counter) != 0)
+                return false;
+            // last in this group: reset for next stage and continue upwards
+            node->counter = node->expected;
+            if (node->parent == NULL)
+                return true;
+            node = node->parent;
+        }
+    }
+};
+
+} // namespace sg
+
+#endif // SG_BARRIER_TREE_HPP_INCLUDED
@@ -0,0 +1,115 @@
+#ifndef SG_IDLE_PARKING_HPP_INCLUDED
+#define SG_IDLE_PARKING_HPP_INCLUDED
+
+// ============================================================================
+// IdleParking: Let idle workers sleep
+//
+// A worker that finds nothing to do first spins for SpinRounds attempts,
+// then yields for YieldRounds attempts, and then sleeps on a futex until
+// new tasks are submitted, the barrier state changes, or it is terminated.
+// Finding a task starts over with spinning.
+//
+// Sleeping uses an event count: a worker reads the epoch, announces itself
+// as a sleeper, rechecks that all task queues are empty and the barrier state
+// has not changed, and then sleeps only if the epoch is unchanged. Wakers
+// publish their change, and only if there are sleepers do they increase the
+// epoch and issue a futex wake. Submitting a task when no worker sleeps thus
+// costs one memory fence.
+//
+// The main thread never sleeps.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef IdleParking<Options> IdlePolicy;
+//   };
+//
+// For latency critical runs, keep the default IdleSpin.
+// ============================================================================
+
+#include "sg/platform/atomic.hpp"
+#include "sg/platform/futex.hpp"
+
+namespace sg {
+
+template<typename Options> class BarrierProtocol;
+template<typename Options> class TaskExecutor;
+
+template<typename Options, unsigned int SpinRounds = 1000, unsigned int YieldRounds = 100>
+class IdleParking {
+private:
+    int epoch;        // increased by wakers when there are sleepers
+    char padding1[Options::CACHE_LINE_SIZE];
+    int sleepers;     // number of workers that are sleeping or about to
+    char padding2[Options::CACHE_LINE_SIZE];
+
+    IdleParking(const IdleParking &);
+    const IdleParking &operator=(const IdleParking &);
+
+    void park(BarrierProtocol<Options> &bp, TaskExecutor<Options> &te) {
+        const int ticket(*static_cast<volatile int *>(&epoch));
+        Atomic::increase(&sleepers); // full barrier: announce before checking for work
+        if (bp.may_sleep(te))
+            Futex::wait(&epoch, ticket);
+        Atomic::decrease(&sleepers);
+    }
+
+    void idle(BarrierProtocol<Options> &bp, TaskExecutor<Options> &te, unsigned int &rounds) {
+        if (te.get_id() == Options::ThreadingManagerType::MAIN_THREAD_ID) {
+            Atomic::yield();
+            return;
+        }
+        if (rounds < SpinRounds) {
+            ++rounds;
+            Atomic::rep_nop();
+        }
+        else if (rounds < SpinRounds + YieldRounds) {
+            ++rounds;
+            Atomic::yield();
+        }
+        else {
+            park(bp, te);
+            rounds = 0;
+        }
+    }
+
+    // returns false if there are no sleepers
+    bool new_epoch() {
+        Atomic::memory_fence(); // new work must be visible before reading sleepers
+        if (*static_cast<volatile int *>(&sleepers) == 0)
+            return false;
+        Atomic::increase(&epoch);
+        return true;
+    }
+
+public:
+    struct ThreadState {
+        unsigned int rounds;
+        ThreadState() : rounds(0) {}
+        void reset() { rounds = 0; }
+    };
+
+    IdleParking() : epoch(0), sleepers(0) {}
+
+    void no_task(BarrierProtocol<Options> &bp, TaskExecutor<Options> &te, ThreadState &ts) {
+        idle(bp, te, ts.rounds);
+    }
+    void in_barrier(BarrierProtocol<Options> &bp, TaskExecutor<Options> &te, ThreadState &ts) {
+        idle(bp, te, ts.rounds);
+    }
+    // number of workers currently sleeping (or about to)
+    int get_num_sleepers() const { return *static_cast<const volatile int *>(&sleepers); }
+
+    void wake_one() {
+        if (new_epoch())
+            Futex::wake(&epoch, 1);
+    }
+    void wake_all() {
+        if (new_epoch())
+            Futex::wake_all(&epoch);
+    }
+};
+
+} // namespace sg
+
+#endif // SG_IDLE_PARKING_HPP_INCLUDED
@@ -24,6 +24,7 @@ struct TaskRunDebug {
         fprintf(stderr, "%s\n", ss.str().c_str());
     }
     static void after_barrier() {}
+    static void tasks_stolen(int, size_t) {}
 };
 
 } // namespace sg
@@ -53,6 +53,7 @@ struct PerfTiming {
         Log<Options>::log(txt, start, stop);
     }
     static void after_barrier() {}
+    static void tasks_stolen(int, size_t) {}
 };
 
 } // namespace sg
@@ -42,6 +42,7 @@ struct PerfProcStat {
         Log<Options>::log((detail::GetName::get_name(task) + buffer).c_str(), start, stop);
     }
     static void after_barrier() {}
+    static void tasks_stolen(int, size_t) {}
 };
 
 } // namespace sg
@@ -29,6 +29,9 @@ struct Trace {
         Log<Options>::add_barrier_time(stop - start_idle_time);
 		start_idle_time = Time::getTime();
 	}
+    void tasks_stolen(int, size_t num) {
+        Log<Options>::add_steal(num);
+    }
     static void dump(const char *name) {
         Log<Options>::dump(name);
 	}
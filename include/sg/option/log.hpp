@@ -98,8 +98,13 @@ public:
         int id;
         Time::TimeUnit idle_time;
         Time::TimeUnit barrier_time;
+        size_t num_steals;
+        size_t num_stolen;
+        size_t max_steal_batch;
         std::vector<Event> events;
-        ThreadData(int id_) : id(id_), idle_time(0), barrier_time(0) {
+        ThreadData(int id_)
+        : id(id_), idle_time(0), barrier_time(0),
+          num_steals(0), num_stolen(0), max_steal_batch(0) {
             events.reserve(65536);
         }
     };
@@ -134,6 +139,14 @@ public:
         data.barrier_time += time;
     }
 
+    static void add_steal(size_t num_tasks) {
+        ThreadData &data(getThreadData());
+        ++data.num_steals;
+        data.num_stolen += num_tasks;
+        if (num_tasks > data.max_steal_batch)
+            data.max_steal_batch = num_tasks;
+    }
+
     static void dump(const char *filename, int node_id = 0) {
         std::ofstream out(filename);
         LogData &data(getLogData());
@@ -160,6 +173,10 @@ public:
             out << "# " << i << ": idle= " << data.threaddata[i]->idle_time << std::endl;
         for (size_t i = 0; i < num; ++i)
             out << "# " << i << ": barrier= " << data.threaddata[i]->barrier_time << std::endl;
+        for (size_t i = 0; i < num; ++i)
+            out << "# " << i << ": steals= " << data.threaddata[i]->num_steals
+                << " stolen= " << data.threaddata[i]->num_stolen
+                << " maxbatch= " << data.threaddata[i]->max_steal_batch << std::endl;
 
         out.close();
     }
@@ -0,0 +1,83 @@
+#ifndef SG_STEALORDER_HALF_HPP_INCLUDED
+#define SG_STEALORDER_HALF_HPP_INCLUDED
+
+// ============================================================================
+// StealHalfOrder: Steal up to half of the victim's queue at once
+//
+// Victims are searched in the same order as in DefaultStealOrder, but instead
+// of moving a single task, a batch of up to half of the victim's queue (at
+// most MaxBatch tasks) is moved with one lock acquisition. One task is
+// returned to be executed, and the rest are spliced into the front of the
+// thief's own ready list using push_front_list(), where they can in turn be
+// stolen by others.
+//
+// Requires that the ReadyListType implements pop_back_half().
+//
+// Each successful steal is reported to the instrumentation as
+// tasks_stolen(victim, number_of_tasks).
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef StealHalfOrder<Options> StealOrder;
+//   };
+// ============================================================================
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+template<typename Options> class TaskExecutor;
+
+template<typename Options, size_t MaxBatch = 64>
+class StealHalfOrder {
+    typedef typename Options::ReadyListType TaskQueue;
+    typedef typename TaskQueue::unsafe_t TaskQueueUnsafe;
+private:
+    TaskExecutor<Options> *parent;
+    size_t seed;
+
+    bool steal_from(TaskQueue **taskQueues, size_t victim, size_t id, TaskBase<Options> *&dest) {
+        TaskQueueUnsafe stolen;
+        const size_t num = taskQueues[victim]->pop_back_half(stolen, MaxBatch);
+        if (num == 0)
+            return false;
+
+        stolen.pop_front(dest);
+        if (num > 1)
+            taskQueues[id]->push_front_list(stolen);
+
+        parent->tasks_stolen(static_cast<int>(victim), num);
+        return true;
+    }
+
+public:
+    void init(TaskExecutor<Options> *parent_) {
+        parent = parent_;
+        seed = (size_t) parent->id;
+    }
+
+    bool steal(typename Options::ThreadingManagerType &tman, size_t id, TaskBase<Options> *&dest) {
+        TaskQueue **taskQueues = tman.get_task_queues();
+        const size_t num_queues(tman.get_num_cpus());
+        seed = seed * 1664525 + 1013904223;
+        const size_t random(seed % num_queues);
+
+        for (size_t i = random; i < num_queues; ++i) {
+            if (i == id)
+                continue;
+            if (steal_from(taskQueues, i, id, dest))
+                return true;
+        }
+        for (size_t i = 0; i < random; ++i) {
+            if (i == id)
+                continue;
+            if (steal_from(taskQueues, i, id, dest))
+                return true;
+        }
+        return false;
+    }
+};
+
+} // namespace sg
+
+#endif // SG_STEALORDER_HALF_HPP_INCLUDED
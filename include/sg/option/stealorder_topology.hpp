@@ -0,0 +1,96 @@
+#ifndef SG_STEALORDER_TOPOLOGY_HPP_INCLUDED
+#define SG_STEALORDER_TOPOLOGY_HPP_INCLUDED
+
+// ============================================================================
+// TopologyStealOrder: Steal from nearby workers first
+//
+// The other workers are grouped in rings by how close their cpus are to the
+// cpu of this worker: SMT siblings, then workers sharing the L3 cache, then
+// workers on the same NUMA node, and last all remote workers. Victims are
+// tried one ring at a time, starting at a random position within each ring.
+//
+// The cpu of each worker is given by Options::ThreadAffinity::get_cpu(id),
+// and the cpu topology is read from /sys/devices/system/cpu (see
+// sg/platform/topology.hpp). Without topology information, all workers end
+// up in the same ring and this behaves like DefaultStealOrder.
+//
+// The rings are built at the first steal attempt, when the threading manager
+// is guaranteed to be fully initialized.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef TopologyStealOrder<Options> StealOrder;
+//   };
+// ============================================================================
+
+#include "sg/platform/topology.hpp"
+
+#include <vector>
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+template<typename Options> class TaskExecutor;
+
+template<typename Options>
+class TopologyStealOrder {
+    typedef typename Options::ReadyListType TaskQueue;
+    enum { NUM_RINGS = CpuTopology::REMOTE + 1 };
+
+private:
+    TaskExecutor<Options> *parent;
+    size_t seed;
+    bool initialized;
+    std::vector<size_t> rings[NUM_RINGS];
+
+    void init_rings(size_t num_queues, size_t id) {
+        const CpuTopology &topology(CpuTopology::get());
+        const int my_cpu = Options::ThreadAffinity::get_cpu(static_cast<int>(id));
+        for (size_t i = 0; i < num_queues; ++i) {
+            if (i == id)
+                continue;
+            const int cpu = Options::ThreadAffinity::get_cpu(static_cast<int>(i));
+            rings[topology.distance(my_cpu, cpu)].push_back(i);
+        }
+        initialized = true;
+    }
+
+public:
+    TopologyStealOrder() : parent(0), seed(0), initialized(false) {}
+
+    void init(TaskExecutor<Options> *parent_) {
+        parent = parent_;
+        seed = (size_t) parent->id;
+    }
+
+    // victims of this worker, in the order they are tried (for testing)
+    const std::vector<size_t> &get_ring(size_t level) const { return rings[level]; }
+
+    bool steal(typename Options::ThreadingManagerType &tman, size_t id, TaskBase<Options> *&dest) {
+        if (!initialized)
+            init_rings(tman.get_num_cpus(), id);
+
+        TaskQueue **taskQueues = tman.get_task_queues();
+        for (size_t level = 0; level < NUM_RINGS; ++level) {
+            const std::vector<size_t> &ring(rings[level]);
+            const size_t n = ring.size();
+            if (n == 0)
+                continue;
+            seed = seed * 1664525 + 1013904223;
+            const size_t start(seed % n);
+            for (size_t j = 0; j < n; ++j) {
+                const size_t victim = ring[(start + j) % n];
+                if (taskQueues[victim]->pop_back(dest)) {
+                    parent->tasks_stolen(static_cast<int>(victim), 1);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace sg
+
+#endif // SG_STEALORDER_TOPOLOGY_HPP_INCLUDED
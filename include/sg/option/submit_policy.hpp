@@ -0,0 +1,160 @@
+#ifndef SG_SUBMIT_POLICY_HPP_INCLUDED
+#define SG_SUBMIT_POLICY_HPP_INCLUDED
+
+// ============================================================================
+// Submit policies: Which ready list SuperGlue::submit(task) sends a task to
+//
+// SubmitRoundRobin (default, in defaults.hpp)
+//   One counter shared by all submitting threads.
+//
+// SubmitRoundRobinThreadLocal
+//   Round-robin, but each submitting thread keeps its own counter, so
+//   threads that submit concurrently do not bounce a shared cache line.
+//
+// SubmitLocal
+//   Tasks submitted from inside a running task go to the queue of the
+//   worker running it, where the parent's data is likely still in cache.
+//   Other threads fall back to SubmitRoundRobinThreadLocal. Other workers
+//   pick up the excess work by stealing.
+//
+// SubmitLeastLoaded
+//   Each queue keeps a hint of how many tasks were submitted to it and
+//   have not started yet, and tasks go to the queue with the lowest hint.
+//   This costs a scan over all queues per submit, and two atomic updates
+//   per task.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef SubmitLocal<Options> SubmitPolicy;
+//   };
+// ============================================================================
+
+#include "sg/platform/atomic.hpp"
+#include "sg/platform/platform.hpp"
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+template<typename Options> class TaskExecutor;
+
+namespace detail {
+
+// per-thread round-robin counter
+template<typename Options>
+class ThreadLocalCounter {
+    static SG_TLS int next;
+
+    // spread the starting points of different threads
+    static int get_start() {
+        static int num_threads = 0;
+        return Atomic::increase_nv(&num_threads) * 7;
+    }
+
+public:
+    static int get_next(int num_queues) {
+        if (next == -1)
+            next = get_start();
+        const int queue = next % num_queues;
+        next = queue + 1;
+        return queue;
+    }
+};
+
+template<typename Options> SG_TLS int ThreadLocalCounter<Options>::next = -1;
+
+} // namespace detail
+
+// ============================================================================
+// SubmitRoundRobinThreadLocal
+// ============================================================================
+template<typename Options>
+class SubmitRoundRobinThreadLocal {
+    typedef typename Options::ThreadingManagerType ThreadingManager;
+public:
+    struct TaskData {};
+    struct ThreadState {};
+
+    static int select_queue(ThreadingManager &tman, TaskBase<Options> *) {
+        return detail::ThreadLocalCounter<Options>::get_next(tman.get_num_cpus());
+    }
+    static void run_before(TaskExecutor<Options> &, TaskBase<Options> *) {}
+    static void run_after(TaskExecutor<Options> &, TaskBase<Options> *) {}
+};
+
+// ============================================================================
+// SubmitLocal
+// ============================================================================
+template<typename Options>
+class SubmitLocal {
+    typedef typename Options::ThreadingManagerType ThreadingManager;
+
+public:
+    struct TaskData {};
+    struct ThreadState {
+        int depth; // number of nested task runs on this worker
+        ThreadState() : depth(0) {}
+    };
+
+    static int select_queue(ThreadingManager &tman, TaskBase<Options> *) {
+        TaskExecutor<Options> *te(TaskExecutor<Options>::get_current(tman));
+        if (te != NULL && te->submit_state.depth > 0)
+            return te->get_id();
+        return detail::ThreadLocalCounter<Options>::get_next(tman.get_num_cpus());
+    }
+    static void run_before(TaskExecutor<Options> &te, TaskBase<Options> *) {
+        ++te.submit_state.depth;
+    }
+    static void run_after(TaskExecutor<Options> &te, TaskBase<Options> *) {
+        --te.submit_state.depth;
+    }
+};
+
+// ============================================================================
+// SubmitLeastLoaded
+// ============================================================================
+template<typename Options>
+class SubmitLeastLoaded {
+    typedef typename Options::ThreadingManagerType ThreadingManager;
+
+public:
+    struct TaskData {
+        int submit_queue; // queue selected for this task, or -1
+        TaskData() : submit_queue(-1) {}
+    };
+    struct ThreadState {
+        int load; // tasks submitted to this queue that have not started
+        char padding[Options::CACHE_LINE_SIZE];
+        ThreadState() : load(0) {}
+    };
+
+    static int select_queue(ThreadingManager &tman, TaskBase<Options> *task) {
+        const int num_queues = tman.get_num_cpus();
+        // start at a rotating position, to spread tasks between equally loaded queues
+        const int start = detail::ThreadLocalCounter<Options>::get_next(num_queues);
+        int best = start;
+        int best_load = *static_cast<volatile int *>(&tman.get_worker(start)->submit_state.load);
+        for (int i = 1; i < num_queues && best_load > 0; ++i) {
+            const int queue = (start + i) % num_queues;
+            const int load = *static_cast<volatile int *>(&tman.get_worker(queue)->submit_state.load);
+            if (load < best_load) {
+                best = queue;
+                best_load = load;
+            }
+        }
+        Atomic::increase(&tman.get_worker(best)->submit_state.load);
+        task->submit_queue = best;
+        return best;
+    }
+    static void run_before(TaskExecutor<Options> &te, TaskBase<Options> *task) {
+        if (task->submit_queue == -1)
+            return;
+        Atomic::decrease(&te.get_threading_manager().get_worker(task->submit_queue)->submit_state.load);
+        task->submit_queue = -1;
+    }
+    static void run_after(TaskExecutor<Options> &, TaskBase<Options> *) {}
+};
+
+} // namespace sg
+
+#endif // SG_SUBMIT_POLICY_HPP_INCLUDED
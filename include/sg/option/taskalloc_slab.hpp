@@ -0,0 +1,287 @@
+#ifndef SG_TASKALLOC_SLAB_HPP_INCLUDED
+#define SG_TASKALLOC_SLAB_HPP_INCLUDED
+
+#include "sg/platform/atomic.hpp"
+#include "sg/platform/platform.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// ============================================================================
+// TaskAllocSlab: Per-thread slab allocator for tasks
+//
+// Each thread that creates tasks gets its own cache, with free lists for a
+// few size classes that are refilled by cutting up larger slabs. Allocating
+// and freeing on the thread that owns the memory takes no locks or atomic
+// operations.
+//
+// Tasks are usually freed by the worker that ran them, not by the thread
+// that created them. Such remote frees are collected per owner and size
+// class, and a batch of BATCH_SIZE blocks is returned to the owner with a
+// single compare-and-swap. The owner takes all returned blocks with one
+// atomic swap when its own free list runs out.
+//
+// Tasks larger than the largest size class use malloc. Blocks may wait in a
+// batch on the freeing thread until the batch is full, or until that thread
+// calls flush() or release_thread().
+//
+// Workers call release_thread() when they leave the work loop, and the main
+// thread when its executor is destroyed. This returns the pending batches and
+// retires the thread cache. A retired cache and its slabs are freed as soon as
+// all of its blocks have been freed, by whichever thread frees the last one.
+// A thread that allocates again afterwards gets a new cache.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef TaskAllocSlab<Options> TaskAllocator;
+//   };
+//
+// Tasks then get an operator new and operator delete that use the slabs, so
+// "new MyTask(...)" and the default FreeTask need no changes.
+// ============================================================================
+
+namespace sg {
+
+template<typename Options>
+class TaskAllocSlab {
+public:
+    enum { NUM_CLASSES = 5 };     // block sizes 64, 128, 256, 512, 1024
+    enum { MIN_BLOCK_SIZE = 64 };
+    enum { SLAB_SIZE = 65536 };
+    enum { BATCH_SIZE = 32 };     // blocks returned to the owner at once
+    enum { NUM_BATCHES = 8 };     // owners with pending frees per thread
+
+private:
+    struct ThreadCache;
+
+    struct Block {
+        Block *next;
+    };
+
+    // stored at the start of each slab
+    union Slab {
+        Slab *next;
+        double align[2];
+    };
+
+    // stored in front of each allocation
+    union Header {
+        struct {
+            ThreadCache *owner; // NULL if allocated by malloc
+            size_t size_class;
+        } info;
+        double align[2];
+    };
+
+    // frees waiting to be returned to another thread
+    struct Batch {
+        ThreadCache *owner;
+        size_t size_class;
+        Block *first;
+        Block *last;
+        size_t count;
+    };
+
+    struct ThreadCache {
+        Block *free_list[NUM_CLASSES];  // owner only
+        Batch batches[NUM_BATCHES];     // frees by this thread of blocks owned by others
+        Slab *slabs;                    // owner only
+        long num_live;                  // owner only: blocks allocated, minus blocks freed by the owner
+        char padding[Options::CACHE_LINE_SIZE];
+        Block *returned[NUM_CLASSES];   // blocks returned by other threads
+        long balance;                   // minus the blocks returned by other threads, plus num_live once retired
+        char padding2[Options::CACHE_LINE_SIZE];
+
+        ThreadCache() : slabs(NULL), num_live(0), balance(0) {
+            std::memset(free_list, 0, sizeof(free_list));
+            std::memset(batches, 0, sizeof(batches));
+            std::memset(returned, 0, sizeof(returned));
+        }
+    };
+
+    static SG_TLS ThreadCache *thread_cache;
+    static size_t num_slabs;
+
+    static ThreadCache *get_thread_cache() {
+        ThreadCache *cache(thread_cache);
+        if (cache == NULL) {
+            void *mem = std::malloc(sizeof(ThreadCache));
+            if (mem == NULL)
+                throw std::bad_alloc();
+            cache = new (mem) ThreadCache;
+            thread_cache = cache;
+        }
+        return cache;
+    }
+
+    static size_t block_size(size_t size_class) {
+        return static_cast<size_t>(MIN_BLOCK_SIZE) << size_class;
+    }
+
+    static bool get_size_class(size_t size, size_t &size_class) {
+        const size_t total(size + sizeof(Header));
+        for (size_class = 0; size_class < NUM_CLASSES; ++size_class)
+            if (total <= block_size(size_class))
+                return true;
+        return false;
+    }
+
+    // owner only: cut up a new slab into blocks
+    static Block *new_slab(ThreadCache *cache, size_t size_class) {
+        const size_t size(block_size(size_class));
+        Slab *mem = static_cast<Slab *>(std::malloc(SLAB_SIZE));
+        if (mem == NULL)
+            throw std::bad_alloc();
+        mem->next = cache->slabs;
+        cache->slabs = mem;
+        Atomic::increase(&num_slabs);
+
+        char *slab = reinterpret_cast<char *>(mem + 1);
+        const size_t num_blocks((SLAB_SIZE - sizeof(Slab)) / size);
+        for (size_t i = 0; i < num_blocks - 1; ++i)
+            reinterpret_cast<Block *>(slab + i * size)->next = reinterpret_cast<Block *>(slab + (i + 1) * size);
+        reinterpret_cast<Block *>(slab + (num_blocks - 1) * size)->next = NULL;
+        return reinterpret_cast<Block *>(slab);
+    }
+
+    // called when a retired cache has got all its blocks back
+    static void delete_cache(ThreadCache *cache) {
+        Slab *slab = cache->slabs;
+        while (slab != NULL) {
+            Slab *next = slab->next;
+            std::free(slab);
+            Atomic::decrease(&num_slabs);
+            slab = next;
+        }
+        cache->~ThreadCache();
+        std::free(cache);
+    }
+
+    // push a list of blocks onto the returned list of their owner
+    static void return_batch(Batch &batch) {
+        ThreadCache *owner(batch.owner);
+        const long count(static_cast<long>(batch.count));
+        Block **head = &owner->returned[batch.size_class];
+        for (;;) {
+            Block *old = *static_cast<Block * volatile *>(head);
+            batch.last->next = old;
+            if (Atomic::cas(head, old, batch.first) == old)
+                break;
+        }
+        batch.owner = NULL;
+        batch.count = 0;
+        // the balance can only reach zero after the owner has retired
+        if (Atomic::add_nv(&owner->balance, -count) == 0)
+            delete_cache(owner);
+    }
+
+    static void flush_batches(ThreadCache *cache) {
+        for (size_t i = 0; i < NUM_BATCHES; ++i)
+            if (cache->batches[i].owner != NULL)
+                return_batch(cache->batches[i]);
+    }
+
+    static void free_remote(ThreadCache *cache, ThreadCache *owner, size_t size_class, Block *block) {
+        Batch &batch(cache->batches[(reinterpret_cast<size_t>(owner) / sizeof(ThreadCache) + size_class) % NUM_BATCHES]);
+        if (batch.owner != owner || batch.size_class != size_class) {
+            if (batch.owner != NULL)
+                return_batch(batch);
+            batch.owner = owner;
+            batch.size_class = size_class;
+            batch.first = batch.last = block;
+            block->next = NULL;
+            batch.count = 1;
+        }
+        else {
+            block->next = batch.first;
+            batch.first = block;
+            ++batch.count;
+        }
+        if (batch.count == BATCH_SIZE)
+            return_batch(batch);
+    }
+
+public:
+    static void *allocate(size_t size) {
+        size_t size_class;
+        if (!get_size_class(size, size_class)) {
+            Header *h = static_cast<Header *>(std::malloc(size + sizeof(Header)));
+            if (h == NULL)
+                throw std::bad_alloc();
+            h->info.owner = NULL;
+            return h + 1;
+        }
+
+        ThreadCache *cache(get_thread_cache());
+        Block *block = cache->free_list[size_class];
+        if (block == NULL) {
+            if (*static_cast<Block * volatile *>(&cache->returned[size_class]) != NULL)
+                block = Atomic::swap(&cache->returned[size_class], static_cast<Block *>(NULL));
+            if (block == NULL)
+                block = new_slab(cache, size_class);
+        }
+        cache->free_list[size_class] = block->next;
+        ++cache->num_live;
+
+        Header *h = reinterpret_cast<Header *>(block);
+        h->info.owner = cache;
+        h->info.size_class = size_class;
+        return h + 1;
+    }
+
+    static void deallocate(void *p) {
+        if (p == NULL)
+            return;
+        Header *h = static_cast<Header *>(p) - 1;
+        ThreadCache *owner(h->info.owner);
+        if (owner == NULL) {
+            std::free(h);
+            return;
+        }
+        const size_t size_class(h->info.size_class);
+        Block *block = reinterpret_cast<Block *>(h);
+        ThreadCache *cache(get_thread_cache());
+        if (owner == cache) {
+            block->next = cache->free_list[size_class];
+            cache->free_list[size_class] = block;
+            --cache->num_live;
+        }
+        else
+            free_remote(cache, owner, size_class, block);
+    }
+
+    // return all frees waiting in batches on this thread to their owners
+    static void flush() {
+        ThreadCache *cache(thread_cache);
+        if (cache == NULL)
+            return;
+        flush_batches(cache);
+    }
+
+    // flush, and retire the cache of this thread. Its slabs are freed once
+    // the blocks that are still in use have been freed.
+    static void release_thread() {
+        ThreadCache *cache(thread_cache);
+        if (cache == NULL)
+            return;
+        thread_cache = NULL;
+        flush_batches(cache);
+        if (Atomic::add_nv(&cache->balance, cache->num_live) == 0)
+            delete_cache(cache);
+    }
+
+    // number of slabs allocated, by all threads
+    static size_t get_num_slabs() { return num_slabs; }
+};
+
+template<typename Options>
+SG_TLS typename TaskAllocSlab<Options>::ThreadCache *TaskAllocSlab<Options>::thread_cache = NULL;
+
+template<typename Options>
+size_t TaskAllocSlab<Options>::num_slabs = 0;
+
+} // namespace sg
+
+#endif // SG_TASKALLOC_SLAB_HPP_INCLUDED
@@ -0,0 +1,284 @@
+#ifndef SG_TASKQUEUE_BUCKETS_HPP_INCLUDED
+#define SG_TASKQUEUE_BUCKETS_HPP_INCLUDED
+
+#include "sg/core/taskqueueunsafe.hpp"
+#include "sg/core/spinlock.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+// ============================================================================
+// TaskQueueBuckets: Ready list with integer task priorities
+//
+// Each task has an integer priority (TaskBase::priority, default 0), where
+// higher means more urgent. Priorities in [0, NumBuckets) are kept in one
+// list per priority, with a bitmap of the non-empty lists, so push and pop
+// are O(1). Priorities outside this range go to a fallback heap, one above
+// and one below the buckets, at O(log n) cost.
+//
+//   pop_front()      front of the highest priority bucket (owner)
+//   pop_back()       back of the highest priority bucket (thieves)
+//   pop_back_half()  several tasks, in the order pop_back() would give them
+//
+// Within a bucket, push_back() and push_front() behave as for the default
+// ready list.
+//
+// The woken lists (unsafe_t) are TaskQueueDefaultUnsafe, so the default
+// WaitListType can be kept. Tasks are sorted into buckets when they are
+// added to the ready list.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef TaskQueueBuckets<Options> ReadyListType;
+//   };
+//
+//   class MyTask : public Task<Options, 1> {
+//       MyTask(...) { priority = 10; ... }
+//   };
+// ============================================================================
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+
+namespace detail {
+
+// index of the most significant set bit. x must not be 0.
+inline int highest_bit(uint64_t x) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(x);
+#else
+    int i = 0;
+    while (x >>= 1)
+        ++i;
+    return i;
+#endif
+}
+
+template<typename Options, int NumBuckets>
+class TaskQueueBucketsUnsafe {
+    typedef TaskBase<Options> * taskptr_t;
+    typedef TaskQueueDefaultUnsafe<Options> list_t;
+    typedef typename Options::template Alloc<taskptr_t>::type allocator_t;
+    typedef std::vector<taskptr_t, allocator_t> heap_t;
+
+    enum { NUM_WORDS = (NumBuckets + 63) / 64 };
+
+    // heap order: highest priority on top
+    struct LowerPriority {
+        bool operator()(taskptr_t a, taskptr_t b) const { return a->priority < b->priority; }
+    };
+
+private:
+    uint64_t bitmap[NUM_WORDS];
+    list_t buckets[NumBuckets];
+    heap_t above;   // priority >= NumBuckets
+    heap_t below;   // priority < 0
+
+    static bool heap_pop(heap_t &heap, taskptr_t &elem) {
+        if (heap.empty())
+            return false;
+        std::pop_heap(heap.begin(), heap.end(), LowerPriority());
+        elem = heap.back();
+        heap.pop_back();
+        return true;
+    }
+
+    static void heap_push(heap_t &heap, taskptr_t elem) {
+        heap.push_back(elem);
+        std::push_heap(heap.begin(), heap.end(), LowerPriority());
+    }
+
+    void mark(int prio) {
+        bitmap[prio / 64] |= static_cast<uint64_t>(1) << (prio % 64);
+    }
+
+    void unmark_if_empty(int prio) {
+        if (buckets[prio].empty())
+            bitmap[prio / 64] &= ~(static_cast<uint64_t>(1) << (prio % 64));
+    }
+
+    // highest non-empty bucket, or -1
+    int top_bucket() const {
+        for (int i = NUM_WORDS - 1; i >= 0; --i)
+            if (bitmap[i] != 0)
+                return i * 64 + highest_bit(bitmap[i]);
+        return -1;
+    }
+
+    template<bool Front>
+    bool pop(taskptr_t &elem) {
+        if (heap_pop(above, elem))
+            return true;
+        const int prio = top_bucket();
+        if (prio != -1) {
+            if (Front)
+                buckets[prio].pop_front(elem);
+            else
+                buckets[prio].pop_back(elem);
+            unmark_if_empty(prio);
+            return true;
+        }
+        return heap_pop(below, elem);
+    }
+
+public:
+    TaskQueueBucketsUnsafe() {
+        for (int i = 0; i < NUM_WORDS; ++i)
+            bitmap[i] = 0;
+    }
+
+    void push_back(taskptr_t elem) {
+        const int prio = elem->priority;
+        if (prio >= NumBuckets)
+            heap_push(above, elem);
+        else if (prio < 0)
+            heap_push(below, elem);
+        else {
+            buckets[prio].push_back(elem);
+            mark(prio);
+        }
+    }
+
+    void push_front(taskptr_t elem) {
+        const int prio = elem->priority;
+        if (prio >= NumBuckets)
+            heap_push(above, elem);
+        else if (prio < 0)
+            heap_push(below, elem);
+        else {
+            buckets[prio].push_front(elem);
+            mark(prio);
+        }
+    }
+
+    bool pop_front(taskptr_t &elem) { return pop<true>(elem); }
+    bool pop_back(taskptr_t &elem) { return pop<false>(elem); }
+};
+
+} // namespace detail
+
+template<typename Options, int NumBuckets = 64>
+class TaskQueueBuckets {
+    typedef TaskBase<Options> * taskptr_t;
+
+public:
+    typedef TaskBase<Options> value_type;
+    typedef detail::TaskQueueDefaultUnsafe<Options> unsafe_t;
+
+    struct ElementData : public unsafe_t::ElementData {
+        int priority;
+        ElementData() : priority(0) {}
+    };
+
+private:
+    detail::TaskQueueBucketsUnsafe<Options, NumBuckets> queue;
+    size_t num_tasks;
+    SpinLock queuelock;
+
+    TaskQueueBuckets(const TaskQueueBuckets &);
+    const TaskQueueBuckets &operator=(const TaskQueueBuckets &);
+
+public:
+    TaskQueueBuckets() : num_tasks(0) {}
+
+    void push_back(value_type *elem) {
+        SpinLockScoped hold(queuelock);
+        queue.push_back(elem);
+        ++num_tasks;
+    }
+
+    void push_front(value_type *elem) {
+        SpinLockScoped hold(queuelock);
+        queue.push_front(elem);
+        ++num_tasks;
+    }
+
+    // takes ownership of input list. the first task in the list ends up
+    // first among tasks of the same priority.
+    void push_front_list(unsafe_t &list) {
+        SpinLockScoped hold(queuelock);
+        taskptr_t elem = 0;
+        while (list.pop_back(elem)) {
+            queue.push_front(elem);
+            ++num_tasks;
+        }
+    }
+
+    // takes ownership of input list
+    void push_back_list(unsafe_t &list) {
+        SpinLockScoped hold(queuelock);
+        taskptr_t elem = 0;
+        while (list.pop_front(elem)) {
+            queue.push_back(elem);
+            ++num_tasks;
+        }
+    }
+
+    bool pop_front(value_type * &elem) {
+        SpinLockScoped hold(queuelock);
+        if (!queue.pop_front(elem))
+            return false;
+        --num_tasks;
+        return true;
+    }
+
+    bool pop_back(value_type * &elem) {
+        if (empty())
+            return false;
+        SpinLockScoped hold(queuelock);
+        if (!queue.pop_back(elem))
+            return false;
+        --num_tasks;
+        return true;
+    }
+
+    // moves up to half of the tasks (at least one, at most max_count) to the
+    // front of dest, highest priority first. returns the number moved.
+    size_t pop_back_half(unsafe_t &dest, size_t max_count) {
+        if (empty())
+            return 0;
+        unsafe_t stolen;
+        size_t count = 0;
+        {
+            SpinLockScoped hold(queuelock);
+            size_t n = num_tasks > 1 ? num_tasks / 2 : num_tasks;
+            if (n > max_count)
+                n = max_count;
+            taskptr_t elem = 0;
+            while (count < n && queue.pop_back(elem)) {
+                stolen.push_back(elem);
+                ++count;
+            }
+            num_tasks -= count;
+        }
+        dest.push_front_list(stolen);
+        return count;
+    }
+
+    bool try_steal(value_type * &elem) {
+        SpinLockTryLock hold(queuelock);
+        if (!hold.success)
+            return false;
+        if (!queue.pop_back(elem))
+            return false;
+        --num_tasks;
+        return true;
+    }
+
+    bool empty() {
+        Atomic::compiler_fence();
+        return *static_cast<volatile size_t *>(&num_tasks) == 0;
+    }
+
+    bool empty_safe() {
+        SpinLockScoped hold(queuelock);
+        return num_tasks == 0;
+    }
+};
+
+} // namespace sg
+
+#endif // SG_TASKQUEUE_BUCKETS_HPP_INCLUDED
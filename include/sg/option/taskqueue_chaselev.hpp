@@ -0,0 +1,383 @@
+#ifndef SG_TASKQUEUE_CHASELEV_HPP_INCLUDED
+#define SG_TASKQUEUE_CHASELEV_HPP_INCLUDED
+
+#include "sg/core/taskqueueunsafe.hpp"
+#include "sg/core/spinlock.hpp"
+#include "sg/platform/atomic.hpp"
+#include "sg/platform/threadutil.hpp"
+
+// ============================================================================
+// TaskQueueChaseLev: Lock-free work-stealing ready list
+//
+// Based on the dynamic circular work-stealing deque of Chase and Lev
+// ("Dynamic Circular Work-Stealing Deque", SPAA'05), with the fences from
+// Le et al. ("Correct and Efficient Work-Stealing for Weak Memory Models",
+// PPoPP'13).
+//
+// The owner thread pushes and pops at the front of a growable ring buffer
+// without taking any lock, and only needs a compare-and-swap when it competes
+// with a thief for the very last task. Thieves take tasks from the back using
+// a single compare-and-swap.
+//
+// Tasks added by push_back() may come from any thread (SuperGlue::submit()
+// round-robins over all queues), so they are pushed onto a lock-free inbox
+// instead. The owner moves the inbox into the ring buffer when the ring buffer
+// runs out of tasks, and thieves can steal from the inbox directly.
+//
+// Tasks added by push_front() may also come from other threads (pinned and
+// routed tasks are handed to the worker that should run them). The owner is
+// the thread that constructed the queue, and tasks from any other thread go to
+// a second inbox, which the owner moves to the front of the ring buffer before
+// taking the next task.
+//
+//   push_back()        any thread
+//   push_back_list()   any thread
+//   push_front()       any thread
+//   push_front_list()  owner only
+//   pop_front()        owner only
+//   pop_back()         any thread
+//   pop_back_half()    any thread
+//   try_steal()        any thread
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef TaskQueueChaseLev<Options> ReadyListType;
+//   };
+//
+// The woken lists (unsafe_t) are TaskQueueDefaultUnsafe, so the default
+// WaitListType can be kept.
+// ============================================================================
+
+namespace sg {
+
+template<typename Options> class TaskBase;
+
+template<typename Options>
+class TaskQueueChaseLev {
+    typedef TaskBase<Options> * taskptr_t;
+
+public:
+    typedef TaskBase<Options> value_type;
+    typedef typename detail::TaskQueueDefaultUnsafe<Options>::ElementData ElementData;
+    typedef detail::TaskQueueDefaultUnsafe<Options> unsafe_t;
+
+private:
+    enum { INITIAL_CAPACITY = 256 };
+
+    struct Buffer {
+        long mask;
+        taskptr_t *data;
+        Buffer *retired; // previous buffers, kept until destruction since thieves may still read them
+    };
+
+    typedef typename Options::template Alloc<taskptr_t>::type data_allocator_t;
+    typedef typename Options::template Alloc<Buffer>::type buffer_allocator_t;
+
+    long top;                 // written by thieves (and by the owner for the last task)
+    char padding1[Options::CACHE_LINE_SIZE];
+    long bottom;              // written by owner only
+    Buffer *buffer;           // written by owner only
+    char padding2[Options::CACHE_LINE_SIZE];
+    taskptr_t inbox;          // lock-free stack of tasks from push_back(), linked through nextPrev
+    taskptr_t front_inbox;    // lock-free stack of tasks from push_front(), linked through nextPrev
+    SpinLock inbox_lock;      // serializes removals from the inboxes
+    ThreadIDType owner;       // the only thread that may use the ring buffer from the front
+    char padding3[Options::CACHE_LINE_SIZE];
+
+    TaskQueueChaseLev(const TaskQueueChaseLev &);
+    const TaskQueueChaseLev &operator=(const TaskQueueChaseLev &);
+
+    template<typename T> static T load(T &var) { return *static_cast<volatile T *>(&var); }
+    template<typename T> static void store(T &var, T value) { *static_cast<volatile T *>(&var) = value; }
+
+    static Buffer *new_buffer(long capacity) {
+        buffer_allocator_t buffer_allocator;
+        data_allocator_t data_allocator;
+        Buffer *b = buffer_allocator.allocate(1);
+        b->mask = capacity - 1;
+        b->data = data_allocator.allocate(static_cast<size_t>(capacity));
+        b->retired = 0;
+        return b;
+    }
+
+    static void delete_buffer(Buffer *b) {
+        buffer_allocator_t buffer_allocator;
+        data_allocator_t data_allocator;
+        data_allocator.deallocate(b->data, static_cast<size_t>(b->mask + 1));
+        buffer_allocator.deallocate(b, 1);
+    }
+
+    // owner only: double the capacity of the ring buffer
+    Buffer *grow(Buffer *old, long b, long t) {
+        Buffer *b2 = new_buffer(2 * (old->mask + 1));
+        for (long i = t; i < b; ++i)
+            b2->data[i & b2->mask] = old->data[i & old->mask];
+        b2->retired = old;
+        Atomic::memory_fence_producer(); // contents must be visible before the buffer is published
+        store(buffer, b2);
+        return b2;
+    }
+
+    // owner only
+    void push_bottom(taskptr_t elem) {
+        const long b = bottom;
+        const long t = load(top);
+        Buffer *a = buffer;
+        if (b - t > a->mask)
+            a = grow(a, b, t);
+        a->data[b & a->mask] = elem;
+        Atomic::memory_fence_producer(); // task must be visible before bottom is increased
+        store(bottom, b + 1);
+    }
+
+    // owner only
+    bool take_bottom(taskptr_t &elem) {
+        const long b = bottom - 1;
+        Buffer *a = buffer;
+        store(bottom, b);
+        Atomic::memory_fence(); // bottom must be visible before top is read
+        const long t = load(top);
+
+        if (t > b) {
+            // empty
+            store(bottom, b + 1);
+            return false;
+        }
+
+        elem = a->data[b & a->mask];
+        if (t != b)
+            return true;
+
+        // last task: race against thieves
+        const bool success = (Atomic::cas(&top, t, t + 1) == t);
+        store(bottom, b + 1);
+        return success;
+    }
+
+    // any thread. returns false if queue was empty or if we lost a race.
+    bool steal_top(taskptr_t &elem, bool &lost_race) {
+        const long t = load(top);
+        Atomic::memory_fence(); // top must be read before bottom
+        const long b = load(bottom);
+        lost_race = false;
+        if (t >= b)
+            return false;
+
+        Atomic::memory_fence_consumer(); // read buffer after bottom
+        Buffer *a = load(buffer);
+        taskptr_t x = a->data[t & a->mask];
+        if (Atomic::cas(&top, t, t + 1) != t) {
+            lost_race = true;
+            return false;
+        }
+        elem = x;
+        return true;
+    }
+
+    // any thread
+    static void push_inbox(taskptr_t &stack, taskptr_t elem) {
+        for (;;) {
+            taskptr_t head = load(stack);
+            elem->nextPrev = reinterpret_cast<uintptr_t>(head);
+            if (Atomic::cas(&stack, head, elem) == head)
+                return;
+        }
+    }
+
+    // any thread, inbox_lock must be held.
+    // Only one thread at a time removes elements, so the head cannot be
+    // removed and pushed again while we are looking at it (no ABA).
+    static bool pop_inbox(taskptr_t &stack, taskptr_t &elem) {
+        for (;;) {
+            taskptr_t head = load(stack);
+            if (head == 0)
+                return false;
+            taskptr_t next = reinterpret_cast<taskptr_t>(head->nextPrev);
+            if (Atomic::cas(&stack, head, next) == head) {
+                elem = head;
+                return true;
+            }
+        }
+    }
+
+    // owner only: move the inbox into the ring buffer.
+    // The inbox is newest first, so the oldest task ends up at the front.
+    bool drain_inbox() {
+        if (load(inbox) == 0)
+            return false;
+        taskptr_t list;
+        {
+            SpinLockScoped hold(inbox_lock);
+            list = Atomic::swap(&inbox, static_cast<taskptr_t>(0));
+        }
+        if (list == 0)
+            return false;
+        while (list != 0) {
+            taskptr_t next = reinterpret_cast<taskptr_t>(list->nextPrev);
+            push_bottom(list);
+            list = next;
+        }
+        return true;
+    }
+
+    // owner only: move the front inbox to the front of the ring buffer.
+    // The front inbox is newest first, so the newest task ends up at the front.
+    void drain_front_inbox() {
+        taskptr_t list;
+        {
+            SpinLockScoped hold(inbox_lock);
+            list = Atomic::swap(&front_inbox, static_cast<taskptr_t>(0));
+        }
+        taskptr_t reversed = 0;
+        while (list != 0) {
+            taskptr_t next = reinterpret_cast<taskptr_t>(list->nextPrev);
+            list->nextPrev = reinterpret_cast<uintptr_t>(reversed);
+            reversed = list;
+            list = next;
+        }
+        while (reversed != 0) {
+            taskptr_t next = reinterpret_cast<taskptr_t>(reversed->nextPrev);
+            push_bottom(reversed);
+            reversed = next;
+        }
+    }
+
+    // any thread, inbox_lock must be held
+    bool pop_inboxes(taskptr_t &elem) {
+        return pop_inbox(inbox, elem) || pop_inbox(front_inbox, elem);
+    }
+
+public:
+    TaskQueueChaseLev()
+      : top(0), bottom(0), inbox(0), front_inbox(0),
+        owner(ThreadUtil::get_current_thread_id()) {
+        buffer = new_buffer(INITIAL_CAPACITY);
+    }
+
+    ~TaskQueueChaseLev() {
+        Buffer *b = buffer;
+        while (b != 0) {
+            Buffer *next = b->retired;
+            delete_buffer(b);
+            b = next;
+        }
+    }
+
+    // any thread
+    void push_back(value_type *elem) {
+        push_inbox(inbox, elem);
+    }
+
+    // any thread. takes ownership of input list, and adds it to the inbox
+    // with a single compare-and-swap.
+    void push_back_list(unsafe_t &list) {
+        taskptr_t head = 0;
+        taskptr_t tail = 0;
+        taskptr_t elem;
+        // link newest first, as in the inbox
+        while (list.pop_front(elem)) {
+            elem->nextPrev = reinterpret_cast<uintptr_t>(head);
+            head = elem;
+            if (tail == 0)
+                tail = elem;
+        }
+        if (head == 0)
+            return;
+        for (;;) {
+            taskptr_t old_head = load(inbox);
+            tail->nextPrev = reinterpret_cast<uintptr_t>(old_head);
+            if (Atomic::cas(&inbox, old_head, head) == old_head)
+                return;
+        }
+    }
+
+    // any thread
+    void push_front(value_type *elem) {
+        if (ThreadUtil::is_current_thread(owner))
+            push_bottom(elem);
+        else
+            push_inbox(front_inbox, elem);
+    }
+
+    // owner only. takes ownership of input list
+    void push_front_list(unsafe_t &list) {
+        taskptr_t elem;
+        while (list.pop_back(elem))
+            push_bottom(elem);
+    }
+
+    // owner only
+    bool pop_front(value_type * &elem) {
+        if (load(front_inbox) != 0)
+            drain_front_inbox();
+        if (take_bottom(elem))
+            return true;
+        if (!drain_inbox())
+            return false;
+        return take_bottom(elem);
+    }
+
+    // any thread
+    bool pop_back(value_type * &elem) {
+        for (;;) {
+            bool lost_race;
+            if (steal_top(elem, lost_race))
+                return true;
+            if (!lost_race)
+                break;
+        }
+        if (load(inbox) == 0 && load(front_inbox) == 0)
+            return false;
+        SpinLockScoped hold(inbox_lock);
+        return pop_inboxes(elem);
+    }
+
+    // any thread. moves up to half of the tasks (at most max_count) from the
+    // back of the queue to the front of dest. tasks are claimed one at a time,
+    // so the owner can keep working on the front meanwhile.
+    size_t pop_back_half(unsafe_t &dest, size_t max_count) {
+        const long t = load(top);
+        const long b = load(bottom);
+        size_t count = b - t > 1 ? static_cast<size_t>((b - t) / 2) : 1;
+        if (count > max_count)
+            count = max_count;
+
+        unsafe_t stolen;
+        size_t num = 0;
+        taskptr_t elem;
+        while (num < count && pop_back(elem)) {
+            stolen.push_front(elem);
+            ++num;
+        }
+        dest.push_front_list(stolen);
+        return num;
+    }
+
+    // any thread. gives up instead of waiting.
+    bool try_steal(value_type * &elem) {
+        bool lost_race;
+        if (steal_top(elem, lost_race))
+            return true;
+        if (lost_race || (load(inbox) == 0 && load(front_inbox) == 0))
+            return false;
+        SpinLockTryLock hold(inbox_lock);
+        if (!hold.success)
+            return false;
+        return pop_inboxes(elem);
+    }
+
+    bool empty() {
+        Atomic::compiler_fence();
+        return load(bottom) <= load(top) && load(inbox) == 0 && load(front_inbox) == 0;
+    }
+
+    bool empty_safe() {
+        Atomic::memory_fence();
+        return empty();
+    }
+};
+
+} // namespace sg
+
+#endif // SG_TASKQUEUE_CHASELEV_HPP_INCLUDED
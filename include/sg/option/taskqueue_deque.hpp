@@ -49,6 +49,22 @@ public:
         q.insert(q.begin(), rhs.q.begin(), rhs.q.end());
     }
 
+    void push_back_list(TaskQueueDequeUnsafe &rhs) {
+        q.insert(q.end(), rhs.q.begin(), rhs.q.end());
+        rhs.q.clear();
+    }
+
+    size_t pop_back_half(TaskQueueDequeUnsafe &dest, size_t max_count) {
+        size_t count = q.size() / 2;
+        if (count == 0)
+            count = q.size();
+        if (count > max_count)
+            count = max_count;
+        dest.q.insert(dest.q.begin(), q.end() - static_cast<typename taskdeque_t::difference_type>(count), q.end());
+        q.erase(q.end() - static_cast<typename taskdeque_t::difference_type>(count), q.end());
+        return count;
+    }
+
     bool empty() {
         return q.empty();
     }
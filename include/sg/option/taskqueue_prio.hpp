@@ -46,6 +46,12 @@ public:
         lowprio.push_front_list(rhs.lowprio);
     }
 
+    // takes ownership of input list
+    void push_back_list(TaskQueuePrioUnsafe &rhs) {
+        highprio.push_back_list(rhs.highprio);
+        lowprio.push_back_list(rhs.lowprio);
+    }
+
     bool pop_front(TaskBase<Options> * &elem) {
         if (highprio.pop_front(elem))
             return true;
@@ -58,6 +64,13 @@ public:
         return lowprio.pop_back(elem);
     }
 
+    size_t pop_back_half(TaskQueuePrioUnsafe &dest, size_t max_count) {
+        const size_t count = highprio.pop_back_half(dest.highprio, max_count);
+        if (count != 0)
+            return count;
+        return lowprio.pop_back_half(dest.lowprio, max_count);
+    }
+
     template<typename Visitor>
     void visit(Visitor &visitor) {
         highprio.visit(visitor);
@@ -0,0 +1,166 @@
+#ifndef SG_THREADAFFINITY_TOPOLOGY_HPP_INCLUDED
+#define SG_THREADAFFINITY_TOPOLOGY_HPP_INCLUDED
+
+// ============================================================================
+// Topology-aware ThreadAffinity policies
+//
+// Unlike DefaultThreadAffinity, which pins worker i to logical cpu i, these
+// only use the cpus in the affinity mask of the process (see
+// CpuTopology::get_allowed_cpus()), and place the workers according to the
+// cpu topology:
+//
+//   AllowedCpusThreadAffinity    allowed cpus in increasing order
+//   CompactThreadAffinity        fill up one core, cache and node at a time
+//   ScatterThreadAffinity        spread workers over NUMA nodes (or sockets),
+//                                and over physical cores within each node
+//   PhysicalCoreThreadAffinity   one worker per physical core, siblings are
+//                                only used if there are more workers than cores
+//
+// The main thread gets the first cpu in the order, and worker i gets the
+// i:th. If there are more workers than allowed cpus, the order wraps around.
+//
+// Works with both ThreadingManagerDefault and ThreadingManagerOMP, which call
+// init() before pinning any thread.
+//
+// Usage:
+//
+//   struct Options : public DefaultOptions<Options> {
+//       typedef CompactThreadAffinity<Options> ThreadAffinity;
+//   };
+// ============================================================================
+
+#include "sg/platform/affinity.hpp"
+#include "sg/platform/topology.hpp"
+
+#include <vector>
+#include <algorithm>
+
+namespace sg {
+
+namespace detail {
+
+// sorts cpus by node, socket, cache and core, so that close cpus are adjacent
+struct CompareCompact {
+    const CpuTopology &topology;
+    CompareCompact(const CpuTopology &topology_) : topology(topology_) {}
+    bool operator()(int a, int b) const {
+        const CpuTopology::CpuInfo ia(topology.get_cpu_info(a));
+        const CpuTopology::CpuInfo ib(topology.get_cpu_info(b));
+        if (ia.node != ib.node) return ia.node < ib.node;
+        if (ia.package != ib.package) return ia.package < ib.package;
+        if (ia.cache != ib.cache) return ia.cache < ib.cache;
+        if (ia.core != ib.core) return ia.core < ib.core;
+        return a < b;
+    }
+};
+
+// ============================================================================
+// Placement orders: get_order() returns the cpus to use, in order
+// ============================================================================
+struct PlaceAllowedCpus {
+    static void get_order(const CpuTopology &topology, std::vector<int> &order) {
+        order = topology.get_allowed_cpus();
+    }
+};
+
+struct PlaceCompact {
+    static void get_order(const CpuTopology &topology, std::vector<int> &order) {
+        order = topology.get_allowed_cpus();
+        std::stable_sort(order.begin(), order.end(), CompareCompact(topology));
+    }
+};
+
+struct PlacePhysicalCore {
+    // first cpu of each core in compact order, then the remaining siblings
+    static void get_order(const CpuTopology &topology, std::vector<int> &order) {
+        std::vector<int> compact;
+        PlaceCompact::get_order(topology, compact);
+        std::vector<int> siblings;
+        order.clear();
+        for (size_t i = 0; i < compact.size(); ++i) {
+            if (i > 0 && topology.distance(compact[i-1], compact[i]) == CpuTopology::SAME_CORE)
+                siblings.push_back(compact[i]);
+            else
+                order.push_back(compact[i]);
+        }
+        order.insert(order.end(), siblings.begin(), siblings.end());
+    }
+};
+
+struct PlaceScatter {
+    // take one cpu from each node (or socket) in turn, in physical core order
+    static void get_order(const CpuTopology &topology, std::vector<int> &order) {
+        std::vector<int> cores;
+        PlacePhysicalCore::get_order(topology, cores);
+
+        std::vector<int> domain_ids;
+        std::vector< std::vector<int> > domains;
+        for (size_t i = 0; i < cores.size(); ++i) {
+            const CpuTopology::CpuInfo info(topology.get_cpu_info(cores[i]));
+            const int id = info.node != -1 ? info.node : info.package;
+            size_t d = 0;
+            while (d < domain_ids.size() && domain_ids[d] != id)
+                ++d;
+            if (d == domain_ids.size()) {
+                domain_ids.push_back(id);
+                domains.push_back(std::vector<int>());
+            }
+            domains[d].push_back(cores[i]);
+        }
+
+        order.clear();
+        for (size_t j = 0; order.size() < cores.size(); ++j)
+            for (size_t d = 0; d < domains.size(); ++d)
+                if (j < domains[d].size())
+                    order.push_back(domains[d][j]);
+    }
+};
+
+// ============================================================================
+// TopologyThreadAffinity: pins threads according to a placement order
+// ============================================================================
+template<typename Options, typename Placement>
+struct TopologyThreadAffinity {
+    static std::vector<int> &get_order() {
+        static std::vector<int> order;
+        return order;
+    }
+
+    static void init() {
+        std::vector<int> &order(get_order());
+        if (order.empty())
+            Placement::get_order(CpuTopology::get(), order);
+    }
+    static void pin_main_thread() {
+        pin_workerthread(0);
+    }
+    static void pin_workerthread(int id) {
+        affinity_cpu_set cpu_set;
+        cpu_set.set(get_cpu(id));
+        ThreadAffinity::set_affinity(cpu_set);
+    }
+    // cpu that worker thread id is pinned to
+    static int get_cpu(int id) {
+        const std::vector<int> &order(get_order());
+        assert(!order.empty());
+        return order[static_cast<size_t>(id) % order.size()];
+    }
+};
+
+} // namespace detail
+
+template<typename Options>
+struct AllowedCpusThreadAffinity : public detail::TopologyThreadAffinity<Options, detail::PlaceAllowedCpus> {};
+
+template<typename Options>
+struct CompactThreadAffinity : public detail::TopologyThreadAffinity<Options, detail::PlaceCompact> {};
+
+template<typename Options>
+struct ScatterThreadAffinity : public detail::TopologyThreadAffinity<Options, detail::PlaceScatter> {};
+
+template<typename Options>
+struct PhysicalCoreThreadAffinity : public detail::TopologyThreadAffinity<Options, detail::PlacePhysicalCore> {};
+
+} // namespace sg
+
+#endif // SG_THREADAFFINITY_TOPOLOGY_HPP_INCLUDED
@@ -3,6 +3,7 @@
 
 #include "sg/platform/threads.hpp"
 #include "sg/platform/threadutil.hpp"
+#include "sg/platform/cpucount.hpp"
 #include "sg/platform/atomic.hpp"
 #include "sg/core/spinlock.hpp"
 
@@ -54,6 +55,7 @@ private:
     SpinLock lock_workers_initialized;
     unsigned int start_counter;
     char padding1[Options::CACHE_LINE_SIZE];
+    CpuCountDecision num_cpus_decision;
     unsigned int num_cpus;
     std::vector<WorkerThread *> workerthreads;
 
@@ -68,24 +70,16 @@ private:
     static bool workers_start_paused(typename Options::Enable) { return true; }
     static bool workers_start_paused() { return workers_start_paused(typename Options::PauseExecution()); }
 
-    int decide_num_cpus(int requested) {
+    static CpuCountDecision decide_num_cpus(int requested) {
         assert(requested == -1 || requested > 0);
-        std::string var = sg_getenv("OMP_NUM_THREADS");
-        if (!var.empty()) {
-            const int OMP_NUM_THREADS(atoi(var.c_str()));
-            assert(OMP_NUM_THREADS >= 0);
-            if (OMP_NUM_THREADS != 0)
-                return OMP_NUM_THREADS;
-        }
-        if (requested == -1 || requested == 0)
-            return ThreadUtil::get_num_cpus();
-        return requested;
+        return CpuCount::decide(requested);
     }
 
 public:
     ThreadingManagerDefault(int requested_num_cpus = -1)
     : start_counter(1),
-      num_cpus(decide_num_cpus(requested_num_cpus)),
+      num_cpus_decision(decide_num_cpus(requested_num_cpus)),
+      num_cpus(static_cast<unsigned int>(num_cpus_decision.num_cpus)),
       barrier_protocol(*static_cast<ThreadingManager*>(this))
     {
         Options::ThreadAffinity::init();
@@ -142,6 +136,8 @@ public:
     TaskQueue **get_task_queues() const { return const_cast<TaskQueue**>(&task_queues[0]); }
     TaskExecutor<Options> *get_worker(int i) { return threads[i]; }
     int get_num_cpus() { return num_cpus; }
+    // how the number of threads was decided, and why
+    const CpuCountDecision &get_num_cpus_decision() const { return num_cpus_decision; }
 };
 
 } // namespace sg
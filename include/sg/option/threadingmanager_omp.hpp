@@ -3,6 +3,7 @@
 
 #include "sg/platform/openmputil.hpp"
 #include "sg/platform/atomic.hpp"
+#include "sg/platform/cpucount.hpp"
 #include "sg/core/spinlock.hpp"
 #include <cassert>
 
@@ -23,6 +24,7 @@ private:
 
     int start_counter;
     char padding1[Options::CACHE_LINE_SIZE];
+    CpuCountDecision num_cpus_decision;
     int num_cpus;
 
 public:
@@ -41,8 +43,11 @@ private:
     static int get_thread_num() { return omp_get_thread_num(); }
 
     void init_master() {
-        Options::ThreadAffinity::pin_main_thread();
         num_cpus = decide_num_cpus();
+        num_cpus_decision = CpuCount::decide(-1);
+        num_cpus_decision.num_cpus = num_cpus;
+        num_cpus_decision.reason = CpuCountDecision::OPENMP;
+        Options::ThreadAffinity::pin_main_thread();
         threads = new TaskExecutor<Options> *[num_cpus];
         task_queues = new TaskQueue*[num_cpus];
 
@@ -155,6 +160,9 @@ public:
     TaskQueue **get_task_queues() const { return const_cast<TaskQueue**>(&task_queues[0]); }
     TaskExecutor<Options> *get_worker(int i) { return threads[i]; }
     int get_num_cpus() { return num_cpus; }
+    // the number of threads is decided by the OpenMP runtime, but the
+    // limits that CpuCount would have applied are reported for comparison
+    const CpuCountDecision &get_num_cpus_decision() const { return num_cpus_decision; }
 };
 
 } // namespace sg
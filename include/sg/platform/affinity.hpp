@@ -35,6 +35,9 @@ struct affinity_cpu_set {
     void set(int cpu) {
         CPU_SET(cpu, &cpu_set);
     }
+    bool is_set(int cpu) const {
+        return CPU_ISSET(cpu, &cpu_set) != 0;
+    }
 };
 
 #elif __sun
@@ -46,12 +49,16 @@ struct affinity_cpu_set {
     void set(int cpu) {
         cpu_id = cpu;
     }
+    bool is_set(int cpu) const {
+        return cpu == cpu_id;
+    }
 };
   
 #elif __APPLE__
 
 struct affinity_cpu_set {
     void set(int) {}
+    bool is_set(int) const { return true; }
 };
 
 #elif _WIN32
@@ -62,6 +69,9 @@ struct affinity_cpu_set {
     void set(int cpu) {
         cpu_set |= static_cast<DWORD_PTR>(1) << static_cast<DWORD_PTR>(cpu);
     }
+    bool is_set(int cpu) const {
+        return (cpu_set & (static_cast<DWORD_PTR>(1) << static_cast<DWORD_PTR>(cpu))) != 0;
+    }
 };
 
 #else
@@ -70,6 +80,10 @@ struct affinity_cpu_set {
 
 // ===========================================================================
 // ThreadAffinity
+//
+// set_affinity() pins the calling thread.
+// get_affinity() returns the cpus the calling thread is allowed to run on,
+// or false if this is not known.
 // ===========================================================================
 
 struct ThreadAffinity {
@@ -77,23 +91,72 @@ struct ThreadAffinity {
     static void set_affinity(affinity_cpu_set &cpu_set) {
         assert(processor_bind(P_LWPID, P_MYID, cpu_set.cpu_id, NULL) == 0);
     }
+    static bool get_affinity(affinity_cpu_set &) {
+        return false;
+    }
 #elif __linux__
     static void set_affinity(affinity_cpu_set &cpu_set) {
         assert(sched_setaffinity(0, sizeof(cpu_set.cpu_set), &cpu_set.cpu_set) == 0);
     }
+    static bool get_affinity(affinity_cpu_set &cpu_set) {
+        return sched_getaffinity(0, sizeof(cpu_set.cpu_set), &cpu_set.cpu_set) == 0;
+    }
 #elif __APPLE__
     static void set_affinity(affinity_cpu_set &) {
         // setting cpu affinity not supported on mac
     }
+    static bool get_affinity(affinity_cpu_set &) {
+        return false;
+    }
 #elif _WIN32
     static void set_affinity(affinity_cpu_set &cpu_set) {
         SetThreadAffinityMask(GetCurrentThread(), cpu_set.cpu_set);
     }
+    static bool get_affinity(affinity_cpu_set &cpu_set) {
+        DWORD_PTR system_mask;
+        return GetProcessAffinityMask(GetCurrentProcess(), &cpu_set.cpu_set, &system_mask) != 0;
+    }
 #else
 #error Not implemented
 #endif
 };
 
+// ===========================================================================
+// ProcessAffinity
+//
+// get() returns the cpus the process may run on, or false if this is not
+// known. Runtimes pin their threads, including the main thread, and do not
+// restore its mask, so once a runtime has been created the mask of the
+// calling thread says nothing about the process. The mask is therefore read
+// once during static initialization, before any thread is pinned.
+// ===========================================================================
+
+struct ProcessAffinity {
+private:
+    struct InitialMask {
+        affinity_cpu_set cpu_set;
+        bool known;
+        InitialMask() : known(ThreadAffinity::get_affinity(cpu_set)) {}
+    };
+
+public:
+    static const InitialMask &get_initial() {
+        static InitialMask initial;
+        return initial;
+    }
+
+    static bool get(affinity_cpu_set &cpu_set) {
+        const InitialMask &initial(get_initial());
+        cpu_set = initial.cpu_set;
+        return initial.known;
+    }
+};
+
+namespace detail {
+// reads the mask during static initialization of each translation unit
+static const bool process_affinity_known = ProcessAffinity::get_initial().known;
+} // namespace detail
+
 } // namespace sg
 
 #endif // SG_AFFINITY_HPP_INCLUDED
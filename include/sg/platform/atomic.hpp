@@ -53,6 +53,12 @@ struct AtomicImpl {
         // read | read
         membar_consumer();
     }
+    static void memory_fence() {
+        // Full barrier: all loads and stores preceding the memory barrier
+        // complete before any loads or stores after the memory barrier.
+        membar_enter();
+        membar_exit();
+    }
 
     static bool lock_test_and_set(volatile unsigned int *ptr) {
         if (atomic_swap_32(ptr, 1) == 0) {
@@ -88,6 +94,7 @@ struct AtomicImpl {
 
     static void yield() { sched_yield(); }
     static void compiler_fence() { __asm __volatile ("":::"memory"); }
+    static void memory_fence() { __sync_synchronize(); }
 
 #if defined(__SSE2__)
 #if defined(__INTEL_COMPILER)
@@ -138,6 +145,7 @@ template<> struct AtomicImplAux<8> {
 struct AtomicImpl {
     static void memory_fence_producer() { MemoryBarrier(); }
     static void memory_fence_consumer() { MemoryBarrier(); }
+    static void memory_fence() { MemoryBarrier(); }
     static bool lock_test_and_set(volatile unsigned int *ptr) { return InterlockedBitTestAndSet((long *) ptr, 0) == 0; }
     static void lock_release(volatile unsigned int *ptr) { InterlockedBitTestAndReset((long *) ptr, 0); }
     static void yield() { rep_nop(); }
@@ -177,6 +185,9 @@ struct Atomic {
 
     static void memory_fence_producer() { detail::AtomicImpl::memory_fence_producer(); }
     static void memory_fence_consumer() { detail::AtomicImpl::memory_fence_consumer(); }
+
+    // full memory barrier, also orders stores before later loads
+    static void memory_fence() { detail::AtomicImpl::memory_fence(); }
     static void yield() { detail::AtomicImpl::yield(); }
 
     // rep_nop issues the "pause" instruction. also clobbers memory.
@@ -0,0 +1,232 @@
+#ifndef SG_CPUCOUNT_HPP_INCLUDED
+#define SG_CPUCOUNT_HPP_INCLUDED
+
+// ===========================================================================
+// CpuCount: Decide how many worker threads to use
+//
+// An explicit request (constructor argument or OMP_NUM_THREADS) is always
+// used as is. Otherwise, the number of threads is the smallest of:
+//
+//   - the number of online cpus
+//   - the number of cpus in the affinity mask of the process
+//   - the cgroup cpu quota (cgroup v2 cpu.max, or cgroup v1
+//     cpu.cfs_quota_us / cpu.cfs_period_us), rounded up
+//
+// The decision and the reason for it is returned in a CpuCountDecision, and
+// can be retrieved from the threading manager to be logged.
+// ===========================================================================
+
+#include "sg/platform/affinity.hpp"
+#include "sg/platform/fileutil.hpp"
+#include "sg/platform/platform.hpp"
+#include "sg/platform/threadutil.hpp"
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace sg {
+
+struct CpuCountDecision {
+    enum Reason {
+        REQUESTED,         // requested by the application
+        OMP_NUM_THREADS,   // set in the OMP_NUM_THREADS environment variable
+        OPENMP,            // decided by the OpenMP runtime
+        ONLINE_CPUS,       // number of online cpus
+        AFFINITY_MASK,     // limited by the affinity mask
+        CGROUP_QUOTA       // limited by the cgroup cpu quota
+    };
+
+    int num_cpus;     // the decision
+    Reason reason;
+    int online;       // number of online cpus
+    int affinity;     // number of cpus in the affinity mask, or -1 if unknown
+    double quota;     // cgroup cpu quota in cpus, or -1 if unlimited or unknown
+
+    CpuCountDecision()
+    : num_cpus(0), reason(ONLINE_CPUS), online(0), affinity(-1), quota(-1) {}
+
+    static const char *get_reason_name(Reason reason) {
+        switch (reason) {
+            case REQUESTED:       return "requested";
+            case OMP_NUM_THREADS: return "OMP_NUM_THREADS";
+            case OPENMP:          return "OpenMP runtime";
+            case ONLINE_CPUS:     return "online cpus";
+            case AFFINITY_MASK:   return "affinity mask";
+            case CGROUP_QUOTA:    return "cgroup cpu quota";
+        }
+        return "unknown";
+    }
+
+    // for example "8 threads (cgroup cpu quota): online=128 affinity=128 quota=7.50"
+    std::string to_string() const {
+        char buffer[256];
+        char quota_str[32] = "none";
+        if (quota > 0)
+            sprintf(quota_str, "%.2f", quota);
+        sprintf(buffer, "%d threads (%s): online=%d affinity=%d quota=%s",
+                num_cpus, get_reason_name(reason), online, affinity, quota_str);
+        return buffer;
+    }
+};
+
+class CpuCount {
+private:
+    // cgroup v2: cpu.max contains "<quota> <period>" or "max <period>"
+    static bool read_cpu_max(const std::string &dir, double &quota) {
+        std::string line;
+        if (!FileUtil::read_line(dir + "/cpu.max", line))
+            return false;
+        if (line.compare(0, 3, "max") == 0)
+            return false;
+        double q, period;
+        if (sscanf(line.c_str(), "%lf %lf", &q, &period) != 2 || q <= 0 || period <= 0)
+            return false;
+        quota = q / period;
+        return true;
+    }
+
+    // cgroup v1: cpu.cfs_quota_us is -1 if unlimited
+    static bool read_cfs_quota(const std::string &dir, double &quota) {
+        std::string line;
+        if (!FileUtil::read_line(dir + "/cpu.cfs_quota_us", line))
+            return false;
+        const double q = atof(line.c_str());
+        if (q <= 0 || !FileUtil::read_line(dir + "/cpu.cfs_period_us", line))
+            return false;
+        const double period = atof(line.c_str());
+        if (period <= 0)
+            return false;
+        quota = q / period;
+        return true;
+    }
+
+    // the smallest quota of the cgroup and its ancestors. the path from
+    // /proc/self/cgroup may not exist if the cgroup root is mounted inside a
+    // container, then the mount point itself is the cgroup.
+    static bool min_quota(const std::string &mount, std::string path,
+                          bool (*read)(const std::string &, double &), double &quota) {
+        bool found = false;
+        for (;;) {
+            double q;
+            if (read(mount + path, q) && (!found || q < quota)) {
+                quota = q;
+                found = true;
+            }
+            if (path.empty())
+                return found;
+            const std::string::size_type pos = path.rfind('/');
+            path = (pos == std::string::npos) ? std::string() : path.substr(0, pos);
+        }
+    }
+
+public:
+    // cgroup cpu quota in number of cpus, or false if unlimited or unknown
+    static bool get_cgroup_quota(double &quota) {
+#ifdef __linux__
+        FILE *f = fopen("/proc/self/cgroup", "r");
+        if (f == NULL)
+            return false;
+        bool found = false;
+        char buffer[4096];
+        while (fgets(buffer, sizeof(buffer), f) != NULL) {
+            // lines are "<id>:<controllers>:<path>"
+            std::string line(buffer);
+            if (!line.empty() && line[line.size()-1] == '\n')
+                line.erase(line.size()-1);
+            const std::string::size_type c1 = line.find(':');
+            const std::string::size_type c2 = line.find(':', c1 + 1);
+            if (c1 == std::string::npos || c2 == std::string::npos)
+                continue;
+            const std::string controllers(line.substr(c1 + 1, c2 - c1 - 1));
+            std::string path(line.substr(c2 + 1));
+            if (path == "/")
+                path.clear();
+
+            double q = 0.0;
+            bool success = false;
+            if (controllers.empty()) {
+                success = min_quota("/sys/fs/cgroup", path, read_cpu_max, q);
+            }
+            else if ((","+controllers+",").find(",cpu,") != std::string::npos) {
+                success = min_quota("/sys/fs/cgroup/cpu", path, read_cfs_quota, q)
+                       || min_quota("/sys/fs/cgroup/cpu,cpuacct", path, read_cfs_quota, q);
+            }
+            if (success && (!found || q < quota)) {
+                quota = q;
+                found = true;
+            }
+        }
+        fclose(f);
+        return found;
+#else
+        return false;
+#endif
+    }
+
+    // number of cpus in the affinity mask of the process, or -1 if unknown
+    static int get_affinity_count(int num_online) {
+        affinity_cpu_set mask;
+        if (!ProcessAffinity::get(mask))
+            return -1;
+        int count = 0;
+#ifdef __linux__
+        count = CPU_COUNT(&mask.cpu_set);
+#else
+        for (int i = 0; i < num_online; ++i)
+            if (mask.is_set(i))
+                ++count;
+#endif
+        return count > 0 ? count : -1;
+    }
+
+    // requested is -1 or 0 if no specific number of threads was requested
+    static CpuCountDecision decide(int requested) {
+        CpuCountDecision decision;
+        decision.online = ThreadUtil::get_num_cpus();
+
+        std::string var = sg_getenv("OMP_NUM_THREADS");
+        const int omp_num_threads = var.empty() ? 0 : atoi(var.c_str());
+
+        decision.affinity = get_affinity_count(decision.online);
+        if (!get_cgroup_quota(decision.quota))
+            decision.quota = -1;
+
+        if (omp_num_threads > 0) {
+            decision.num_cpus = omp_num_threads;
+            decision.reason = CpuCountDecision::OMP_NUM_THREADS;
+            return decision;
+        }
+        if (requested > 0) {
+            decision.num_cpus = requested;
+            decision.reason = CpuCountDecision::REQUESTED;
+            return decision;
+        }
+
+        decision.num_cpus = decision.online;
+        decision.reason = CpuCountDecision::ONLINE_CPUS;
+        if (decision.affinity > 0 && decision.affinity < decision.num_cpus) {
+            decision.num_cpus = decision.affinity;
+            decision.reason = CpuCountDecision::AFFINITY_MASK;
+        }
+        if (decision.quota > 0) {
+            int quota_cpus = static_cast<int>(decision.quota);
+            if (quota_cpus < decision.quota)
+                ++quota_cpus;
+            if (quota_cpus < 1)
+                quota_cpus = 1;
+            if (quota_cpus < decision.num_cpus) {
+                decision.num_cpus = quota_cpus;
+                decision.reason = CpuCountDecision::CGROUP_QUOTA;
+            }
+        }
+        if (decision.num_cpus < 1)
+            decision.num_cpus = 1;
+        return decision;
+    }
+};
+
+} // namespace sg
+
+#endif // SG_CPUCOUNT_HPP_INCLUDED
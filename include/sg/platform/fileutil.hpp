@@ -0,0 +1,31 @@
+#ifndef SG_FILEUTIL_HPP_INCLUDED
+#define SG_FILEUTIL_HPP_INCLUDED
+
+// ===========================================================================
+// FileUtil: Reading small system files, such as the ones in /sys and /proc
+// ===========================================================================
+
+#include <string>
+#include <cstdio>
+
+namespace sg {
+
+struct FileUtil {
+    // the first line of a file, including the newline. false if the file
+    // could not be opened or is empty
+    static bool read_line(const std::string &filename, std::string &line) {
+        FILE *f = fopen(filename.c_str(), "r");
+        if (f == NULL)
+            return false;
+        char buffer[4096];
+        const bool success = (fgets(buffer, sizeof(buffer), f) != NULL);
+        fclose(f);
+        if (success)
+            line = buffer;
+        return success;
+    }
+};
+
+} // namespace sg
+
+#endif // SG_FILEUTIL_HPP_INCLUDED
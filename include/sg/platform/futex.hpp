@@ -0,0 +1,47 @@
+#ifndef SG_FUTEX_HPP_INCLUDED
+#define SG_FUTEX_HPP_INCLUDED
+
+// ===========================================================================
+// Futex: Sleep until an integer changes
+//
+// wait(addr, expected) blocks while *addr == expected, until woken by
+// wake(addr, n). It may also return spuriously, so callers must recheck.
+//
+// On platforms without futexes, wait() just yields, which is correct but
+// does not free up the cpu.
+// ===========================================================================
+
+#include "sg/platform/atomic.hpp"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <climits>
+#endif
+
+namespace sg {
+
+struct Futex {
+#ifdef __linux__
+    static void wait(int *addr, int expected) {
+        syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+    }
+    static void wake(int *addr, int count) {
+        syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+    }
+    static void wake_all(int *addr) {
+        wake(addr, INT_MAX);
+    }
+#else
+    static void wait(int *, int) {
+        Atomic::yield();
+    }
+    static void wake(int *, int) {}
+    static void wake_all(int *) {}
+#endif
+};
+
+} // namespace sg
+
+#endif // SG_FUTEX_HPP_INCLUDED
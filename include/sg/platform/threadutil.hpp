@@ -67,6 +67,16 @@ public:
     #else
     #error Not implemented for this platform
     #endif
+
+    // static bool is_current_thread(ThreadIDType id)
+
+    #ifdef PTHREADS
+    static bool is_current_thread(ThreadIDType id) { return pthread_equal(pthread_self(), id) != 0; }
+    #elif _WIN32
+    static bool is_current_thread(ThreadIDType id) { return GetCurrentThreadId() == id; }
+    #else
+    #error Not implemented for this platform
+    #endif
 };
 
 } // namespace sg
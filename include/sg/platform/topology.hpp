@@ -0,0 +1,220 @@
+#ifndef SG_TOPOLOGY_HPP_INCLUDED
+#define SG_TOPOLOGY_HPP_INCLUDED
+
+// ===========================================================================
+// CpuTopology: Which logical cpus share cores, caches and NUMA nodes.
+//
+// On Linux this is read from /sys/devices/system/cpu. On other platforms,
+// or if the information is missing, every cpu is treated as a separate core
+// with no shared caches.
+//
+// The allowed cpus are the online cpus that the process may run on according
+// to its affinity mask (sched_getaffinity on Linux), as read before any
+// thread was pinned (see ProcessAffinity).
+// ===========================================================================
+
+#include "sg/platform/threadutil.hpp"
+#include "sg/platform/affinity.hpp"
+#include "sg/platform/fileutil.hpp"
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+namespace sg {
+
+class CpuTopology {
+public:
+    // how far apart two cpus are
+    enum Distance {
+        SAME_CORE = 0,   // same cpu, or SMT siblings
+        SAME_CACHE = 1,  // share last level (L3) cache
+        SAME_NODE = 2,   // same NUMA node (or same package, if NUMA information is missing)
+        REMOTE = 3
+    };
+
+    struct CpuInfo {
+        int core;     // identifier of the physical core (lowest sibling cpu)
+        int cache;    // identifier of the L3 cache (lowest cpu sharing it), or -1
+        int package;  // physical package (socket), or -1
+        int node;     // NUMA node, or -1
+        CpuInfo() : core(-1), cache(-1), package(-1), node(-1) {}
+    };
+
+private:
+    std::vector<CpuInfo> cpus;   // indexed by logical cpu number
+    std::vector<int> online;     // online logical cpu numbers, sorted
+    std::vector<int> allowed;    // online cpus in the affinity mask, sorted
+
+    static bool read_int(const std::string &filename, int &value) {
+        std::string line;
+        if (!FileUtil::read_line(filename, line))
+            return false;
+        value = atoi(line.c_str());
+        return true;
+    }
+
+    static bool read_cpulist(const std::string &filename, std::vector<int> &result) {
+        std::string line;
+        if (!FileUtil::read_line(filename, line))
+            return false;
+        return parse_cpulist(line, result);
+    }
+
+    static std::string cpu_path(int cpu) {
+        char path[64];
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/", cpu);
+        return path;
+    }
+
+    CpuInfo &info(int cpu) {
+        if (static_cast<size_t>(cpu) >= cpus.size())
+            cpus.resize(static_cast<size_t>(cpu) + 1);
+        return cpus[static_cast<size_t>(cpu)];
+    }
+
+#ifdef __linux__
+    void discover() {
+        if (!read_cpulist("/sys/devices/system/cpu/online", online))
+            return;
+
+        for (size_t i = 0; i < online.size(); ++i) {
+            const int cpu = online[i];
+            const std::string path(cpu_path(cpu));
+            CpuInfo &ci(info(cpu));
+            std::vector<int> list;
+
+            if (read_cpulist(path + "topology/thread_siblings_list", list))
+                ci.core = list[0];
+            read_int(path + "topology/physical_package_id", ci.package);
+
+            // find the L3 (or the highest level available) cache
+            int best_level = 0;
+            for (int index = 0; ; ++index) {
+                char name[64];
+                sprintf(name, "cache/index%d/", index);
+                int level = 0;
+                if (!read_int(path + name + "level", level))
+                    break;
+                if (level > best_level && read_cpulist(path + name + "shared_cpu_list", list)) {
+                    best_level = level;
+                    ci.cache = list[0];
+                }
+            }
+            // only count caches shared between cores
+            if (best_level < 2)
+                ci.cache = -1;
+
+            // NUMA node is given by a "nodeN" entry in the cpu directory
+            DIR *dir = opendir(path.c_str());
+            if (dir != NULL) {
+                struct dirent *entry;
+                while ((entry = readdir(dir)) != NULL) {
+                    const std::string name(entry->d_name);
+                    if (name.compare(0, 4, "node") == 0 && name.size() > 4
+                        && name[4] >= '0' && name[4] <= '9') {
+                        ci.node = atoi(name.c_str() + 4);
+                        break;
+                    }
+                }
+                closedir(dir);
+            }
+        }
+    }
+#else
+    void discover() {}
+#endif
+
+public:
+    // parse a cpu list such as "0-3,8,10-11"
+    static bool parse_cpulist(const std::string &text, std::vector<int> &result) {
+        result.clear();
+        const char *p = text.c_str();
+        while (*p != '\0' && *p != '\n') {
+            char *end;
+            const long first = strtol(p, &end, 10);
+            if (end == p)
+                return false;
+            long last = first;
+            p = end;
+            if (*p == '-') {
+                ++p;
+                last = strtol(p, &end, 10);
+                if (end == p)
+                    return false;
+                p = end;
+            }
+            for (long i = first; i <= last; ++i)
+                result.push_back(static_cast<int>(i));
+            if (*p == ',')
+                ++p;
+        }
+        return !result.empty();
+    }
+
+    CpuTopology() {
+        discover();
+        if (online.empty()) {
+            const int num = ThreadUtil::get_num_cpus();
+            for (int i = 0; i < num; ++i)
+                online.push_back(i);
+        }
+        for (size_t i = 0; i < online.size(); ++i) {
+            CpuInfo &ci(info(online[i]));
+            if (ci.core == -1)
+                ci.core = online[i];
+        }
+
+        affinity_cpu_set mask;
+        if (ProcessAffinity::get(mask)) {
+            for (size_t i = 0; i < online.size(); ++i)
+                if (mask.is_set(online[i]))
+                    allowed.push_back(online[i]);
+        }
+        if (allowed.empty())
+            allowed = online;
+    }
+
+    // shared instance, discovered on first use
+    static const CpuTopology &get() {
+        static CpuTopology topology;
+        return topology;
+    }
+
+    // online logical cpus, in increasing order
+    const std::vector<int> &get_online_cpus() const { return online; }
+
+    // online logical cpus that this process may run on, in increasing order
+    const std::vector<int> &get_allowed_cpus() const { return allowed; }
+
+    CpuInfo get_cpu_info(int cpu) const {
+        if (cpu < 0 || static_cast<size_t>(cpu) >= cpus.size())
+            return CpuInfo();
+        return cpus[static_cast<size_t>(cpu)];
+    }
+
+    Distance distance(int cpu_a, int cpu_b) const {
+        const CpuInfo a(get_cpu_info(cpu_a));
+        const CpuInfo b(get_cpu_info(cpu_b));
+        if (cpu_a == cpu_b || (a.core != -1 && a.core == b.core && a.package == b.package))
+            return SAME_CORE;
+        if (a.cache != -1 && a.cache == b.cache)
+            return SAME_CACHE;
+        if (a.node != -1 && b.node != -1) {
+            if (a.node == b.node)
+                return SAME_NODE;
+        }
+        else if (a.package != -1 && a.package == b.package)
+            return SAME_NODE;
+        return REMOTE;
+    }
+};
+
+} // namespace sg
+
+#endif // SG_TOPOLOGY_HPP_INCLUDED
@@ -10,6 +10,7 @@
 #include "sg/core/taskqueue.hpp"
 #include "sg/core/versionqueue.hpp"
 #include "sg/core/supergluebase.hpp"
+#include "sg/core/future.hpp"
 #include "sg/core/defaults.hpp"
 
 using namespace sg;
@@ -15,10 +15,26 @@ public:
 #include "unit/test_taskqueue.hpp"
 #include "unit/test_taskqueuedeque.hpp"
 #include "unit/test_taskqueueprio.hpp"
+#include "unit/test_taskqueuechaselev.hpp"
+#include "unit/test_taskqueuebuckets.hpp"
 #include "unit/test_tasks.hpp"
 #include "unit/test_locks.hpp"
 #include "unit/test_listqueue.hpp"
 #include "unit/test_rwc.hpp"
+#include "unit/test_stealorder.hpp"
+#include "unit/test_topology.hpp"
+#include "unit/test_idle.hpp"
+#include "unit/test_criticalpath.hpp"
+#include "unit/test_locality.hpp"
+#include "unit/test_submitpolicy.hpp"
+#include "unit/test_taskalloc.hpp"
+#include "unit/test_dependencycounting.hpp"
+#include "unit/test_barrier.hpp"
+#include "unit/test_taskgroup.hpp"
+#include "unit/test_wait.hpp"
+#include "unit/test_future.hpp"
+#include "unit/test_taskgraph.hpp"
+#include "unit/test_taskpool.hpp"
 #include "unit/test_subtasks.hpp"
 
 int main(int argc, char *argv[]) {
@@ -32,10 +48,26 @@ int main(int argc, char *argv[]) {
         new TestTaskQueue(),
         new TestTaskQueueDeque(),
         new TestTaskQueuePrio(),
+        new TestTaskQueueChaseLev(),
+        new TestTaskQueueBuckets(),
         new TestTasks(),
         new TestLocks(),
         new TestListQueue(),
         new TestRWC(),
+        new TestStealOrder(),
+        new TestTopology(),
+        new TestIdle(),
+        new TestCriticalPath(),
+        new TestLocality(),
+        new TestSubmitPolicy(),
+        new TestTaskAlloc(),
+        new TestDependencyCounting(),
+        new TestBarrier(),
+        new TestTaskGroup(),
+        new TestWait(),
+        new TestFuture(),
+        new TestTaskGraph(),
+        new TestTaskPool(),
         new TestSubtasks()
     };
 
@@ -0,0 +1,98 @@
+#ifndef SG_TEST_BARRIER_HPP_INCLUDED
+#define SG_TEST_BARRIER_HPP_INCLUDED
+
+#include "sg/option/barrier_tree.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+
+class TestBarrier : public TestCase {
+    struct OpCentral : public DefaultOptions<OpCentral> {
+        typedef AllowedCpusThreadAffinity<OpCentral> ThreadAffinity;
+    };
+    struct OpTree : public DefaultOptions<OpTree> {
+        typedef BarrierCounterTree<OpTree> BarrierCounter;
+        typedef AllowedCpusThreadAffinity<OpTree> ThreadAffinity;
+    };
+    struct OpTree2 : public DefaultOptions<OpTree2> {
+        typedef BarrierCounterTree<OpTree2, 2> BarrierCounter;
+        typedef AllowedCpusThreadAffinity<OpTree2> ThreadAffinity;
+    };
+
+    static const char *get_name(OpCentral) { return "testBarrierCentral"; }
+    static const char *get_name(OpTree) { return "testBarrierTree"; }
+    static const char *get_name(OpTree2) { return "testBarrierTree2"; }
+
+    template<typename Op>
+    class MyTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+
+    public:
+        MyTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { ++*value; }
+    };
+
+    // only the last of the workers to arrive in each stage completes it
+    template<typename Counter>
+    static bool testCounter(std::string &name) { name = "testCounter";
+        for (unsigned int num_workers = 1; num_workers <= 40; ++num_workers) {
+            Counter counter;
+            counter.init(num_workers);
+            for (unsigned int stage = 0; stage < 3; ++stage) {
+                for (unsigned int i = 0; i < num_workers; ++i) {
+                    // arrive in a different order in each stage
+                    const unsigned int index = (stage % 2 == 1) ? num_workers - 1 - i : (i + stage) % num_workers;
+                    if (counter.arrive(static_cast<int>(index)) != (i == num_workers - 1))
+                        return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // all tasks submitted before a barrier have finished after it
+    template<typename Op>
+    static bool testBarrier(std::string &name) { name = get_name(Op());
+        const int num_cpus[] = {2, 3, 6}; // 6: two levels with fan-in 4
+        for (size_t n = 0; n < sizeof(num_cpus)/sizeof(int); ++n) {
+            SuperGlue<Op> sg(num_cpus[n]);
+            const size_t num_handles = 16;
+            Handle<Op> h[num_handles];
+            size_t value[num_handles] = {0};
+            for (size_t round = 1; round <= 20; ++round) {
+                for (size_t i = 0; i < num_handles; ++i)
+                    sg.submit(new MyTask<Op>(h[i], &value[i]));
+                sg.barrier();
+                for (size_t i = 0; i < num_handles; ++i)
+                    if (value[i] != round)
+                        return false;
+            }
+            // empty barriers
+            for (size_t round = 0; round < 20; ++round)
+                sg.barrier();
+        }
+        return true;
+    }
+
+public:
+
+    std::string get_name() { return "TestBarrier"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testCounter<BarrierCounterCentral<OpCentral> >,
+            testCounter<BarrierCounterTree<OpTree> >,
+            testCounter<BarrierCounterTree<OpTree2, 2> >,
+            testBarrier<OpCentral>,
+            testBarrier<OpTree>,
+            testBarrier<OpTree2>
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_BARRIER_HPP_INCLUDED
@@ -0,0 +1,115 @@
+#ifndef SG_TEST_CRITICALPATH_HPP_INCLUDED
+#define SG_TEST_CRITICALPATH_HPP_INCLUDED
+
+#include "sg/option/taskqueue_buckets.hpp"
+
+#include <string>
+
+class TestCriticalPath : public TestCase {
+    struct OpCP : public DefaultOptions<OpCP> {
+        typedef Enable CriticalPath;
+        typedef Enable PauseExecution;
+        typedef TaskQueueBuckets<OpCP, 128> ReadyListType;
+    };
+
+    struct CostTask : public Task<OpCP> {
+        size_t *value;
+        CostTask(Handle<OpCP> &h, ReadWriteAdd::Type type, double cost, size_t *value_) : value(value_) {
+            if (cost >= 0.0)
+                set_cost(cost);
+            register_access(type, h);
+        }
+        void run() { Atomic::increase(value); }
+    };
+
+    static bool testLevels(std::string &name) { name = "testLevels";
+        SuperGlue<OpCP> sg;
+        Handle<OpCP> a, b;
+        size_t value = 0;
+        bool success = true;
+
+        // w1 -> w2 -> w3 -> {r1, r2} on a, and an independent write on b
+        CostTask *w1 = new CostTask(a, ReadWriteAdd::write, 2.0, &value);
+        CostTask *w2 = new CostTask(a, ReadWriteAdd::write, 2.0, &value);
+        sg.submit(w1);
+        sg.submit(w2);
+        success &= w1->get_critical_path_level() == 4.0;
+        success &= w2->get_critical_path_level() == 2.0;
+
+        CostTask *w3 = new CostTask(a, ReadWriteAdd::write, 2.0, &value);
+        CostTask *r1 = new CostTask(a, ReadWriteAdd::read, 10.0, &value);
+        CostTask *r2 = new CostTask(a, ReadWriteAdd::read, 1.0, &value);
+        CostTask *other = new CostTask(b, ReadWriteAdd::write, 3.0, &value);
+        // submit out of order: levels are updated as successors arrive
+        sg.submit(r1);
+        sg.submit(w3);
+        sg.submit(r2);
+        sg.submit(other);
+
+        success &= w1->get_critical_path_level() == 16.0;
+        success &= w2->get_critical_path_level() == 14.0;
+        success &= w3->get_critical_path_level() == 12.0;
+        success &= r1->get_critical_path_level() == 10.0;
+        success &= r2->get_critical_path_level() == 1.0;
+        success &= other->get_critical_path_level() == 3.0;
+
+        sg.start_executing();
+        sg.barrier();
+        return success && value == 6;
+    }
+
+    static bool testPropagation(std::string &name) { name = "testPropagation";
+        SuperGlue<OpCP> sg;
+        Handle<OpCP> a;
+        size_t value = 0;
+        bool success = true;
+
+        // small increases at the end of a chain add up until they reach
+        // its start. the exact levels would be 400 and 300.
+        CostTask *w1 = new CostTask(a, ReadWriteAdd::write, 100.0, &value);
+        CostTask *w2 = new CostTask(a, ReadWriteAdd::write, 100.0, &value);
+        sg.submit(w1);
+        sg.submit(w2);
+        for (int i = 0; i < 20; ++i)
+            sg.submit(new CostTask(a, ReadWriteAdd::write, 10.0, &value));
+
+        success &= w1->get_critical_path_level() > 350.0;
+        success &= w1->get_critical_path_level() <= 400.0;
+        success &= w2->get_critical_path_level() > 250.0;
+        success &= w2->get_critical_path_level() <= 300.0;
+
+        sg.start_executing();
+        sg.barrier();
+        return success && value == 22;
+    }
+
+    static bool testLearned(std::string &name) { name = "testLearned";
+        SuperGlue<OpCP> sg;
+        const size_t num_handles = 10;
+        Handle<OpCP> h[num_handles];
+        size_t value = 0;
+
+        for (size_t i = 0; i < 1000; ++i)
+            sg.submit(new CostTask(h[i % num_handles], i % 3 == 0 ? ReadWriteAdd::write : ReadWriteAdd::read, -1.0, &value));
+        sg.start_executing();
+        sg.barrier();
+        for (size_t i = 0; i < 1000; ++i)
+            sg.submit(new CostTask(h[i % num_handles], ReadWriteAdd::add, -1.0, &value));
+        sg.barrier();
+        return value == 2000;
+    }
+
+public:
+
+    std::string get_name() { return "TestCriticalPath"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testLevels, testPropagation, testLearned
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_CRITICALPATH_HPP_INCLUDED
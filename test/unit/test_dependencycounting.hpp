@@ -0,0 +1,157 @@
+#ifndef SG_TEST_DEPENDENCYCOUNTING_HPP_INCLUDED
+#define SG_TEST_DEPENDENCYCOUNTING_HPP_INCLUDED
+
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+
+class TestDependencyCounting : public TestCase {
+    struct OpScan : public DefaultOptions<OpScan> {
+        typedef AllowedCpusThreadAffinity<OpScan> ThreadAffinity;
+    };
+    struct OpCounting : public DefaultOptions<OpCounting> {
+        typedef Enable DependencyCounting;
+        typedef AllowedCpusThreadAffinity<OpCounting> ThreadAffinity;
+    };
+    struct OpCountingCompact : public DefaultOptions<OpCountingCompact> {
+        typedef Enable DependencyCounting;
+        typedef Enable CompactHandle;
+        typedef AllowedCpusThreadAffinity<OpCountingCompact> ThreadAffinity;
+    };
+
+    struct OpRing : public DefaultOptions<OpRing> {
+        typedef Enable DependencyCounting;
+        typedef Enable LockFreeVersionQueue;
+        typedef AllowedCpusThreadAffinity<OpRing> ThreadAffinity;
+    };
+    struct OpRingCompact : public DefaultOptions<OpRingCompact> {
+        typedef Enable DependencyCounting;
+        typedef Enable LockFreeVersionQueue;
+        typedef Enable CompactHandle;
+        typedef AllowedCpusThreadAffinity<OpRingCompact> ThreadAffinity;
+    };
+    struct OpRingPaused : public DefaultOptions<OpRingPaused> {
+        typedef Enable DependencyCounting;
+        typedef Enable LockFreeVersionQueue;
+        typedef Enable PauseExecution;
+        typedef AllowedCpusThreadAffinity<OpRingPaused> ThreadAffinity;
+    };
+
+    static const char *get_name(OpScan) { return "testFanIn"; }
+    static const char *get_name(OpCounting) { return "testFanInCounting"; }
+    static const char *get_name(OpCountingCompact) { return "testFanInCountingCompact"; }
+    static const char *get_name(OpRing) { return "testFanInRing"; }
+    static const char *get_name(OpRingCompact) { return "testFanInRingCompact"; }
+
+    enum { WIDTH = 16 };
+
+    // writes one handle
+    template<typename Op>
+    class WriteTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+    public:
+        WriteTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { ++(*value); }
+    };
+
+    // reads all handles, and adds to the sum
+    template<typename Op>
+    class SumTask : public Task<Op> {
+    private:
+        size_t *values;
+        size_t round;
+        bool *success;
+    public:
+        SumTask(Handle<Op> *h, Handle<Op> &sum, size_t *values_, size_t round_, bool *success_)
+         : values(values_), round(round_), success(success_) {
+            for (size_t i = 0; i < WIDTH; ++i)
+                this->register_access(ReadWriteAdd::read, h[i]);
+            this->register_access(ReadWriteAdd::add, sum);
+        }
+        void run() {
+            for (size_t i = 0; i < WIDTH; ++i)
+                if (values[i] != round + 1)
+                    *success = false;
+        }
+    };
+
+    template<typename Op>
+    static bool testFanIn(std::string &name) { name = get_name(Op());
+        SuperGlue<Op> sg(4);
+        Handle<Op> h[WIDTH];
+        Handle<Op> sum;
+        size_t values[WIDTH] = {0};
+        bool success = true;
+
+        // each round writes all handles, and then reads all of them in one task
+        for (size_t round = 0; round < 200; ++round) {
+            for (size_t i = 0; i < WIDTH; ++i)
+                sg.submit(new WriteTask<Op>(h[i], &values[i]));
+            sg.submit(new SumTask<Op>(h, sum, values, round, &success));
+        }
+        sg.barrier();
+
+        for (size_t i = 0; i < WIDTH; ++i)
+            success &= (values[i] == 200);
+        return success;
+    }
+
+    // checks that it runs after the previous write, and adds to the sum
+    class ReadTask : public Task<OpRingPaused, 2> {
+    private:
+        size_t *value;
+        size_t expected;
+        size_t *sum;
+        bool *success;
+    public:
+        ReadTask(Handle<OpRingPaused> &h, Handle<OpRingPaused> &s, size_t *value_,
+                 size_t expected_, size_t *sum_, bool *success_)
+         : value(value_), expected(expected_), sum(sum_), success(success_) {
+            register_access(ReadWriteAdd::read, h);
+            register_access(ReadWriteAdd::add, s);
+        }
+        void run() {
+            if (*value != expected)
+                *success = false;
+            ++(*sum);
+        }
+    };
+
+    // versions far ahead of the current version do not fit in the ring
+    static bool testRingOverflow(std::string &name) { name = "testRingOverflow";
+        SuperGlue<OpRingPaused> sg(4);
+        Handle<OpRingPaused> h, s;
+        size_t value = 0;
+        size_t sum = 0;
+        bool success = true;
+        for (size_t i = 0; i < 500; ++i) {
+            sg.submit(new WriteTask<OpRingPaused>(h, &value));
+            for (size_t j = 0; j < 20; ++j)
+                sg.submit(new ReadTask(h, s, &value, i + 1, &sum, &success));
+        }
+        sg.start_executing();
+        sg.barrier();
+        return success && value == 500 && sum == 500 * 20;
+    }
+
+public:
+    std::string get_name() { return "TestDependencyCounting"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testFanIn<OpScan>,
+            testFanIn<OpCounting>,
+            testFanIn<OpCountingCompact>,
+            testFanIn<OpRing>,
+            testFanIn<OpRingCompact>,
+            testRingOverflow
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_DEPENDENCYCOUNTING_HPP_INCLUDED
@@ -0,0 +1,139 @@
+#ifndef SG_TEST_FUTURE_HPP_INCLUDED
+#define SG_TEST_FUTURE_HPP_INCLUDED
+
+#include "sg/option/taskalloc_slab.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/threads.hpp"
+
+#include <string>
+
+class TestFuture : public TestCase {
+    struct OpFuture : public DefaultOptions<OpFuture> {
+        typedef AllowedCpusThreadAffinity<OpFuture> ThreadAffinity;
+    };
+    struct OpFutureSlab : public DefaultOptions<OpFutureSlab> {
+        typedef TaskAllocSlab<OpFutureSlab> TaskAllocator;
+        typedef AllowedCpusThreadAffinity<OpFutureSlab> ThreadAffinity;
+    };
+
+    static const char *get_name(OpFuture, const char *name) { return name; }
+    static std::string get_name(OpFutureSlab, const char *name) { return std::string(name) + "Slab"; }
+
+    static int forty_two() { return 42; }
+    static double half(const int &x) { return x * 0.5; }
+
+    struct AddOne {
+        typedef size_t result_type;
+        size_t operator()(size_t x) const { return x + 1; }
+    };
+
+    struct Zero {
+        typedef size_t result_type;
+        size_t operator()() const { return 0; }
+    };
+
+    // counts live instances, to check that shared states are deleted
+    struct Counted {
+        static int live;
+        int value;
+        Counted() : value(0) { Atomic::increase(&live); }
+        Counted(const Counted &rhs) : value(rhs.value) { Atomic::increase(&live); }
+        ~Counted() { Atomic::decrease(&live); }
+    };
+    struct MakeCounted {
+        typedef Counted result_type;
+        Counted operator()() const { Counted c; c.value = 1; return c; }
+    };
+    struct IncCounted {
+        typedef Counted result_type;
+        Counted operator()(const Counted &in) const { Counted c; c.value = in.value + 1; return c; }
+    };
+
+    struct GetThread : public Thread {
+        Future<OpFuture, size_t> future;
+        size_t result;
+        GetThread(const Future<OpFuture, size_t> &future_) : future(future_), result(0) {}
+        void run() { result = future.get(); }
+    };
+
+    static bool testFunctions(std::string &name) { name = "testFunctions";
+        SuperGlue<OpFuture> sg(4);
+        Future<OpFuture, int> a(submit_future(sg, forty_two));
+        Future<OpFuture, double> b(a.then(half));
+        return b.get() == 21.0 && a.get() == 42 && a.is_ready();
+    }
+
+    // a pipeline of small continuations
+    template<typename Op>
+    static bool testChain(std::string &name) { name = get_name(Op(), "testChain");
+        SuperGlue<Op> sg(4);
+        const size_t num_steps = 1000;
+        Future<Op, size_t> f(submit_future(sg, Zero()));
+        for (size_t i = 0; i < num_steps; ++i)
+            f = f.then(AddOne());
+        return f.get() == num_steps;
+    }
+
+    // many continuations of the same future
+    static bool testFanOut(std::string &name) { name = "testFanOut";
+        SuperGlue<OpFuture> sg(4);
+        Future<OpFuture, size_t> root(submit_future(sg, Zero()));
+        const size_t num_children = 64;
+        Future<OpFuture, size_t> children[num_children];
+        for (size_t i = 0; i < num_children; ++i)
+            children[i] = root.then(AddOne()).then(AddOne());
+        for (size_t i = 0; i < num_children; ++i)
+            if (children[i].get() != 2)
+                return false;
+        return true;
+    }
+
+    // a thread outside the runtime waits for a future
+    static bool testOtherThread(std::string &name) { name = "testOtherThread";
+        SuperGlue<OpFuture> sg(4);
+        Future<OpFuture, size_t> f(submit_future(sg, Zero()));
+        for (size_t i = 0; i < 100; ++i)
+            f = f.then(AddOne());
+        GetThread thread(f);
+        thread.start();
+        thread.join();
+        return thread.result == 100;
+    }
+
+    // shared states are deleted with the last future or task that uses them
+    static bool testRelease(std::string &name) { name = "testRelease";
+        bool success = true;
+        {
+            SuperGlue<OpFuture> sg(4);
+            {
+                Future<OpFuture, Counted> f(submit_future(sg, MakeCounted()));
+                for (size_t i = 0; i < 10; ++i)
+                    f.then(IncCounted()).then(IncCounted());
+                success &= (f.then(IncCounted()).get().value == 2);
+            }
+            sg.barrier();
+        }
+        return success && Counted::live == 0;
+    }
+
+public:
+
+    std::string get_name() { return "TestFuture"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testFunctions,
+            testChain<OpFuture>,
+            testChain<OpFutureSlab>,
+            testFanOut,
+            testOtherThread,
+            testRelease
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+int TestFuture::Counted::live = 0;
+
+#endif // SG_TEST_FUTURE_HPP_INCLUDED
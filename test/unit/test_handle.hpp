@@ -26,6 +26,21 @@ class TestHandle : public TestCase {
         typedef Enable HandleId;
         typedef Enable Lockable;
     };
+    struct OpCompact : public DefaultOptions<OpCompact> {
+        typedef Enable CompactHandle;
+    };
+
+    class WriteTask : public Task<OpCompact, 2> {
+        unsigned int *values;
+        int src, dst;
+    public:
+        WriteTask(Handle<OpCompact> *h, unsigned int *values_, int src_, int dst_)
+        : values(values_), src(src_), dst(dst_) {
+            register_access(ReadWriteAdd::read, h[src]);
+            register_access(ReadWriteAdd::write, h[dst]);
+        }
+        void run() { values[dst] = 2*values[dst] + values[src] + 1; }
+    };
 
     static bool testName(std::string &name) { name = "testName";
         Handle<OpName> h1, h2;
@@ -64,6 +79,30 @@ class TestHandle : public TestCase {
         return true;
     }
 
+    static bool testCompact(std::string &name) { name = "testCompact";
+        if (sizeof(Handle<OpCompact>) >= sizeof(Handle<OpDefault>))
+            return false;
+
+        // chains of tasks, so that tasks wait for versions of compact handles
+        const int n = 16;
+        Handle<OpCompact> h[n];
+        unsigned int values[n] = {0};
+        unsigned int expected[n] = {0};
+        SuperGlue<OpCompact> sg;
+        for (int i = 0; i < 20; ++i) {
+            for (int j = 1; j < n; ++j) {
+                sg.submit(new WriteTask(h, values, j-1, j));
+                expected[j] = 2*expected[j] + expected[j-1] + 1;
+            }
+        }
+        sg.barrier();
+
+        for (int j = 0; j < n; ++j)
+            if (values[j] != expected[j])
+                return false;
+        return true;
+    }
+
     static bool testCombos(std::string &name) { name = "testCombos";
         Handle<OpAll> h1;
         return true;
@@ -74,7 +113,7 @@ public:
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-            testName, testId, testLockable, testSubTasks, testCombos
+            testName, testId, testLockable, testSubTasks, testCompact, testCombos
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
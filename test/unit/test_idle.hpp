@@ -0,0 +1,83 @@
+#ifndef SG_TEST_IDLE_HPP_INCLUDED
+#define SG_TEST_IDLE_HPP_INCLUDED
+
+#include "sg/option/idle_parking.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+#include <unistd.h>
+
+class TestIdle : public TestCase {
+    struct OpParking : public DefaultOptions<OpParking> {
+        typedef IdleParking<OpParking, 10, 10> IdlePolicy;
+        typedef AllowedCpusThreadAffinity<OpParking> ThreadAffinity;
+    };
+    struct OpParkingNoSteal : public DefaultOptions<OpParkingNoSteal> {
+        typedef IdleParking<OpParkingNoSteal, 10, 10> IdlePolicy;
+        typedef AllowedCpusThreadAffinity<OpParkingNoSteal> ThreadAffinity;
+        typedef Disable Stealing;
+    };
+
+    static const char *get_name(OpParking) { return "testParking"; }
+    static const char *get_name(OpParkingNoSteal) { return "testParkingNoSteal"; }
+
+    template<typename Op>
+    class MyTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+
+    public:
+        MyTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { ++*value; }
+    };
+
+    // wait until all workers are sleeping, or give up after a while
+    template<typename Op>
+    static bool wait_for_sleepers(SuperGlue<Op> &sg) {
+        const int num_workers(sg.get_num_cpus() - 1);
+        for (int i = 0; i < 2000; ++i) {
+            if (sg.tman->barrier_protocol.get_idle_policy().get_num_sleepers() == num_workers)
+                return true;
+            usleep(1000);
+        }
+        return false;
+    }
+
+    template<typename Op>
+    static bool testParking(std::string &name) { name = get_name(Op());
+        const size_t num_handles = 8;
+        size_t value[num_handles] = {0};
+        Handle<Op> h[num_handles];
+        bool success = true;
+        {
+            SuperGlue<Op> sg(4);
+            for (size_t round = 0; round < 3; ++round) {
+                success &= wait_for_sleepers(sg);
+                for (size_t i = 0; i < 1000; ++i)
+                    sg.submit(new MyTask<Op>(h[i % num_handles], &value[i % num_handles]));
+                sg.barrier();
+            }
+            success &= wait_for_sleepers(sg);
+            // workers are woken when the threading manager is stopped
+        }
+        for (size_t i = 0; i < num_handles; ++i)
+            success &= (value[i] == 3000/num_handles);
+        return success;
+    }
+
+public:
+
+    std::string get_name() { return "TestIdle"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testParking<OpParking>, testParking<OpParkingNoSteal>
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_IDLE_HPP_INCLUDED
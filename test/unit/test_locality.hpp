@@ -0,0 +1,180 @@
+#ifndef SG_TEST_LOCALITY_HPP_INCLUDED
+#define SG_TEST_LOCALITY_HPP_INCLUDED
+
+#include "sg/option/taskqueue_chaselev.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+
+class TestLocality : public TestCase {
+    struct OpLocality : public DefaultOptions<OpLocality> {
+        typedef Enable LocalityRouting;
+        typedef Enable PassTaskExecutor;
+        typedef AllowedCpusThreadAffinity<OpLocality> ThreadAffinity;
+    };
+    struct OpLocalityChaseLev : public DefaultOptions<OpLocalityChaseLev> {
+        typedef Enable LocalityRouting;
+        typedef Enable PassTaskExecutor;
+        typedef TaskQueueChaseLev<OpLocalityChaseLev> ReadyListType;
+        typedef AllowedCpusThreadAffinity<OpLocalityChaseLev> ThreadAffinity;
+    };
+    struct OpWokenNoStealing : public DefaultOptions<OpWokenNoStealing> {
+        typedef Enable LocalityRouting;
+        typedef Enable PassTaskExecutor;
+        typedef Disable Stealing;
+        typedef AllowedCpusThreadAffinity<OpWokenNoStealing> ThreadAffinity;
+    };
+    struct OpWokenChaseLev : public DefaultOptions<OpWokenChaseLev> {
+        typedef Enable LocalityRouting;
+        typedef Enable PassTaskExecutor;
+        typedef Disable Stealing;
+        typedef TaskQueueChaseLev<OpWokenChaseLev> ReadyListType;
+        typedef AllowedCpusThreadAffinity<OpWokenChaseLev> ThreadAffinity;
+    };
+
+    static const char *get_name(OpLocality) { return "testRouting"; }
+    static const char *get_name(OpLocalityChaseLev) { return "testRoutingChaseLev"; }
+    static const char *get_name(OpWokenNoStealing) { return "testWokenWorker"; }
+    static const char *get_name(OpWokenChaseLev) { return "testWokenWorkerChaseLev"; }
+
+    template<typename Op>
+    class WriteTask : public Task<Op, 1> {
+    private:
+        int *worker;
+    public:
+        WriteTask(Handle<Op> &h, int *worker_) : worker(worker_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run(TaskExecutor<Op> &te) { *worker = te.get_id(); }
+    };
+
+    // records the worker it ran on, and when
+    template<typename Op>
+    class AccessTask : public Task<Op, 2> {
+    private:
+        int *counter;
+        int *worker;
+        int *step;
+    public:
+        AccessTask(Handle<Op> &a, int type_a, Handle<Op> &b, int type_b,
+                   int *counter_, int *worker_, int *step_)
+          : counter(counter_), worker(worker_), step(step_) {
+            this->register_access(static_cast<ReadWriteAdd::Type>(type_a), a);
+            this->register_access(static_cast<ReadWriteAdd::Type>(type_b), b);
+        }
+        void run(TaskExecutor<Op> &te) {
+            *worker = te.get_id();
+            *step = Atomic::increase_nv(counter);
+        }
+    };
+
+    // waits until the flag is set, or sets it
+    template<typename Op>
+    class FlagTask : public Task<Op, 1> {
+    private:
+        int *flag;
+        bool wait;
+    public:
+        FlagTask(Handle<Op> &h, int *flag_, bool wait_) : flag(flag_), wait(wait_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run(TaskExecutor<Op> &) {
+            if (!wait) {
+                Atomic::increase(flag);
+                return;
+            }
+            while (*static_cast<volatile int *>(flag) == 0)
+                Atomic::yield();
+        }
+    };
+
+    // reads a and b, and adds to c
+    template<typename Op>
+    class UpdateTask : public Task<Op, 3> {
+    private:
+        size_t *value;
+    public:
+        UpdateTask(Handle<Op> &a, Handle<Op> &b, Handle<Op> &c, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::read, a);
+            this->register_access(ReadWriteAdd::read, b);
+            this->register_access(ReadWriteAdd::add, c);
+        }
+        void run(TaskExecutor<Op> &) { Atomic::increase(value); }
+    };
+
+    static bool testLastWriter(std::string &name) { name = "testLastWriter";
+        SuperGlue<OpLocality> sg;
+        Handle<OpLocality> h;
+        int worker = -1;
+        bool success = (h.get_last_writer() == -1);
+        for (size_t i = 0; i < 100; ++i) {
+            sg.submit(new WriteTask<OpLocality>(h, &worker));
+            sg.barrier();
+            success &= (worker != -1 && h.get_last_writer() == worker);
+        }
+        return success;
+    }
+
+    template<typename Op>
+    static bool testRouting(std::string &name) { name = get_name(Op());
+        const size_t num_handles = 16;
+        Handle<Op> h[num_handles];
+        size_t value = 0;
+        SuperGlue<Op> sg(4);
+        for (size_t round = 0; round < 10; ++round) {
+            for (size_t i = 0; i < 1000; ++i)
+                sg.submit(new UpdateTask<Op>(h[i % 8], h[8 + (i*3) % 4], h[12 + (i*5) % 4], &value));
+            sg.barrier();
+        }
+        return value == 10000;
+    }
+
+    // a task woken on worker 0 runs on worker 1, which last wrote its data,
+    // before the tasks that were already queued there
+    template<typename Op>
+    static bool testWokenWorker(std::string &name) { name = get_name(Op());
+        SuperGlue<Op> sg(2);
+        bool success = true;
+        for (size_t round = 0; round < 10; ++round) {
+            Handle<Op> g, h, k, f, w, s;
+            int counter = 0, flag = 0;
+            int writer = -1, reader = -1, woken = -1, filler = -1;
+            int writer_step = 0, reader_step = 0, woken_step = 0, filler_step = 0;
+            sg.submit(new AccessTask<Op>(g, ReadWriteAdd::write, h, ReadWriteAdd::write,
+                                         &counter, &writer, &writer_step), 1);
+            sg.barrier();
+
+            // worker 1 waits for the flag, with another task queued behind.
+            // without stealing, only the main thread (worker 0) runs tasks from
+            // queue 0: the reader wakes the writer of g, which is routed to
+            // worker 1 before the flag is set.
+            sg.submit(new FlagTask<Op>(w, &flag, true), 1);
+            sg.submit(new AccessTask<Op>(f, ReadWriteAdd::write, k, ReadWriteAdd::read,
+                                         &counter, &filler, &filler_step), 1);
+            sg.submit(new AccessTask<Op>(g, ReadWriteAdd::read, k, ReadWriteAdd::read,
+                                         &counter, &reader, &reader_step), 0);
+            sg.submit(new AccessTask<Op>(g, ReadWriteAdd::write, h, ReadWriteAdd::read,
+                                         &counter, &woken, &woken_step), 0);
+            sg.submit(new FlagTask<Op>(s, &flag, false), 0);
+            sg.barrier();
+            success &= (writer == 1 && reader == 0 && woken == 1 && filler == 1);
+            success &= (reader_step < woken_step && woken_step < filler_step);
+        }
+        return success;
+    }
+
+public:
+
+    std::string get_name() { return "TestLocality"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testLastWriter, testRouting<OpLocality>, testRouting<OpLocalityChaseLev>,
+            testWokenWorker<OpWokenNoStealing>, testWokenWorker<OpWokenChaseLev>
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_LOCALITY_HPP_INCLUDED
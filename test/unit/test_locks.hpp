@@ -1,12 +1,38 @@
 #ifndef SG_TEST_LOCKS_HPP_INCLUDED
 #define SG_TEST_LOCKS_HPP_INCLUDED
 
+#include "sg/option/threadaffinity_topology.hpp"
+
 #include <string>
 
 class TestLocks : public TestCase {
     struct OpLockable : public DefaultOptions<OpLockable> {};
+    struct OpLockableCompact : public DefaultOptions<OpLockableCompact> {
+        typedef Enable CompactHandle;
+    };
+    struct OpLockableThreads : public DefaultOptions<OpLockableThreads> {
+        typedef AllowedCpusThreadAffinity<OpLockableThreads> ThreadAffinity;
+    };
+    struct OpLockHandoff : public DefaultOptions<OpLockHandoff> {
+        typedef Enable LockHandoff;
+        typedef AllowedCpusThreadAffinity<OpLockHandoff> ThreadAffinity;
+    };
+    struct OpOrdered : public DefaultOptions<OpOrdered> {
+        typedef Enable OrderedLocking;
+        typedef AllowedCpusThreadAffinity<OpOrdered> ThreadAffinity;
+    };
+    struct OpOrderedHandoff : public DefaultOptions<OpOrderedHandoff> {
+        typedef Enable OrderedLocking;
+        typedef Enable LockHandoff;
+        typedef AllowedCpusThreadAffinity<OpOrderedHandoff> ThreadAffinity;
+    };
 
     static const char *get_name(OpLockable) { return "testLockable"; }
+    static const char *get_name(OpLockableCompact) { return "testLockableCompact"; }
+    static const char *get_name(OpLockableThreads) { return "testLockableThreads"; }
+    static const char *get_name(OpLockHandoff) { return "testLockHandoff"; }
+    static const char *get_name(OpOrdered) { return "testOrdered"; }
+    static const char *get_name(OpOrderedHandoff) { return "testOrderedHandoff"; }
 
     template<typename Op>
     class MyTask : public Task<Op, 1> {
@@ -20,6 +46,54 @@ class TestLocks : public TestCase {
         void run() { *value += 1; }
     };
 
+    // locks two handles and part of a resource
+    template<typename Op>
+    class ResourceTask : public Task<Op, 3> {
+    private:
+        size_t *value0, *value1;
+        long *in_use;
+        long quantity;
+        bool *overused;
+
+    public:
+        ResourceTask(Handle<Op> &h0, size_t *value0_, Handle<Op> &h1, size_t *value1_,
+                     Resource<Op> &res, long quantity_, long *in_use_, bool *overused_)
+        : value0(value0_), value1(value1_), in_use(in_use_), quantity(quantity_), overused(overused_) {
+            this->register_access(ReadWriteAdd::add, h0);
+            this->register_access(ReadWriteAdd::add, h1);
+            this->require(res, quantity);
+        }
+        void run() {
+            if (Atomic::add_nv(in_use, quantity) > 3)
+                *overused = true;
+            *value0 += 1;
+            *value1 += 1;
+            Atomic::add_nv(in_use, -quantity);
+        }
+    };
+
+    // locks two handles, and checks that no other task holds them
+    template<typename Op>
+    class ExclusiveTask : public Task<Op, 2> {
+    private:
+        long *holders0, *holders1;
+        bool *shared;
+
+    public:
+        ExclusiveTask(Handle<Op> &h0, long *holders0_, Handle<Op> &h1, long *holders1_, bool *shared_)
+        : holders0(holders0_), holders1(holders1_), shared(shared_) {
+            this->register_access(ReadWriteAdd::add, h0);
+            this->register_access(ReadWriteAdd::add, h1);
+        }
+        void run() {
+            if (Atomic::increase_nv(holders0) != 1 || Atomic::increase_nv(holders1) != 1)
+                *shared = true;
+            Atomic::yield();
+            Atomic::decrease(holders0);
+            Atomic::decrease(holders1);
+        }
+    };
+
     template<typename Op>
     static bool testLockable(std::string &name) { name = get_name(Op());
 
@@ -35,13 +109,66 @@ class TestLocks : public TestCase {
         return value == 1000;
     }
 
+    template<typename Op>
+    static bool testResource(std::string &name) { name = std::string(get_name(Op())) + "Resource";
+
+        SuperGlue<Op> sg(4);
+        Handle<Op> h[3];
+        Resource<Op> res(3);
+
+        size_t value[3] = {0, 0, 0};
+        long in_use = 0;
+        bool overused = false;
+
+        for (size_t i = 0; i < 3000; ++i)
+            sg.submit(new ResourceTask<Op>(h[i % 3], &value[i % 3], h[(i + 1) % 3], &value[(i + 1) % 3],
+                                           res, static_cast<long>(i % 3) + 1, &in_use, &overused));
+        sg.barrier();
+
+        return !overused && in_use == 0
+            && value[0] == 2000 && value[1] == 2000 && value[2] == 2000;
+    }
+
+    // tasks lock pairs of handles in both orders
+    template<typename Op>
+    static bool testExclusive(std::string &name) { name = std::string(get_name(Op())) + "Exclusive";
+
+        SuperGlue<Op> sg(4);
+        const size_t num_handles = 4;
+        Handle<Op> h[num_handles];
+        long holders[num_handles] = {0, 0, 0, 0};
+        bool shared = false;
+
+        for (size_t i = 0; i < 4000; ++i) {
+            const size_t a = i % num_handles;
+            const size_t b = (i / num_handles + a + 1) % num_handles;
+            if (a == b)
+                continue;
+            sg.submit(new ExclusiveTask<Op>(h[a], &holders[a], h[b], &holders[b], &shared));
+        }
+        sg.barrier();
+        return !shared;
+    }
+
 public:
 
     std::string get_name() { return "TestLocks"; }
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-            testLockable<OpLockable>
+            testLockable<OpLockable>,
+            testLockable<OpLockableCompact>,
+            testLockable<OpLockableThreads>,
+            testLockable<OpLockHandoff>,
+            testResource<OpLockableThreads>,
+            testResource<OpLockHandoff>,
+            testLockable<OpOrdered>,
+            testResource<OpOrdered>,
+            testResource<OpOrderedHandoff>,
+            testExclusive<OpLockableThreads>,
+            testExclusive<OpLockHandoff>,
+            testExclusive<OpOrdered>,
+            testExclusive<OpOrderedHandoff>
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
@@ -2,7 +2,9 @@
 #define SG_TEST_SCHEDVER_HPP_INCLUDED
 
 #include "sg/option/access_rwc.hpp"
+#include "sg/platform/threads.hpp"
 #include <string>
+#include <vector>
 
 using namespace sg;
 
@@ -64,6 +66,56 @@ class TestSchedulerVer : public TestCase {
         return true;
     }
 
+    // same results as the locked version, for a mix of access types
+    static bool testLockFree(std::string &name) { name = "testLockFree";
+        detail::SchedulerVersionLocked<OpDefault> locked;
+        detail::SchedulerVersionLockFree<OpDefault> lockfree;
+        unsigned int seed = 1;
+        for (size_t i = 0; i < 10000; ++i) {
+            seed = seed * 1664525 + 1013904223;
+            const int type = static_cast<int>((seed >> 16) % 3);
+            if (locked.schedule(type) != lockfree.schedule(type)) return false;
+            if (locked.next_version() != lockfree.next_version()) return false;
+        }
+        return true;
+    }
+
+    struct ScheduleThread : public Thread {
+        SchedulerVersion<OpDefault> &s;
+        std::vector<OpDefault::version_type> versions;
+        ScheduleThread(SchedulerVersion<OpDefault> &s_) : s(s_) {}
+        void run() {
+            for (size_t i = 0; i < 10000; ++i) {
+                versions.push_back(s.schedule(ReadWriteAdd::write));
+                s.schedule(ReadWriteAdd::read);
+                s.schedule(ReadWriteAdd::add);
+            }
+        }
+    };
+
+    // each write gets its own version when scheduled from several threads
+    static bool testConcurrent(std::string &name) { name = "testConcurrent";
+        const size_t num_threads = 4;
+        SchedulerVersion<OpDefault> s;
+        ScheduleThread *threads[num_threads];
+        for (size_t i = 0; i < num_threads; ++i) {
+            threads[i] = new ScheduleThread(s);
+            threads[i]->start();
+        }
+        std::vector<size_t> count(3*10000*num_threads+1);
+        bool success = true;
+        for (size_t i = 0; i < num_threads; ++i) {
+            threads[i]->join();
+            for (size_t j = 0; j < threads[i]->versions.size(); ++j) {
+                const OpDefault::version_type v(threads[i]->versions[j]);
+                if (v >= count.size() || ++count[v] != 1)
+                    success = false;
+            }
+            delete threads[i];
+        }
+        return success && s.next_version() <= 3*10000*num_threads+1;
+    }
+
     static bool testAccessUtil(std::string &name) { name = "testAccessUtil";
         if (AccessUtil<OpDefault>::needs_lock(ReadWriteAdd::read)) return false;
         if (!AccessUtil<OpDefault>::needs_lock(ReadWriteAdd::add)) return false;
@@ -86,7 +138,7 @@ public:
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-            testSchedVer, testAccessUtil
+            testSchedVer, testAccessUtil, testLockFree, testConcurrent
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
@@ -0,0 +1,63 @@
+#ifndef SG_TEST_STEALORDER_HPP_INCLUDED
+#define SG_TEST_STEALORDER_HPP_INCLUDED
+
+#include "sg/option/stealorder_half.hpp"
+#include "sg/option/stealorder_topology.hpp"
+#include "sg/option/taskqueue_chaselev.hpp"
+
+#include <string>
+
+class TestStealOrder : public TestCase {
+    struct OpStealHalf : public DefaultOptions<OpStealHalf> {
+        typedef StealHalfOrder<OpStealHalf> StealOrder;
+    };
+    struct OpStealHalfChaseLev : public DefaultOptions<OpStealHalfChaseLev> {
+        typedef StealHalfOrder<OpStealHalfChaseLev, 4> StealOrder;
+        typedef TaskQueueChaseLev<OpStealHalfChaseLev> ReadyListType;
+    };
+    struct OpStealTopology : public DefaultOptions<OpStealTopology> {
+        typedef TopologyStealOrder<OpStealTopology> StealOrder;
+    };
+
+    static const char *get_name(OpStealHalf) { return "testStealHalf"; }
+    static const char *get_name(OpStealHalfChaseLev) { return "testStealHalfChaseLev"; }
+    static const char *get_name(OpStealTopology) { return "testStealTopology"; }
+
+    template<typename Op>
+    class MyTask : public Task<Op, 0> {
+    private:
+        size_t *value;
+
+    public:
+        MyTask(size_t *value_) : value(value_) {}
+        void run() { Atomic::increase(value); }
+    };
+
+    template<typename Op>
+    static bool testSteal(std::string &name) { name = get_name(Op());
+        SuperGlue<Op> sg;
+        size_t value = 0;
+
+        // put all tasks in one queue, to make the others steal
+        for (size_t i = 0; i < 10000; ++i)
+            sg.submit(new MyTask<Op>(&value), 0);
+        sg.barrier();
+
+        return value == 10000;
+    }
+
+public:
+
+    std::string get_name() { return "TestStealOrder"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testSteal<OpStealHalf>, testSteal<OpStealHalfChaseLev>,
+            testSteal<OpStealTopology>
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_STEALORDER_HPP_INCLUDED
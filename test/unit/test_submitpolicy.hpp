@@ -0,0 +1,114 @@
+#ifndef SG_TEST_SUBMITPOLICY_HPP_INCLUDED
+#define SG_TEST_SUBMITPOLICY_HPP_INCLUDED
+
+#include "sg/option/submit_policy.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+
+class TestSubmitPolicy : public TestCase {
+    struct OpRoundRobin : public DefaultOptions<OpRoundRobin> {
+        typedef AllowedCpusThreadAffinity<OpRoundRobin> ThreadAffinity;
+    };
+    struct OpThreadLocal : public DefaultOptions<OpThreadLocal> {
+        typedef SubmitRoundRobinThreadLocal<OpThreadLocal> SubmitPolicy;
+        typedef AllowedCpusThreadAffinity<OpThreadLocal> ThreadAffinity;
+    };
+    struct OpLocal : public DefaultOptions<OpLocal> {
+        typedef SubmitLocal<OpLocal> SubmitPolicy;
+        typedef AllowedCpusThreadAffinity<OpLocal> ThreadAffinity;
+        typedef Enable PassTaskExecutor;
+    };
+    struct OpLeastLoaded : public DefaultOptions<OpLeastLoaded> {
+        typedef SubmitLeastLoaded<OpLeastLoaded> SubmitPolicy;
+        typedef AllowedCpusThreadAffinity<OpLeastLoaded> ThreadAffinity;
+    };
+
+    static const char *get_name(OpRoundRobin) { return "testRecursiveRoundRobin"; }
+    static const char *get_name(OpThreadLocal) { return "testRecursiveThreadLocal"; }
+    static const char *get_name(OpLocal) { return "testRecursiveLocal"; }
+    static const char *get_name(OpLeastLoaded) { return "testRecursiveLeastLoaded"; }
+
+    // spawns a binary tree of tasks, and counts the leaves
+    template<typename Op>
+    class SpawnTask : public Task<Op, 0> {
+    private:
+        SuperGlue<Op> &sg;
+        size_t depth;
+        size_t *leaves;
+    public:
+        SpawnTask(SuperGlue<Op> &sg_, size_t depth_, size_t *leaves_)
+        : sg(sg_), depth(depth_), leaves(leaves_) {}
+        void spawn() {
+            if (depth == 0) {
+                Atomic::increase(leaves);
+                return;
+            }
+            sg.submit(new SpawnTask(sg, depth-1, leaves));
+            sg.submit(new SpawnTask(sg, depth-1, leaves));
+        }
+        void run() { spawn(); }
+        void run(TaskExecutor<Op> &) { spawn(); }
+    };
+
+    class LocalTask : public Task<OpLocal, 0> {
+    private:
+        SuperGlue<OpLocal> &sg;
+        bool *success;
+    public:
+        LocalTask(SuperGlue<OpLocal> &sg_, bool *success_) : sg(sg_), success(success_) {}
+        void run(TaskExecutor<OpLocal> &te) {
+            if (sg.submit_policy.select_queue(*sg.tman, this) != te.get_id())
+                *success = false;
+        }
+    };
+
+    template<typename Op>
+    static bool testRecursive(std::string &name) { name = get_name(Op());
+        SuperGlue<Op> sg(4);
+        size_t leaves = 0;
+        for (size_t round = 0; round < 5; ++round) {
+            sg.submit(new SpawnTask<Op>(sg, 10, &leaves));
+            sg.barrier();
+        }
+        return leaves == 5*1024;
+    }
+
+    static bool testLocal(std::string &name) { name = "testLocal";
+        SuperGlue<OpLocal> sg(4);
+        bool success = true;
+        for (size_t i = 0; i < 100; ++i)
+            sg.submit(new LocalTask(sg, &success));
+        sg.barrier();
+        return success;
+    }
+
+    static bool testLeastLoaded(std::string &name) { name = "testLeastLoaded";
+        SuperGlue<OpLeastLoaded> sg(4);
+        size_t leaves = 0;
+        for (size_t i = 0; i < 100; ++i)
+            sg.submit(new SpawnTask<OpLeastLoaded>(sg, 2, &leaves));
+        sg.barrier();
+        bool success = (leaves == 400);
+        // all submitted tasks have started
+        for (int i = 0; i < sg.get_num_cpus(); ++i)
+            success &= (sg.tman->get_worker(i)->submit_state.load == 0);
+        return success;
+    }
+
+public:
+
+    std::string get_name() { return "TestSubmitPolicy"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testRecursive<OpRoundRobin>, testRecursive<OpThreadLocal>,
+            testRecursive<OpLocal>, testRecursive<OpLeastLoaded>,
+            testLocal, testLeastLoaded
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_SUBMITPOLICY_HPP_INCLUDED
@@ -0,0 +1,152 @@
+#ifndef SG_TEST_TASKALLOC_HPP_INCLUDED
+#define SG_TEST_TASKALLOC_HPP_INCLUDED
+
+#include "sg/option/taskalloc_slab.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/threads.hpp"
+
+#include <string>
+#include <vector>
+
+class TestTaskAlloc : public TestCase {
+    struct OpSlab : public DefaultOptions<OpSlab> {
+        typedef TaskAllocSlab<OpSlab> TaskAllocator;
+        typedef AllowedCpusThreadAffinity<OpSlab> ThreadAffinity;
+    };
+    struct OpSlabNoStealing : public DefaultOptions<OpSlabNoStealing> {
+        typedef TaskAllocSlab<OpSlabNoStealing> TaskAllocator;
+        typedef Disable Stealing;
+        typedef AllowedCpusThreadAffinity<OpSlabNoStealing> ThreadAffinity;
+    };
+    typedef TaskAllocSlab<OpSlab> Alloc;
+
+    template<typename Op>
+    class AddTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+    public:
+        AddTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { *value += 1; }
+    };
+
+    // submits an AddTask from the worker that runs it
+    class SpawnTask : public Task<OpSlabNoStealing> {
+    private:
+        SuperGlue<OpSlabNoStealing> &sg;
+        Handle<OpSlabNoStealing> &h;
+        size_t *value;
+    public:
+        SpawnTask(SuperGlue<OpSlabNoStealing> &sg_, Handle<OpSlabNoStealing> &h_, size_t *value_)
+          : sg(sg_), h(h_), value(value_) {}
+        void run() { sg.submit(new AddTask<OpSlabNoStealing>(h, value)); }
+    };
+
+    struct FreeThread : public Thread {
+        std::vector<void *> &blocks;
+        FreeThread(std::vector<void *> &blocks_) : blocks(blocks_) {}
+        void run() {
+            for (size_t i = 0; i < blocks.size(); ++i)
+                Alloc::deallocate(blocks[i]);
+            Alloc::release_thread();
+        }
+    };
+
+    static bool testLocalReuse(std::string &name) { name = "testLocalReuse";
+        void *p = Alloc::allocate(100);
+        Alloc::deallocate(p);
+        void *q = Alloc::allocate(100);
+        bool success = (p == q);
+
+        // different size classes, and a size larger than any class
+        void *small = Alloc::allocate(1);
+        void *large = Alloc::allocate(5000);
+        success &= (small != q && large != q && large != small);
+        Alloc::deallocate(small);
+        Alloc::deallocate(large);
+        Alloc::deallocate(q);
+        return success;
+    }
+
+    static bool testRemoteFree(std::string &name) { name = "testRemoteFree";
+        const size_t n = 1000;
+        std::vector<void *> blocks(n);
+        for (size_t i = 0; i < n; ++i)
+            blocks[i] = Alloc::allocate(200);
+
+        // free all blocks from another thread
+        FreeThread *t = new FreeThread(blocks);
+        t->start();
+        t->join();
+        delete t;
+
+        // the blocks must be returned to this thread and reused, after the
+        // blocks that were left in this thread's free list
+        std::vector<void *> again(n);
+        size_t reused = 0;
+        for (size_t i = 0; i < n; ++i) {
+            again[i] = Alloc::allocate(200);
+            for (size_t j = 0; j < n; ++j) {
+                if (again[i] == blocks[j]) {
+                    ++reused;
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < n; ++i)
+            Alloc::deallocate(again[i]);
+        return reused >= n - Alloc::SLAB_SIZE / 256;
+    }
+
+    static bool testTasks(std::string &name) { name = "testTasks";
+        SuperGlue<OpSlab> sg(4);
+        Handle<OpSlab> h[8];
+        size_t values[8] = {0};
+        for (size_t i = 0; i < 10000; ++i)
+            sg.submit(new AddTask<OpSlab>(h[i % 8], &values[i % 8]));
+        sg.barrier();
+        for (size_t i = 0; i < 8; ++i)
+            if (values[i] != 1250)
+                return false;
+        return true;
+    }
+
+    // threads release their slabs when the runtime is destroyed, so
+    // creating runtimes over and over does not use more memory
+    static bool testRepeatedRuntimes(std::string &name) { name = "testRepeatedRuntimes";
+        typedef TaskAllocSlab<OpSlabNoStealing> AllocNoStealing;
+        size_t first_slabs = 0;
+        bool success = true;
+        for (size_t round = 0; round < 20; ++round) {
+            {
+                // without stealing, the workers allocate and free tasks too
+                SuperGlue<OpSlabNoStealing> sg(4);
+                Handle<OpSlabNoStealing> h[8];
+                size_t values[8] = {0};
+                for (size_t i = 0; i < 2000; ++i)
+                    sg.submit(new SpawnTask(sg, h[i % 8], &values[i % 8]), static_cast<int>(i % 4));
+                sg.barrier();
+                for (size_t i = 0; i < 8; ++i)
+                    success &= (values[i] == 250);
+            }
+            if (round == 0)
+                first_slabs = AllocNoStealing::get_num_slabs();
+            success &= (AllocNoStealing::get_num_slabs() <= first_slabs);
+        }
+        return success;
+    }
+
+public:
+    std::string get_name() { return "TestTaskAlloc"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testLocalReuse, testRemoteFree, testTasks, testRepeatedRuntimes
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TASKALLOC_HPP_INCLUDED
@@ -0,0 +1,203 @@
+#ifndef SG_TEST_TASKGRAPH_HPP_INCLUDED
+#define SG_TEST_TASKGRAPH_HPP_INCLUDED
+
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+
+class TestTaskGraph : public TestCase {
+    // lock-free scheduler versions
+    struct OpGraph : public DefaultOptions<OpGraph> {
+        typedef Enable TaskGraphs;
+        typedef AllowedCpusThreadAffinity<OpGraph> ThreadAffinity;
+    };
+    // scheduler versions with a lock
+    struct OpGraphLocked : public DefaultOptions<OpGraphLocked> {
+        typedef Enable TaskGraphs;
+        typedef unsigned long long version_type;
+        typedef AllowedCpusThreadAffinity<OpGraphLocked> ThreadAffinity;
+    };
+    struct OpGraphCounting : public DefaultOptions<OpGraphCounting> {
+        typedef Enable TaskGraphs;
+        typedef Enable DependencyCounting;
+        typedef AllowedCpusThreadAffinity<OpGraphCounting> ThreadAffinity;
+    };
+
+    static const char *get_name(OpGraph, const char *name) { return name; }
+    static std::string get_name(OpGraphLocked, const char *name) { return std::string(name) + "Locked"; }
+    static std::string get_name(OpGraphCounting, const char *name) { return std::string(name) + "Counting"; }
+
+    // x[out] = 2 x[out] + x[in]
+    template<typename Op>
+    class StepTask : public Task<Op, 2> {
+    private:
+        size_t *out, *in;
+    public:
+        StepTask(Handle<Op> &h_out, size_t *out_, Handle<Op> &h_in, size_t *in_) : out(out_), in(in_) {
+            this->register_access(ReadWriteAdd::write, h_out);
+            this->register_access(ReadWriteAdd::read, h_in);
+        }
+        void run() { *out = 2 * *out + *in; }
+    };
+
+    template<typename Op>
+    class AddTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+    public:
+        AddTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::add, h);
+        }
+        void run() { *value += 1; }
+    };
+
+    template<typename Op>
+    class ReadTask : public Task<Op, 1> {
+    private:
+        size_t *value, *result;
+    public:
+        ReadTask(Handle<Op> &h, size_t *value_, size_t *result_) : value(value_), result(result_) {
+            this->register_access(ReadWriteAdd::read, h);
+        }
+        void run() { *result = *value; }
+    };
+
+    template<typename Op>
+    class WriteTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+    public:
+        WriteTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { *value *= 3; }
+    };
+
+    enum { N = 8 };
+
+    // one step of the ring: each element is updated from the one before
+    template<typename Op>
+    static void submit_ring(SuperGlue<Op> &sg, Handle<Op> *h, size_t *x) {
+        for (size_t i = 0; i < N; ++i) {
+            const size_t prev((i + N - 1) % N);
+            sg.submit(new StepTask<Op>(h[i], &x[i], h[prev], &x[prev]));
+        }
+    }
+
+    static void ring_step(size_t *x) {
+        for (size_t i = 0; i < N; ++i)
+            x[i] = 2 * x[i] + x[(i + N - 1) % N];
+    }
+
+    // replays give the same results as submitting the tasks again
+    template<typename Op>
+    static bool testReplay(std::string &name) { name = get_name(Op(), "testReplay");
+        SuperGlue<Op> sg(4);
+        Handle<Op> h[N];
+        size_t x[N], expected[N];
+        for (size_t i = 0; i < N; ++i)
+            x[i] = expected[i] = i;
+
+        TaskGraph<Op> graph;
+        sg.begin_capture(graph);
+        submit_ring(sg, h, x);
+        sg.end_capture();
+
+        bool success = (graph.get_num_tasks() == N);
+        for (size_t step = 0; step < 20; ++step) {
+            sg.replay(graph);
+            sg.wait(graph);
+            ring_step(expected);
+            for (size_t i = 0; i < N; ++i)
+                success &= (x[i] == expected[i]);
+        }
+        return success;
+    }
+
+    // readers, commutative adds and writers on one handle
+    template<typename Op>
+    static bool testAccessTypes(std::string &name) { name = get_name(Op(), "testAccessTypes");
+        SuperGlue<Op> sg(4);
+        Handle<Op> h;
+        size_t value = 1;
+        size_t read[4];
+
+        TaskGraph<Op> graph;
+        sg.begin_capture(graph);
+        sg.submit(new ReadTask<Op>(h, &value, &read[0]));
+        sg.submit(new ReadTask<Op>(h, &value, &read[1]));
+        for (size_t i = 0; i < 10; ++i)
+            sg.submit(new AddTask<Op>(h, &value));
+        sg.submit(new ReadTask<Op>(h, &value, &read[2]));
+        sg.submit(new WriteTask<Op>(h, &value));
+        sg.submit(new ReadTask<Op>(h, &value, &read[3]));
+        sg.end_capture();
+
+        // 2 readers -> 10 adds -> reader -> writer -> reader
+        bool success = (graph.get_num_edges() == 2*10 + 10 + 1 + 1);
+        for (size_t step = 0; step < 20; ++step) {
+            const size_t before(value);
+            sg.replay(graph);
+            sg.wait(graph);
+            success &= (read[0] == before && read[1] == before);
+            success &= (read[2] == before + 10);
+            success &= (read[3] == (before + 10) * 3 && value == read[3]);
+        }
+        return success;
+    }
+
+    // other tasks use the handles between and after replays
+    template<typename Op>
+    static bool testMixed(std::string &name) { name = get_name(Op(), "testMixed");
+        SuperGlue<Op> sg(4);
+        Handle<Op> h[N];
+        size_t x[N], expected[N];
+        for (size_t i = 0; i < N; ++i)
+            x[i] = expected[i] = i;
+
+        TaskGraph<Op> graph;
+        sg.begin_capture(graph);
+        submit_ring(sg, h, x);
+        sg.end_capture();
+
+        bool success = true;
+        for (size_t step = 0; step < 10; ++step) {
+            sg.replay(graph);
+            // submitted during the replay, so they run after it
+            submit_ring(sg, h, x);
+            sg.barrier();
+            ring_step(expected);
+            ring_step(expected);
+            for (size_t i = 0; i < N; ++i)
+                success &= (x[i] == expected[i]);
+        }
+        submit_ring(sg, h, x);
+        for (size_t i = 0; i < N; ++i)
+            sg.wait(h[i]);
+        ring_step(expected);
+        for (size_t i = 0; i < N; ++i)
+            success &= (x[i] == expected[i]);
+        return success;
+    }
+
+public:
+
+    std::string get_name() { return "TestTaskGraph"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testReplay<OpGraph>,
+            testReplay<OpGraphLocked>,
+            testReplay<OpGraphCounting>,
+            testAccessTypes<OpGraph>,
+            testAccessTypes<OpGraphLocked>,
+            testMixed<OpGraph>,
+            testMixed<OpGraphLocked>,
+            testMixed<OpGraphCounting>
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TASKGRAPH_HPP_INCLUDED
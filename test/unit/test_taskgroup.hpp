@@ -0,0 +1,187 @@
+#ifndef SG_TEST_TASKGROUP_HPP_INCLUDED
+#define SG_TEST_TASKGROUP_HPP_INCLUDED
+
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/threads.hpp"
+
+#include <string>
+
+class TestTaskGroup : public TestCase {
+    struct OpGroups : public DefaultOptions<OpGroups> {
+        typedef Enable TaskGroups;
+        typedef AllowedCpusThreadAffinity<OpGroups> ThreadAffinity;
+    };
+    struct OpGroupsNoSteal : public DefaultOptions<OpGroupsNoSteal> {
+        typedef Enable TaskGroups;
+        typedef Disable Stealing;
+        typedef AllowedCpusThreadAffinity<OpGroupsNoSteal> ThreadAffinity;
+    };
+
+    template<typename Op>
+    class AddTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+    public:
+        AddTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { *value += 1; }
+    };
+
+    // writes a handle, but not until released
+    class GateTask : public Task<OpGroupsNoSteal, 1> {
+    private:
+        int *released;
+    public:
+        GateTask(Handle<OpGroupsNoSteal> &h, int *released_) : released(released_) {
+            register_access(ReadWriteAdd::write, h);
+        }
+        void run() {
+            while (*static_cast<volatile int *>(released) == 0)
+                Atomic::yield();
+        }
+    };
+
+    class ReadTask : public Task<OpGroupsNoSteal, 1> {
+    private:
+        int *count;
+    public:
+        ReadTask(Handle<OpGroupsNoSteal> &h, int *count_) : count(count_) {
+            register_access(ReadWriteAdd::read, h);
+        }
+        void run() { Atomic::increase(count); }
+    };
+
+    // waits for a group of subtasks from inside a task
+    class ParentTask : public Task<OpGroups> {
+    private:
+        SuperGlue<OpGroups> &sg;
+        size_t *value;
+        bool *success;
+    public:
+        ParentTask(SuperGlue<OpGroups> &sg_, size_t *value_, bool *success_)
+        : sg(sg_), value(value_), success(success_) {}
+        void run() {
+            const size_t num_children = 16;
+            Handle<OpGroups> h[num_children];
+            size_t child_value[num_children] = {0};
+            TaskGroup<OpGroups> group;
+            for (size_t i = 0; i < num_children; ++i)
+                sg.submit(new AddTask<OpGroups>(h[i], &child_value[i]), group);
+            sg.wait(group);
+            for (size_t i = 0; i < num_children; ++i) {
+                if (child_value[i] != 1)
+                    *success = false;
+                *value += child_value[i];
+            }
+        }
+    };
+
+    struct WaitThread : public Thread {
+        SuperGlue<OpGroups> &sg;
+        TaskGroup<OpGroups> &group;
+        size_t *value;
+        size_t num_tasks;
+        bool success;
+        WaitThread(SuperGlue<OpGroups> &sg_, TaskGroup<OpGroups> &group_, size_t *value_, size_t num_tasks_)
+        : sg(sg_), group(group_), value(value_), num_tasks(num_tasks_), success(false) {}
+        void run() {
+            sg.wait(group);
+            success = (*value == num_tasks);
+        }
+    };
+
+    // waiting for one group does not wait for the other
+    static bool testIndependent(std::string &name) { name = "testIndependent";
+        SuperGlue<OpGroupsNoSteal> sg(4);
+        Handle<OpGroupsNoSteal> gate;
+        Handle<OpGroupsNoSteal> h[3];
+        size_t value[3] = {0, 0, 0};
+        int released = 0;
+        int num_read = 0;
+        TaskGroup<OpGroupsNoSteal> group_a, group_b;
+
+        // the gate blocks worker 1, so the tasks of group a go to the others
+        sg.submit(new GateTask(gate, &released), 1);
+        for (int i = 0; i < 100; ++i)
+            sg.submit(new ReadTask(gate, &num_read), group_b);
+        for (int i = 0; i < 300; ++i) {
+            const int queue = (i % 3 == 0) ? 0 : (i % 3) + 1;
+            AddTask<OpGroupsNoSteal> *task = new AddTask<OpGroupsNoSteal>(h[i % 3], &value[i % 3]);
+            task->join_group(group_a);
+            sg.submit(task, queue);
+        }
+
+        sg.wait(group_a);
+        bool success = (value[0] == 100 && value[1] == 100 && value[2] == 100);
+        success &= !group_b.is_finished() && num_read == 0;
+
+        released = 1;
+        sg.wait(group_b);
+        success &= (num_read == 100);
+        return success;
+    }
+
+    static bool testWaitInTask(std::string &name) { name = "testWaitInTask";
+        SuperGlue<OpGroups> sg(4);
+        const size_t num_parents = 8;
+        size_t value[num_parents] = {0};
+        bool success = true;
+        TaskGroup<OpGroups> group;
+        for (size_t i = 0; i < num_parents; ++i)
+            sg.submit(new ParentTask(sg, &value[i], &success), group);
+        sg.wait(group);
+        for (size_t i = 0; i < num_parents; ++i)
+            success &= (value[i] == 16);
+        return success;
+    }
+
+    static bool testWaitOtherThread(std::string &name) { name = "testWaitOtherThread";
+        SuperGlue<OpGroups> sg(4);
+        Handle<OpGroups> h;
+        size_t value = 0;
+        const size_t num_tasks = 1000;
+        TaskGroup<OpGroups> group;
+        for (size_t i = 0; i < num_tasks; ++i)
+            sg.submit(new AddTask<OpGroups>(h, &value), group);
+
+        WaitThread thread(sg, group, &value, num_tasks);
+        thread.start();
+        thread.join();
+        sg.barrier();
+        return thread.success;
+    }
+
+    // a group can be reused after it has been waited for
+    static bool testReuse(std::string &name) { name = "testReuse";
+        SuperGlue<OpGroups> sg(4);
+        Handle<OpGroups> h;
+        size_t value = 0;
+        TaskGroup<OpGroups> group;
+        for (size_t round = 1; round <= 20; ++round) {
+            for (size_t i = 0; i < 50; ++i)
+                sg.submit(new AddTask<OpGroups>(h, &value), group);
+            sg.wait(group);
+            if (value != round * 50)
+                return false;
+        }
+        return true;
+    }
+
+public:
+
+    std::string get_name() { return "TestTaskGroup"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testIndependent,
+            testWaitInTask,
+            testWaitOtherThread,
+            testReuse
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TASKGROUP_HPP_INCLUDED
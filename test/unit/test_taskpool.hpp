@@ -0,0 +1,173 @@
+#ifndef SG_TEST_TASKPOOL_HPP_INCLUDED
+#define SG_TEST_TASKPOOL_HPP_INCLUDED
+
+#include "sg/option/threadaffinity_topology.hpp"
+
+#include <string>
+
+class TestTaskPool : public TestCase {
+    struct OpPool : public DefaultOptions<OpPool> {
+        typedef Enable TaskRecycling;
+        typedef Enable TaskGroups;
+        typedef AllowedCpusThreadAffinity<OpPool> ThreadAffinity;
+    };
+    struct OpPoolId : public DefaultOptions<OpPoolId> {
+        typedef Enable TaskRecycling;
+        typedef Enable TaskId;
+        typedef AllowedCpusThreadAffinity<OpPoolId> ThreadAffinity;
+    };
+
+    class EmptyTask : public Task<OpPoolId, 1> {
+    public:
+        void setup(Handle<OpPoolId> &h) { register_access(ReadWriteAdd::write, h); }
+        void run() {}
+    };
+
+    class AddTask : public Task<OpPool, 1> {
+    private:
+        size_t *value;
+    public:
+        void setup(Handle<OpPool> &h, size_t *value_) {
+            value = value_;
+            register_access(ReadWriteAdd::write, h);
+        }
+        void run() { *value += 1; }
+    };
+
+    // sums the values of its handles, which are added to with locks or read
+    class SumTask : public Task<OpPool> {
+    private:
+        size_t **values;
+        size_t num_values;
+        size_t *result;
+    public:
+        SumTask() : values(NULL), num_values(0), result(NULL) {}
+        void setup(Handle<OpPool> *h, size_t **values_, size_t num_values_, int type, size_t *result_) {
+            values = values_;
+            num_values = num_values_;
+            result = result_;
+            for (size_t i = 0; i < num_values; ++i)
+                register_access(static_cast<ReadWriteAdd::Type>(type), h[i]);
+        }
+        void run() {
+            size_t sum = 0;
+            for (size_t i = 0; i < num_values; ++i)
+                sum += *values[i];
+            Atomic::add_nv(result, sum);
+        }
+    };
+
+    // tasks are reused once the first step has finished
+    static bool testReuse(std::string &name) { name = "testReuse";
+        SuperGlue<OpPool> sg(4);
+        TaskPool<OpPool, AddTask> pool;
+        const size_t num_handles = 10;
+        Handle<OpPool> h[num_handles];
+        size_t value[num_handles] = {0};
+        bool success = true;
+        for (size_t step = 1; step <= 20; ++step) {
+            for (size_t i = 0; i < 5 * num_handles; ++i) {
+                AddTask *task = pool.get();
+                task->setup(h[i % num_handles], &value[i % num_handles]);
+                sg.submit(task);
+            }
+            sg.barrier();
+            for (size_t i = 0; i < num_handles; ++i)
+                success &= (value[i] == 5 * step);
+            success &= (pool.get_num_tasks() == 5 * num_handles);
+        }
+        return success;
+    }
+
+    // reused tasks register a different number and type of accesses
+    static bool testReset(std::string &name) { name = "testReset";
+        SuperGlue<OpPool> sg(4);
+        TaskPool<OpPool, SumTask> pool;
+        const size_t num_handles = 8; // more than TaskInlineAccesses
+        Handle<OpPool> h[num_handles];
+        size_t value[num_handles];
+        size_t *values[num_handles];
+        for (size_t i = 0; i < num_handles; ++i) {
+            value[i] = i;
+            values[i] = &value[i];
+        }
+        const int types[] = { ReadWriteAdd::add, ReadWriteAdd::read, ReadWriteAdd::write };
+        bool success = true;
+        for (size_t step = 0; step < 30; ++step) {
+            const size_t num_values(1 + step % num_handles);
+            size_t result = 0;
+            for (size_t i = 0; i < 10; ++i) {
+                SumTask *task = pool.get();
+                task->setup(h, values, num_values, types[(step + i) % 3], &result);
+                sg.submit(task);
+            }
+            sg.barrier();
+            success &= (result == 10 * num_values * (num_values - 1) / 2);
+        }
+        return success;
+    }
+
+    // a task that was in a group is not in it when reused
+    static bool testGroup(std::string &name) { name = "testGroup";
+        SuperGlue<OpPool> sg(4);
+        TaskPool<OpPool, AddTask> pool;
+        Handle<OpPool> h;
+        size_t value = 0;
+        TaskGroup<OpPool> group;
+        for (size_t i = 0; i < 10; ++i) {
+            AddTask *task = pool.get();
+            task->setup(h, &value);
+            sg.submit(task, group);
+        }
+        sg.wait(group);
+        sg.barrier();
+
+        TaskGroup<OpPool> other;
+        for (size_t i = 0; i < 10; ++i) {
+            AddTask *task = pool.get();
+            task->setup(h, &value);
+            if (i % 2 == 0)
+                sg.submit(task, other);
+            else
+                sg.submit(task);
+        }
+        sg.wait(other);
+        sg.barrier();
+        return value == 20 && group.is_finished() && pool.get_num_tasks() == 10;
+    }
+
+    // a recycled task gets a new id
+    static bool testGlobalId(std::string &name) { name = "testGlobalId";
+        SuperGlue<OpPoolId> sg(2);
+        TaskPool<OpPoolId, EmptyTask> pool;
+        Handle<OpPoolId> h;
+        EmptyTask *task = pool.get();
+        const OpPoolId::taskid_type first(task->get_global_id());
+        task->setup(h);
+        sg.submit(task);
+        sg.barrier();
+        EmptyTask *reused = pool.get();
+        const bool success = (reused == task && reused->get_global_id() != first);
+        reused->setup(h);
+        sg.submit(reused);
+        sg.barrier();
+        return success;
+    }
+
+public:
+
+    std::string get_name() { return "TestTaskPool"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testReuse,
+            testReset,
+            testGroup,
+            testGlobalId
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TASKPOOL_HPP_INCLUDED
@@ -16,13 +16,21 @@ class TestTaskQueue : public TestCase {
         return TaskQueueTest<OpDefault>::testTaskQueueImpl(name);
     }
 
+    static bool testPopBackHalf(std::string &name) {
+        return TaskQueueTest<OpDefault>::testPopBackHalfImpl(name);
+    }
+
+    static bool testPushBackList(std::string &name) {
+        return TaskQueueTest<OpDefault>::testPushBackListImpl(name);
+    }
+
 public:
 
     std::string get_name() { return "TestTaskQueue"; }
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-            testTaskQueue, testEraseIf
+            testTaskQueue, testEraseIf, testPopBackHalf, testPushBackList
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
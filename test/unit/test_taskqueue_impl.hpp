@@ -72,6 +72,58 @@ struct TaskQueueTest {
         return true;
     }
 
+    static bool testPopBackHalfImpl(std::string &testname) { testname = "testPopBackHalf";
+        TaskBase<Options> *task;
+        for (size_t n = 0; n < 10; ++n) {
+            typename Options::ReadyListType::unsafe_t q;
+            typename Options::ReadyListType::unsafe_t dest;
+            for (size_t i = 0; i < n; ++i)
+                q.push_back(new MyTask(std::string(1, (char) ('a' + i))));
+            dest.push_back(new MyTask("x"));
+
+            size_t expected = (n < 2) ? n : n / 2;
+            if (expected > 3)
+                expected = 3;
+            if (q.pop_back_half(dest, 3) != expected) return false;
+
+            for (size_t i = 0; i < n - expected; ++i)
+                if (!q.pop_front(task) || name(task) != std::string(1, (char) ('a' + i))) return false;
+            if (!q.empty()) return false;
+            for (size_t i = n - expected; i < n; ++i)
+                if (!dest.pop_front(task) || name(task) != std::string(1, (char) ('a' + i))) return false;
+            if (!dest.pop_front(task) || name(task) != "x") return false;
+            if (!dest.empty()) return false;
+        }
+        return true;
+    }
+
+    static bool testPushBackListImpl(std::string &testname) { testname = "testPushBackList";
+        typename Options::ReadyListType q;
+        typename Options::ReadyListType::unsafe_t list;
+        TaskBase<Options> *task;
+
+        // empty list
+        q.push_back_list(list);
+        if (!q.empty()) return false;
+
+        list.push_back(new MyTask("A"));
+        list.push_back(new MyTask("B"));
+        q.push_back_list(list);
+        if (!list.empty()) return false;
+
+        q.push_back(new MyTask("C"));
+        list.push_back(new MyTask("D"));
+        list.push_back(new MyTask("E"));
+        q.push_back_list(list);
+
+        const char *expected[] = { "A", "B", "C", "D", "E" };
+        for (size_t i = 0; i < 5; ++i) {
+            if (!q.pop_front(task) || name(task) != expected[i]) return false;
+            delete task;
+        }
+        return q.empty();
+    }
+
     static bool testEraseIfImpl(std::string &testname) { testname = "testEraseIf";
         TaskBase<Options> *task;
         {
@@ -0,0 +1,137 @@
+#ifndef SG_TEST_TASKQUEUEBUCKETS_HPP_INCLUDED
+#define SG_TEST_TASKQUEUEBUCKETS_HPP_INCLUDED
+
+#include "sg/option/taskqueue_buckets.hpp"
+#include "sg/option/stealorder_half.hpp"
+
+#include <string>
+
+class TestTaskQueueBuckets : public TestCase {
+    struct OpBuckets : public DefaultOptions<OpBuckets> {
+        typedef TaskQueueBuckets<OpBuckets, 8> ReadyListType;
+        typedef StealHalfOrder<OpBuckets> StealOrder;
+    };
+    typedef OpBuckets::ReadyListType TaskQueue;
+
+    struct PrioTask : public Task<OpBuckets, 0> {
+        int number;
+        PrioTask(int priority_, int number_) : number(number_) { priority = priority_; }
+        void run() {}
+    };
+
+    struct CountTask : public Task<OpBuckets, 1> {
+        size_t *value;
+        CountTask(Handle<OpBuckets> &h, size_t *value_, int priority_) : value(value_) {
+            priority = priority_;
+            register_access(ReadWriteAdd::write, h);
+        }
+        void run() { ++*value; }
+    };
+
+    static int number(TaskBase<OpBuckets> *task) {
+        return static_cast<PrioTask *>(task)->number;
+    }
+
+    // pushes tasks with priorities both inside and outside the bucket range
+    static void fill(TaskQueue &q) {
+        q.push_back(new PrioTask(3, 3));
+        q.push_back(new PrioTask(-5, -5));
+        q.push_back(new PrioTask(100, 100));
+        q.push_back(new PrioTask(0, 0));
+        q.push_back(new PrioTask(7, 7));
+        q.push_back(new PrioTask(-1, -1));
+        q.push_back(new PrioTask(8, 8));
+        q.push_back(new PrioTask(3, 4));
+    }
+
+    static bool testOrder(std::string &name) { name = "testOrder";
+        const int front_order[] = {100, 8, 7, 3, 4, 0, -1, -5};
+        const int back_order[] = {100, 8, 7, 4, 3, 0, -1, -5};
+        TaskQueue q;
+        TaskBase<OpBuckets> *task;
+        bool success = true;
+
+        if (!q.empty()) return false;
+        fill(q);
+        // same priority: pop_front takes the front
+        q.push_front(new PrioTask(3, 2));
+        if (!q.pop_front(task)) return false;
+        success &= number(task) == 100;
+        delete task;
+        if (!q.pop_front(task)) return false;
+        success &= number(task) == 8;
+        delete task;
+        if (!q.pop_front(task)) return false;
+        success &= number(task) == 7;
+        delete task;
+        if (!q.pop_front(task)) return false;
+        success &= number(task) == 2;
+        delete task;
+        for (size_t i = 3; i < 8; ++i) {
+            if (!q.pop_front(task)) return false;
+            success &= number(task) == front_order[i];
+            delete task;
+        }
+        if (!q.empty() || q.pop_front(task)) return false;
+
+        fill(q);
+        for (size_t i = 0; i < 8; ++i) {
+            if (!q.pop_back(task)) return false;
+            success &= number(task) == back_order[i];
+            delete task;
+        }
+        return success && q.empty() && !q.pop_back(task);
+    }
+
+    static bool testPopBackHalf(std::string &name) { name = "testPopBackHalf";
+        TaskQueue q;
+        TaskQueue::unsafe_t dest;
+        TaskBase<OpBuckets> *task;
+        bool success = true;
+
+        fill(q);
+        if (q.pop_back_half(dest, 100) != 4) return false;
+        const int stolen[] = {100, 8, 7, 4};
+        for (size_t i = 0; i < 4; ++i) {
+            if (!dest.pop_front(task)) return false;
+            success &= number(task) == stolen[i];
+            delete task;
+        }
+        if (q.pop_back_half(dest, 1) != 1) return false;
+        while (dest.pop_front(task))
+            delete task;
+        while (q.pop_front(task))
+            delete task;
+        return success && q.pop_back_half(dest, 10) == 0;
+    }
+
+    static bool testSuperGlue(std::string &name) { name = "testSuperGlue";
+        SuperGlue<OpBuckets> sg;
+        const size_t num_handles = 10;
+        Handle<OpBuckets> h[num_handles];
+        size_t value[num_handles] = {0};
+
+        for (size_t i = 0; i < 1000; ++i)
+            sg.submit(new CountTask(h[i % num_handles], &value[i % num_handles], static_cast<int>(i % 20) - 5));
+        sg.barrier();
+
+        for (size_t i = 0; i < num_handles; ++i)
+            if (value[i] != 1000/num_handles)
+                return false;
+        return true;
+    }
+
+public:
+
+    std::string get_name() { return "TestTaskQueueBuckets"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testOrder, testPopBackHalf, testSuperGlue
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TASKQUEUEBUCKETS_HPP_INCLUDED
@@ -0,0 +1,243 @@
+#ifndef SG_TEST_TASKQUEUECHASELEV_HPP_INCLUDED
+#define SG_TEST_TASKQUEUECHASELEV_HPP_INCLUDED
+
+#include "sg/option/taskqueue_chaselev.hpp"
+#include "sg/platform/threads.hpp"
+
+#include <string>
+#include <vector>
+
+class TestTaskQueueChaseLev : public TestCase {
+    struct OpChaseLev : public DefaultOptions<OpChaseLev> {
+        typedef TaskQueueChaseLev<OpChaseLev> ReadyListType;
+    };
+    typedef OpChaseLev::ReadyListType TaskQueue;
+
+    struct NumberedTask : public Task<OpChaseLev, 0> {
+        size_t number;
+        NumberedTask(size_t number_) : number(number_) {}
+        void run() {}
+    };
+
+    struct CountTask : public Task<OpChaseLev, 1> {
+        size_t *value;
+        CountTask(Handle<OpChaseLev> &h, size_t *value_) : value(value_) {
+            register_access(ReadWriteAdd::write, h);
+        }
+        void run() { ++*value; }
+    };
+
+    static size_t number(TaskBase<OpChaseLev> *task) {
+        return static_cast<NumberedTask *>(task)->number;
+    }
+
+    static bool testOrder(std::string &name) { name = "testOrder";
+        TaskQueue q;
+        TaskBase<OpChaseLev> *task;
+        bool success = true;
+
+        if (!q.empty()) return false;
+        q.push_back(new NumberedTask(1));
+        if (q.empty()) return false;
+        q.push_front(new NumberedTask(0));
+        q.push_back(new NumberedTask(2));
+        q.push_back(new NumberedTask(3));
+
+        for (size_t i = 0; i < 4; ++i) {
+            if (!q.pop_front(task)) return false;
+            success &= number(task) == i;
+            delete task;
+        }
+        if (!q.empty() || q.pop_front(task)) return false;
+
+        for (size_t i = 0; i < 4; ++i)
+            q.push_front(new NumberedTask(i));
+        for (size_t i = 0; i < 4; ++i) {
+            if (!q.pop_back(task)) return false;
+            success &= number(task) == i;
+            delete task;
+        }
+        if (!q.empty() || q.pop_back(task)) return false;
+
+        // push_front_list keeps the order of the list, and ends up in front
+        OpChaseLev::ReadyListType::unsafe_t list;
+        list.push_back(new NumberedTask(0));
+        list.push_back(new NumberedTask(1));
+        q.push_back(new NumberedTask(2));
+        q.push_front_list(list);
+        for (size_t i = 0; i < 3; ++i) {
+            if (!q.pop_front(task)) return false;
+            success &= number(task) == i;
+            delete task;
+        }
+        if (!q.empty()) return false;
+
+        // push_back_list keeps the order of the list, and ends up at the back
+        q.push_back(new NumberedTask(0));
+        list.push_back(new NumberedTask(1));
+        list.push_back(new NumberedTask(2));
+        q.push_back_list(list);
+        success &= list.empty();
+        for (size_t i = 0; i < 3; ++i) {
+            if (!q.pop_front(task)) return false;
+            success &= number(task) == i;
+            delete task;
+        }
+        return success && q.empty();
+    }
+
+    static bool testGrow(std::string &name) { name = "testGrow";
+        TaskQueue q;
+        TaskBase<OpChaseLev> *task;
+        const size_t n = 10000;
+        bool success = true;
+
+        for (size_t i = 0; i < n; ++i)
+            q.push_front(new NumberedTask(i));
+        for (size_t i = 0; i < n/2; ++i) {
+            if (!q.pop_back(task)) return false;
+            success &= number(task) == i;
+            delete task;
+        }
+        for (size_t i = n; i > n/2; --i) {
+            if (!q.pop_front(task)) return false;
+            success &= number(task) == i-1;
+            delete task;
+        }
+        return success && q.empty();
+    }
+
+    // owner pushes and pops while other threads steal. every task must be taken exactly once.
+    struct Thief : public Thread {
+        TaskQueue &q;
+        volatile bool &done;
+        std::vector<size_t> taken;
+        Thief(TaskQueue &q_, volatile bool &done_) : q(q_), done(done_) {}
+        void run() {
+            TaskBase<OpChaseLev> *task;
+            for (;;) {
+                const bool finished = done;
+                while (q.pop_back(task)) {
+                    taken.push_back(number(task));
+                    delete task;
+                }
+                if (finished)
+                    return;
+                Atomic::yield();
+            }
+        }
+    };
+
+    static bool testConcurrentSteal(std::string &name) { name = "testConcurrentSteal";
+        const size_t n = 100000;
+        const size_t num_thieves = 3;
+        TaskQueue q;
+        volatile bool done = false;
+        std::vector<size_t> count(n, 0);
+        TaskBase<OpChaseLev> *task;
+
+        std::vector<Thief *> thieves;
+        for (size_t i = 0; i < num_thieves; ++i) {
+            thieves.push_back(new Thief(q, done));
+            thieves[i]->start();
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (i % 3 == 0)
+                q.push_back(new NumberedTask(i));
+            else
+                q.push_front(new NumberedTask(i));
+            if (i % 2 == 0 && q.pop_front(task)) {
+                ++count[number(task)];
+                delete task;
+            }
+        }
+        while (q.pop_front(task)) {
+            ++count[number(task)];
+            delete task;
+        }
+        done = true;
+
+        for (size_t i = 0; i < num_thieves; ++i) {
+            thieves[i]->join();
+            for (size_t j = 0; j < thieves[i]->taken.size(); ++j)
+                ++count[thieves[i]->taken[j]];
+            delete thieves[i];
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            if (count[i] != 1)
+                return false;
+        return true;
+    }
+
+    // another thread pushes to the front. the owner takes those tasks first, newest first.
+    struct FrontPusher : public Thread {
+        TaskQueue &q;
+        FrontPusher(TaskQueue &q_) : q(q_) {}
+        void run() {
+            q.push_front(new NumberedTask(1));
+            q.push_front(new NumberedTask(0));
+        }
+    };
+
+    static bool testForeignPushFront(std::string &name) { name = "testForeignPushFront";
+        TaskQueue q;
+        TaskBase<OpChaseLev> *task;
+        bool success = true;
+
+        q.push_front(new NumberedTask(2));
+        q.push_back(new NumberedTask(3));
+        FrontPusher pusher(q);
+        pusher.start();
+        pusher.join();
+        if (q.empty()) return false;
+
+        for (size_t i = 0; i < 4; ++i) {
+            if (!q.pop_front(task)) return false;
+            success &= number(task) == i;
+            delete task;
+        }
+        if (!q.empty()) return false;
+
+        // thieves can take them before the owner does
+        FrontPusher other(q);
+        other.start();
+        other.join();
+        for (size_t i = 0; i < 2; ++i) {
+            if (!q.pop_back(task)) return false;
+            delete task;
+        }
+        return success && q.empty();
+    }
+
+    static bool testSuperGlue(std::string &name) { name = "testSuperGlue";
+        SuperGlue<OpChaseLev> sg;
+        const size_t num_handles = 10;
+        Handle<OpChaseLev> h[num_handles];
+        size_t value[num_handles] = {0};
+
+        for (size_t i = 0; i < 1000; ++i)
+            sg.submit(new CountTask(h[i % num_handles], &value[i % num_handles]));
+        sg.barrier();
+
+        for (size_t i = 0; i < num_handles; ++i)
+            if (value[i] != 1000/num_handles)
+                return false;
+        return true;
+    }
+
+public:
+
+    std::string get_name() { return "TestTaskQueueChaseLev"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testOrder, testGrow, testConcurrentSteal, testForeignPushFront, testSuperGlue
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TASKQUEUECHASELEV_HPP_INCLUDED
@@ -19,13 +19,17 @@ class TestTaskQueueDeque : public TestCase {
         return TaskQueueTest<OpDefault>::testTaskQueueImpl(name);
     }
 
+    static bool testPopBackHalf(std::string &name) {
+        return TaskQueueTest<OpDefault>::testPopBackHalfImpl(name);
+    }
+
 public:
 
     std::string get_name() { return "TestTaskQueueDeque"; }
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-            testTaskQueue, testEraseIf
+            testTaskQueue, testEraseIf, testPopBackHalf
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
@@ -89,13 +89,21 @@ class TestTaskQueuePrio : public TestCase {
         return true;
     }
 
+    static bool testPopBackHalf(std::string &name) {
+        return TaskQueueTest<OpDefault>::testPopBackHalfImpl(name);
+    }
+
+    static bool testPushBackList(std::string &name) {
+        return TaskQueueTest<OpDefault>::testPushBackListImpl(name);
+    }
+
 public:
 
     std::string get_name() { return "TestTaskQueuePrio"; }
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-            testTaskQueue, testEraseIf, testPrio
+            testTaskQueue, testEraseIf, testPopBackHalf, testPrio, testPushBackList
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
@@ -7,6 +7,7 @@
 #include "sg/platform/threadutil.hpp"
 
 #include <string>
+#include <vector>
 
 class TestTasks : public TestCase {
     struct OpDefault : public DefaultOptions<OpDefault> {};
@@ -152,13 +153,85 @@ class TestTasks : public TestCase {
         }
     }
 
+    // writes the first num handles, and checks that the tasks run in order
+    class VariableTask : public Task<OpDefault> {
+    private:
+        size_t *counters;
+        bool *success;
+        size_t order[8];
+        size_t num;
+    public:
+        VariableTask(Handle<OpDefault> *h, size_t *counters_, size_t *expected, bool *success_, size_t num_)
+         : counters(counters_), success(success_), num(num_) {
+            for (size_t i = 0; i < num; ++i) {
+                register_access(ReadWriteAdd::write, h[i]);
+                order[i] = expected[i]++;
+            }
+        }
+        void run() {
+            if (get_num_access() != num)
+                *success = false;
+            for (size_t i = 0; i < num; ++i) {
+                if (counters[i] != order[i])
+                    *success = false;
+                ++counters[i];
+            }
+        }
+    };
+
+    static bool testVariableAccess(std::string &name) { name = "testVariableAccess";
+        Handle<OpDefault> h[8];
+        size_t counters[8] = {0};
+        size_t expected[8] = {0};
+        bool success = true;
+        {
+            SuperGlue<OpDefault> sg;
+            // both fewer and more accesses than are stored inline
+            for (size_t i = 0; i < 1000; ++i)
+                sg.submit(new VariableTask(h, counters, expected, &success, 1 + (i*5) % 8));
+            sg.barrier();
+        }
+        for (size_t i = 0; i < 8; ++i)
+            success &= (counters[i] == expected[i]);
+        return success;
+    }
+
+    static bool testSubmitBatch(std::string &name) { name = "testSubmitBatch";
+        size_t value = 0;
+        bool success = true;
+        {
+            // dependent tasks, where only the first is ready at submit
+            SuperGlue<OpPaused> sg;
+            Handle<OpPaused> h;
+            std::vector<TaskBase<OpPaused> *> tasks;
+            for (size_t i = 0; i < 1000; ++i)
+                tasks.push_back(new DepTask(h, &value, &success, i));
+            sg.submit_batch(tasks.begin(), tasks.end());
+            sg.start_executing();
+            sg.barrier();
+        }
+
+        size_t count = 0;
+        {
+            // independent tasks
+            SuperGlue<OpDefault> sg;
+            MyTask *tasks[1000];
+            for (size_t i = 0; i < 1000; ++i)
+                tasks[i] = new MyTask(&count);
+            sg.submit_batch(tasks, tasks + 1000);
+            sg.submit_batch(tasks, tasks);
+            sg.barrier();
+        }
+        return success && value == 1000 && count == 1000;
+    }
+
 public:
 
     std::string get_name() { return "TestTasks"; }
 
     testfunction *get(size_t &numTests) {
         static testfunction tests[] = {
-                testBarrier, testStealing, testNoStealing, testDependent
+                testBarrier, testStealing, testNoStealing, testDependent, testSubmitBatch, testVariableAccess
         };
         numTests = sizeof(tests)/sizeof(testfunction);
         return tests;
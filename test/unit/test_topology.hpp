@@ -0,0 +1,195 @@
+#ifndef SG_TEST_TOPOLOGY_HPP_INCLUDED
+#define SG_TEST_TOPOLOGY_HPP_INCLUDED
+
+#include "sg/platform/topology.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/cpucount.hpp"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+class TestTopology : public TestCase {
+    struct OpCompact : public DefaultOptions<OpCompact> {
+        typedef CompactThreadAffinity<OpCompact> ThreadAffinity;
+    };
+    struct OpScatter : public DefaultOptions<OpScatter> {
+        typedef ScatterThreadAffinity<OpScatter> ThreadAffinity;
+    };
+
+    class MyTask : public Task<OpCompact, 0> {
+    private:
+        size_t *value;
+
+    public:
+        MyTask(size_t *value_) : value(value_) {}
+        void run() { Atomic::increase(value); }
+    };
+
+    // pins the calling thread to one allowed cpu, and restores its mask
+    struct PinnedThread {
+        affinity_cpu_set saved;
+        bool known;
+        PinnedThread() : known(ThreadAffinity::get_affinity(saved)) {
+            affinity_cpu_set cpu_set;
+            cpu_set.set(CpuTopology::get().get_allowed_cpus()[0]);
+            ThreadAffinity::set_affinity(cpu_set);
+        }
+        ~PinnedThread() {
+            if (known)
+                ThreadAffinity::set_affinity(saved);
+        }
+    };
+
+    // each placement order must use every allowed cpu exactly once
+    template<typename Placement>
+    static bool isPermutation(const CpuTopology &topology) {
+        std::vector<int> order;
+        Placement::get_order(topology, order);
+        std::sort(order.begin(), order.end());
+        return order == topology.get_allowed_cpus();
+    }
+
+    static bool testParse(std::string &name) { name = "testParse";
+        std::vector<int> list;
+        if (!CpuTopology::parse_cpulist("0-2,5,7-8\n", list))
+            return false;
+        const int expected[] = {0, 1, 2, 5, 7, 8};
+        if (list != std::vector<int>(expected, expected + 6))
+            return false;
+        return !CpuTopology::parse_cpulist("", list);
+    }
+
+    static bool testDistance(std::string &name) { name = "testDistance";
+        const CpuTopology &topology(CpuTopology::get());
+        const std::vector<int> &cpus(topology.get_online_cpus());
+        if (cpus.empty())
+            return false;
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            if (topology.distance(cpus[i], cpus[i]) != CpuTopology::SAME_CORE)
+                return false;
+            for (size_t j = 0; j < cpus.size(); ++j)
+                if (topology.distance(cpus[i], cpus[j]) != topology.distance(cpus[j], cpus[i]))
+                    return false;
+        }
+        return true;
+    }
+
+    static bool testPlacement(std::string &name) { name = "testPlacement";
+        const CpuTopology &topology(CpuTopology::get());
+        if (topology.get_allowed_cpus().empty())
+            return false;
+        if (!isPermutation<detail::PlaceAllowedCpus>(topology)
+            || !isPermutation<detail::PlaceCompact>(topology)
+            || !isPermutation<detail::PlaceScatter>(topology)
+            || !isPermutation<detail::PlacePhysicalCore>(topology))
+            return false;
+
+        // no two cpus on the same core before all cores are used
+        std::vector<int> order;
+        detail::PlacePhysicalCore::get_order(topology, order);
+        std::vector<int> cores;
+        for (size_t i = 0; i < order.size(); ++i) {
+            const int core = topology.get_cpu_info(order[i]).core;
+            if (std::find(cores.begin(), cores.end(), core) != cores.end())
+                break;
+            cores.push_back(core);
+        }
+        for (size_t i = cores.size(); i < order.size(); ++i)
+            if (std::find(cores.begin(), cores.end(), topology.get_cpu_info(order[i]).core) == cores.end())
+                return false;
+        return true;
+    }
+
+    // the allowed cpus are those of the process, not of the calling thread,
+    // which runtimes pin
+    static bool testAllowedPinned(std::string &name) { name = "testAllowedPinned";
+        const CpuTopology &topology(CpuTopology::get());
+        PinnedThread pin;
+        affinity_cpu_set mask;
+        if (!ProcessAffinity::get(mask))
+            return true;
+        std::vector<int> allowed;
+        const std::vector<int> &online(topology.get_online_cpus());
+        for (size_t i = 0; i < online.size(); ++i)
+            if (mask.is_set(online[i]))
+                allowed.push_back(online[i]);
+        return allowed == topology.get_allowed_cpus();
+    }
+
+    static bool testSuperGlue(std::string &name) { name = "testSuperGlue";
+        size_t value = 0;
+        {
+            SuperGlue<OpCompact> sg;
+            for (size_t i = 0; i < 1000; ++i)
+                sg.submit(new MyTask(&value));
+            sg.barrier();
+        }
+        // more workers than cpus wrap around
+        OpScatter::ThreadAffinity::init();
+        const int num = static_cast<int>(CpuTopology::get().get_allowed_cpus().size());
+        for (int i = 0; i < num; ++i)
+            if (OpScatter::ThreadAffinity::get_cpu(i) != OpScatter::ThreadAffinity::get_cpu(i + num))
+                return false;
+        return value == 1000;
+    }
+
+    static bool testCpuCount(std::string &name) { name = "testCpuCount";
+        const bool omp_set = atoi(sg_getenv("OMP_NUM_THREADS").c_str()) > 0;
+
+        CpuCountDecision requested(CpuCount::decide(3));
+        if (!omp_set && (requested.num_cpus != 3 || requested.reason != CpuCountDecision::REQUESTED))
+            return false;
+
+        CpuCountDecision d(CpuCount::decide(-1));
+        if (d.num_cpus < 1 || d.online < 1 || d.to_string().empty())
+            return false;
+        if (!omp_set) {
+            if (d.num_cpus > d.online)
+                return false;
+            if (d.affinity > 0 && d.num_cpus > d.affinity)
+                return false;
+            if (d.quota > 0 && d.num_cpus > d.quota + 1)
+                return false;
+        }
+
+        SuperGlue<OpCompact> sg;
+        return sg.tman->get_num_cpus_decision().num_cpus == sg.get_num_cpus();
+    }
+
+    // the affinity limit is that of the process, also after a runtime has
+    // pinned the main thread
+    static bool testCpuCountPinned(std::string &name) { name = "testCpuCountPinned";
+        const int affinity(CpuCount::decide(-1).affinity);
+        bool success;
+        {
+            PinnedThread pin;
+            success = (CpuCount::decide(-1).affinity == affinity);
+        }
+        int first, second;
+        {
+            SuperGlue<OpCompact> sg;
+            first = sg.get_num_cpus();
+        }
+        {
+            SuperGlue<OpCompact> sg;
+            second = sg.get_num_cpus();
+        }
+        return success && first == second;
+    }
+
+public:
+
+    std::string get_name() { return "TestTopology"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testParse, testDistance, testPlacement, testAllowedPinned, testSuperGlue,
+            testCpuCount, testCpuCountPinned
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_TOPOLOGY_HPP_INCLUDED
@@ -0,0 +1,288 @@
+#ifndef SG_TEST_WAIT_HPP_INCLUDED
+#define SG_TEST_WAIT_HPP_INCLUDED
+
+#include "sg/option/idle_parking.hpp"
+#include "sg/option/threadaffinity_topology.hpp"
+#include "sg/platform/threads.hpp"
+
+#include <string>
+
+class TestWait : public TestCase {
+    struct OpWait : public DefaultOptions<OpWait> {
+        typedef AllowedCpusThreadAffinity<OpWait> ThreadAffinity;
+    };
+    struct OpWaitParking : public DefaultOptions<OpWaitParking> {
+        typedef IdleParking<OpWaitParking, 10, 10> IdlePolicy;
+        typedef AllowedCpusThreadAffinity<OpWaitParking> ThreadAffinity;
+    };
+
+    struct OpWaitNoStealing : public DefaultOptions<OpWaitNoStealing> {
+        typedef Disable Stealing;
+        typedef AllowedCpusThreadAffinity<OpWaitNoStealing> ThreadAffinity;
+    };
+
+    static const char *get_name(OpWait, const char *name) { return name; }
+    static std::string get_name(OpWaitParking, const char *name) { return std::string(name) + "Parking"; }
+
+    template<typename Op>
+    class AddTask : public Task<Op, 1> {
+    private:
+        size_t *value;
+    public:
+        AddTask(Handle<Op> &h, size_t *value_) : value(value_) {
+            this->register_access(ReadWriteAdd::write, h);
+        }
+        void run() { *value += 1; }
+    };
+
+    // writes a handle, but not until released
+    class GateTask : public Task<OpWait, 1> {
+    private:
+        int *released;
+    public:
+        GateTask(Handle<OpWait> &h, int *released_) : released(released_) {
+            register_access(ReadWriteAdd::write, h);
+        }
+        void run() {
+            while (*static_cast<volatile int *>(released) == 0)
+                Atomic::yield();
+        }
+    };
+
+    // waits for a handle from inside a task
+    class ParentTask : public Task<OpWait> {
+    private:
+        SuperGlue<OpWait> &sg;
+        size_t *value;
+    public:
+        ParentTask(SuperGlue<OpWait> &sg_, size_t *value_) : sg(sg_), value(value_) {}
+        void run() {
+            Handle<OpWait> h;
+            size_t child_value = 0;
+            for (size_t i = 0; i < 16; ++i)
+                sg.submit(new AddTask<OpWait>(h, &child_value));
+            sg.wait(h);
+            *value = child_value;
+        }
+    };
+
+    template<typename Op>
+    struct WaitHandleThread : public Thread {
+        SuperGlue<Op> &sg;
+        Handle<Op> &h;
+        size_t *value;
+        size_t num_tasks;
+        bool success;
+        WaitHandleThread(SuperGlue<Op> &sg_, Handle<Op> &h_, size_t *value_, size_t num_tasks_)
+        : sg(sg_), h(h_), value(value_), num_tasks(num_tasks_), success(false) {}
+        void run() {
+            sg.wait(h);
+            success = (*value == num_tasks);
+        }
+    };
+
+    // submits tasks and runs a barrier
+    template<typename Op>
+    struct BarrierThread : public Thread {
+        SuperGlue<Op> &sg;
+        Handle<Op> h;
+        size_t value;
+        bool success;
+        BarrierThread(SuperGlue<Op> &sg_) : sg(sg_), value(0), success(true) {}
+        void run() {
+            for (size_t round = 1; round <= 10; ++round) {
+                for (size_t i = 0; i < 20; ++i)
+                    sg.submit(new AddTask<Op>(h, &value));
+                sg.barrier();
+                if (value != round * 20)
+                    success = false;
+            }
+        }
+    };
+
+    // a thread outside the runtime waits for a handle
+    template<typename Op>
+    static bool testHandleOtherThread(std::string &name) { name = get_name(Op(), "testHandleOtherThread");
+        SuperGlue<Op> sg(4);
+        Handle<Op> h;
+        size_t value = 0;
+        const size_t num_tasks = 1000;
+        for (size_t i = 0; i < num_tasks; ++i)
+            sg.submit(new AddTask<Op>(h, &value));
+
+        WaitHandleThread<Op> thread(sg, h, &value, num_tasks);
+        thread.start();
+        thread.join();
+        sg.barrier();
+        return thread.success;
+    }
+
+    // waiting for a version does not wait for tasks submitted after it
+    static bool testVersion(std::string &name) { name = "testVersion";
+        SuperGlue<OpWait> sg(4);
+        Handle<OpWait> h;
+        size_t value = 0;
+        int released = 0;
+        for (size_t i = 0; i < 100; ++i)
+            sg.submit(new AddTask<OpWait>(h, &value));
+        const OpWait::version_type version(h.next_version()-1);
+        sg.submit(new GateTask(h, &released));
+
+        sg.wait(h, version);
+        bool success = (value == 100);
+        success &= (h.get_current_version() == version);
+
+        released = 1;
+        sg.wait(h);
+        success &= (h.get_current_version() == version + 1);
+        return success;
+    }
+
+    // workers help run tasks while waiting inside a task
+    static bool testWaitInTask(std::string &name) { name = "testWaitInTask";
+        SuperGlue<OpWait> sg(4);
+        const size_t num_parents = 8;
+        size_t value[num_parents] = {0};
+        for (size_t i = 0; i < num_parents; ++i)
+            sg.submit(new ParentTask(sg, &value[i]));
+        sg.barrier();
+        for (size_t i = 0; i < num_parents; ++i)
+            if (value[i] != 16)
+                return false;
+        return true;
+    }
+
+    // barriers from several threads at once, inside and outside the runtime
+    template<typename Op>
+    static bool testBarrierOtherThreads(std::string &name) { name = get_name(Op(), "testBarrierOtherThreads");
+        SuperGlue<Op> sg(4);
+        BarrierThread<Op> thread_a(sg), thread_b(sg);
+        thread_a.start();
+        thread_b.start();
+
+        Handle<Op> h;
+        size_t value = 0;
+        bool success = true;
+        for (size_t round = 1; round <= 10; ++round) {
+            for (size_t i = 0; i < 20; ++i)
+                sg.submit(new AddTask<Op>(h, &value));
+            sg.barrier();
+            success &= (value == round * 20);
+        }
+        thread_a.join();
+        thread_b.join();
+        return success && thread_a.success && thread_b.success;
+    }
+
+    template<typename Op>
+    struct BarrierOnceThread : public Thread {
+        SuperGlue<Op> &sg;
+        size_t *value;
+        size_t num_tasks;
+        int started;
+        bool success;
+        BarrierOnceThread(SuperGlue<Op> &sg_, size_t *value_, size_t num_tasks_)
+        : sg(sg_), value(value_), num_tasks(num_tasks_), started(0), success(false) {}
+        void run() {
+            started = 1;
+            sg.barrier();
+            success = (*value == num_tasks);
+        }
+    };
+
+    // without stealing, a barrier from another thread sleeps until the main
+    // thread has run the tasks in its queue
+    static bool testBarrierNoStealing(std::string &name) { name = "testBarrierNoStealing";
+        SuperGlue<OpWaitNoStealing> sg(2);
+        Handle<OpWaitNoStealing> h;
+        size_t value = 0;
+        const size_t num_tasks = 100;
+        for (size_t i = 0; i < num_tasks; ++i)
+            sg.submit(new AddTask<OpWaitNoStealing>(h, &value), static_cast<int>(i % 2));
+
+        BarrierOnceThread<OpWaitNoStealing> thread(sg, &value, num_tasks);
+        thread.start();
+        while (*static_cast<volatile int *>(&thread.started) == 0)
+            Atomic::yield();
+        for (size_t i = 0; i < 100; ++i)
+            Atomic::yield();
+        sg.barrier();
+        thread.join();
+        return thread.success && value == num_tasks;
+    }
+
+    // a runtime created and destroyed inside another does not hide the
+    // main thread of the outer one. with one thread, only the main thread
+    // can run the tasks.
+    static bool testNested(std::string &name) { name = "testNested";
+        SuperGlue<OpWait> outer(1);
+        bool success = true;
+        {
+            SuperGlue<OpWait> inner(1);
+            Handle<OpWait> h;
+            size_t value = 0;
+            for (size_t i = 0; i < 100; ++i)
+                inner.submit(new AddTask<OpWait>(h, &value));
+            inner.barrier();
+            success &= (value == 100);
+        }
+        Handle<OpWait> h;
+        size_t value = 0;
+        for (size_t i = 0; i < 100; ++i)
+            outer.submit(new AddTask<OpWait>(h, &value));
+        outer.barrier();
+        success &= (value == 100);
+        for (size_t i = 0; i < 100; ++i)
+            outer.submit(new AddTask<OpWait>(h, &value));
+        outer.wait(h);
+        return success && value == 200;
+    }
+
+    // without workers, threads outside the runtime run the tasks they wait
+    // for, taking turns with the main thread. tasks that wait inside run too.
+    static bool testSingleThread(std::string &name) { name = "testSingleThread";
+        SuperGlue<OpWait> sg(1);
+        Handle<OpWait> h;
+        size_t value = 0;
+        const size_t num_tasks = 1000;
+        for (size_t i = 0; i < num_tasks; ++i)
+            sg.submit(new AddTask<OpWait>(h, &value));
+        WaitHandleThread<OpWait> waiter(sg, h, &value, num_tasks);
+        waiter.start();
+        waiter.join();
+        bool success = waiter.success;
+
+        BarrierThread<OpWait> thread(sg);
+        thread.start();
+        size_t parent_value[10] = {0};
+        for (size_t i = 0; i < 10; ++i) {
+            sg.submit(new ParentTask(sg, &parent_value[i]));
+            sg.barrier();
+            success &= (parent_value[i] == 16);
+        }
+        thread.join();
+        return success && thread.success;
+    }
+
+public:
+
+    std::string get_name() { return "TestWait"; }
+
+    testfunction *get(size_t &numTests) {
+        static testfunction tests[] = {
+            testHandleOtherThread<OpWait>,
+            testHandleOtherThread<OpWaitParking>,
+            testVersion,
+            testWaitInTask,
+            testBarrierOtherThreads<OpWait>,
+            testBarrierOtherThreads<OpWaitParking>,
+            testBarrierNoStealing,
+            testNested,
+            testSingleThread
+        };
+        numTests = sizeof(tests)/sizeof(testfunction);
+        return tests;
+    }
+};
+
+#endif // SG_TEST_WAIT_HPP_INCLUDED